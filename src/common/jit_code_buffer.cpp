@@ -8,6 +8,7 @@ Log_SetChannel(JitCodeBuffer);
 
 #if defined(_WIN32)
 #include "windows_headers.h"
+#include <intrin.h>
 #else
 #include <errno.h>
 #include <sys/mman.h>
@@ -194,6 +195,8 @@ void JitCodeBuffer::Destroy()
   m_free_code_ptr = nullptr;
   m_code_size = 0;
   m_code_reserve_size = 0;
+  m_region_count = 0;
+  m_current_region = 0;
   m_code_used = 0;
   m_far_code_ptr = nullptr;
   m_free_far_code_ptr = nullptr;
@@ -225,7 +228,7 @@ void JitCodeBuffer::CommitCode(u32 length)
   FlushInstructionCache(m_free_code_ptr, length);
 #endif
 
-  Assert(length <= (m_code_size - m_code_used));
+  Assert(length <= GetFreeCodeSpace());
   m_free_code_ptr += length;
   m_code_used += length;
 }
@@ -240,7 +243,7 @@ void JitCodeBuffer::CommitFarCode(u32 length)
   FlushInstructionCache(m_free_far_code_ptr, length);
 #endif
 
-  Assert(length <= (m_far_code_size - m_far_code_used));
+  Assert(length <= GetFreeFarCodeSpace());
   m_free_far_code_ptr += length;
   m_far_code_used += length;
 }
@@ -249,7 +252,10 @@ void JitCodeBuffer::Reset()
 {
   WriteProtect(false);
 
-  m_free_code_ptr = m_code_ptr + m_guard_size + m_code_reserve_size;
+  m_region_count = 0;
+  m_current_region = 0;
+
+  m_free_code_ptr = GetCodeBase();
   m_code_used = 0;
   std::memset(m_free_code_ptr, 0, m_code_size);
   FlushInstructionCache(m_free_code_ptr, m_code_size);
@@ -265,6 +271,41 @@ void JitCodeBuffer::Reset()
   WriteProtect(true);
 }
 
+void JitCodeBuffer::CreateRegions(u32 count)
+{
+  Assert(count > 0 && m_region_count == 0);
+
+  m_region_count = count;
+  m_current_region = 0;
+  m_code_region_start = m_code_used;
+  m_code_region_size = (m_code_size - m_code_used) / count;
+  m_far_code_region_start = m_far_code_used;
+  m_far_code_region_size = (m_far_code_size - m_far_code_used) / count;
+}
+
+u32 JitCodeBuffer::AdvanceRegion()
+{
+  DebugAssert(m_region_count > 0);
+  m_current_region = (m_current_region + 1) % m_region_count;
+
+  m_code_used = m_code_region_start + (m_current_region * m_code_region_size);
+  m_free_code_ptr = GetCodeBase() + m_code_used;
+  m_far_code_used = m_far_code_region_start + (m_current_region * m_far_code_region_size);
+  m_free_far_code_ptr = m_far_code_ptr + m_far_code_used;
+  return m_current_region;
+}
+
+u8* JitCodeBuffer::GetRegionCodeStart(u32 region) const
+{
+  DebugAssert(region < m_region_count);
+  return GetCodeBase() + m_code_region_start + (region * m_code_region_size);
+}
+
+u8* JitCodeBuffer::GetRegionCodeEnd(u32 region) const
+{
+  return GetRegionCodeStart(region) + m_code_region_size;
+}
+
 void JitCodeBuffer::Align(u32 alignment, u8 padding_value)
 {
   DebugAssert(Common::IsPow2(alignment));
@@ -288,6 +329,19 @@ void JitCodeBuffer::FlushInstructionCache(void* address, u32 size)
 #endif
 }
 
+void JitCodeBuffer::SynchronizeInstructionFetch()
+{
+#if defined(CPU_AARCH32) || defined(CPU_AARCH64)
+#if defined(_MSC_VER) && defined(CPU_AARCH64)
+  __isb(_ARM64_BARRIER_SY);
+#elif defined(_MSC_VER)
+  __isb(_ARM_BARRIER_SY);
+#else
+  __asm__ volatile("isb" ::: "memory");
+#endif
+#endif
+}
+
 #if defined(__APPLE__) && defined(__aarch64__)
 
 void JitCodeBuffer::WriteProtect(bool enabled)
@@ -20,14 +20,29 @@ public:
   ALWAYS_INLINE u32 GetTotalSize() const { return m_total_size; }
 
   ALWAYS_INLINE u8* GetFreeCodePointer() const { return m_free_code_ptr; }
-  ALWAYS_INLINE u32 GetFreeCodeSpace() const { return static_cast<u32>(m_code_size - m_code_used); }
+  ALWAYS_INLINE u32 GetFreeCodeSpace() const { return static_cast<u32>(GetCodeLimit() - m_code_used); }
   void ReserveCode(u32 size);
   void CommitCode(u32 length);
 
   ALWAYS_INLINE u8* GetFreeFarCodePointer() const { return m_free_far_code_ptr; }
-  ALWAYS_INLINE u32 GetFreeFarCodeSpace() const { return static_cast<u32>(m_far_code_size - m_far_code_used); }
+  ALWAYS_INLINE u32 GetFreeFarCodeSpace() const { return static_cast<u32>(GetFarCodeLimit() - m_far_code_used); }
   void CommitFarCode(u32 length);
 
+  /// Splits the remaining near and far code space into equally-sized regions, which are filled in order.
+  /// Code committed before this call (e.g. dispatchers) is not part of any region. Cleared by Reset().
+  void CreateRegions(u32 count);
+
+  /// Moves allocation to the start of the next region, wrapping around to the first. Any code in that region should be
+  /// discarded by the caller first. Returns the new region index.
+  u32 AdvanceRegion();
+
+  ALWAYS_INLINE u32 GetRegionCount() const { return m_region_count; }
+  ALWAYS_INLINE u32 GetCurrentRegion() const { return m_current_region; }
+
+  /// Returns the start/end of near code for the specified region.
+  u8* GetRegionCodeStart(u32 region) const;
+  u8* GetRegionCodeEnd(u32 region) const;
+
   /// Adjusts the free code pointer to the specified alignment, padding with bytes.
   /// Assumes alignment is a power-of-two.
   void Align(u32 alignment, u8 padding_value);
@@ -35,6 +50,10 @@ public:
   /// Flushes the instruction cache on the host for the specified range.
   static void FlushInstructionCache(void* address, u32 size);
 
+  /// Discards instructions which the calling thread may have already fetched. Needed before executing code which was
+  /// written by another thread, on hosts where the instruction cache isn't coherent.
+  static void SynchronizeInstructionFetch();
+
   /// For Apple Silicon - Toggles write protection on the JIT space.
 #if defined(__APPLE__) && defined(__aarch64__)
   static void WriteProtect(bool enabled);
@@ -43,6 +62,17 @@ public:
 #endif
 
 private:
+  ALWAYS_INLINE u8* GetCodeBase() const { return m_code_ptr + m_guard_size + m_code_reserve_size; }
+  ALWAYS_INLINE u32 GetCodeLimit() const
+  {
+    return (m_region_count > 0) ? (m_code_region_start + (m_current_region + 1) * m_code_region_size) : m_code_size;
+  }
+  ALWAYS_INLINE u32 GetFarCodeLimit() const
+  {
+    return (m_region_count > 0) ? (m_far_code_region_start + (m_current_region + 1) * m_far_code_region_size) :
+                                  m_far_code_size;
+  }
+
   u8* m_code_ptr = nullptr;
   u8* m_free_code_ptr = nullptr;
   u32 m_code_size = 0;
@@ -54,6 +84,13 @@ private:
   u32 m_far_code_size = 0;
   u32 m_far_code_used = 0;
 
+  u32 m_region_count = 0;
+  u32 m_current_region = 0;
+  u32 m_code_region_start = 0;
+  u32 m_code_region_size = 0;
+  u32 m_far_code_region_start = 0;
+  u32 m_far_code_region_size = 0;
+
   u32 m_total_size = 0;
   u32 m_guard_size = 0;
   u32 m_old_protection = 0;
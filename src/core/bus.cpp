@@ -797,7 +797,7 @@ ALWAYS_INLINE static TickCount DoRAMAccess(u32 offset, u32& value)
         {
           g_ram[offset] = Truncate8(value);
           if (m_ram_code_bits[page_index])
-            CPU::CodeCache::InvalidateBlocksWithPageIndex(page_index);
+            CPU::CodeCache::InvalidateBlocksWithRange(offset, sizeof(u8));
         }
       }
       else if constexpr (size == MemoryAccessSize::HalfWord)
@@ -809,7 +809,7 @@ ALWAYS_INLINE static TickCount DoRAMAccess(u32 offset, u32& value)
         {
           std::memcpy(&g_ram[offset], &new_value, sizeof(u16));
           if (m_ram_code_bits[page_index])
-            CPU::CodeCache::InvalidateBlocksWithPageIndex(page_index);
+            CPU::CodeCache::InvalidateBlocksWithRange(offset, sizeof(u16));
         }
       }
       else if constexpr (size == MemoryAccessSize::Word)
@@ -820,14 +820,14 @@ ALWAYS_INLINE static TickCount DoRAMAccess(u32 offset, u32& value)
         {
           std::memcpy(&g_ram[offset], &value, sizeof(u32));
           if (m_ram_code_bits[page_index])
-            CPU::CodeCache::InvalidateBlocksWithPageIndex(page_index);
+            CPU::CodeCache::InvalidateBlocksWithRange(offset, sizeof(u32));
         }
       }
     }
     else
     {
       if (m_ram_code_bits[page_index])
-        CPU::CodeCache::InvalidateBlocksWithPageIndex(page_index);
+        CPU::CodeCache::InvalidateBlocksWithRange(offset, UINT32_C(1) << static_cast<u32>(size));
 
       if constexpr (size == MemoryAccessSize::Byte)
       {
@@ -1,19 +1,38 @@
 #include "cpu_code_cache.h"
 #include "bus.h"
 #include "common/assert.h"
+#include "common/file_system.h"
 #include "common/log.h"
+#include "common/string_util.h"
 #include "cpu_core.h"
 #include "cpu_core_private.h"
 #include "cpu_disasm.h"
+#include "gte.h"
+#include "host_interface.h"
 #include "settings.h"
 #include "system.h"
 #include "timing_event.h"
+#include "xxhash.h"
+#include <atomic>
+#include <cinttypes>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <thread>
 Log_SetChannel(CPU::CodeCache);
 
 #ifdef WITH_RECOMPILER
 #include "cpu_recompiler_code_generator.h"
 #endif
 
+#if defined(WITH_RECOMPILER) && defined(__linux__)
+#include <unistd.h>
+#endif
+
 namespace CPU::CodeCache {
 
 static constexpr bool USE_BLOCK_LINKING = true;
@@ -23,6 +42,10 @@ static constexpr u32 RECOMPILE_FRAMES_TO_FALL_BACK_TO_INTERPRETER = 100;
 static constexpr u32 RECOMPILE_COUNT_TO_FALL_BACK_TO_INTERPRETER = 20;
 static constexpr u32 INVALIDATE_THRESHOLD_TO_DISABLE_LINKING = 10;
 
+// Limits for following unconditional branches into a single block.
+static constexpr u32 MAX_TRACED_BRANCHES_PER_BLOCK = 8;
+static constexpr u32 MAX_TRACED_BLOCK_INSTRUCTIONS = 256;
+
 #ifdef WITH_RECOMPILER
 
 // Currently remapping the code buffer doesn't work in macOS or Haiku.
@@ -40,6 +63,10 @@ static constexpr u32 RECOMPILER_FAR_CODE_CACHE_SIZE = 16 * 1024 * 1024;
 #endif
 static constexpr u32 CODE_WRITE_FAULT_THRESHOLD_FOR_SLOWMEM = 10;
 
+// The code buffer is split into regions which are filled in order. When the current region is full, the blocks in the
+// next (oldest) region are evicted, rather than flushing the whole cache.
+static constexpr u32 RECOMPILER_CODE_REGION_COUNT = 4;
+
 #ifdef USE_STATIC_CODE_BUFFER
 static constexpr u32 RECOMPILER_GUARD_SIZE = 4096;
 alignas(Recompiler::CODE_STORAGE_ALIGNMENT) static u8
@@ -202,6 +229,7 @@ static CodeBlock* LookupBlock(CodeBlockKey key);
 static bool RevalidateBlock(CodeBlock* block);
 
 static bool CompileBlock(CodeBlock* block);
+static bool CanTraceBranch(const CodeBlock* block, const CodeBlockInstruction& cbi);
 static void RemoveReferencesToBlock(CodeBlock* block);
 static void AddBlockToPageMap(CodeBlock* block);
 static void RemoveBlockFromPageMap(CodeBlock* block);
@@ -214,15 +242,84 @@ static void UnlinkBlock(CodeBlock* block);
 
 static void ClearState();
 
+/// Idle loops only read memory and branch back to themselves, so they can skip straight to the next event.
+static bool IsIdleLoop(const CodeBlock* block);
+static void SkipIdleLoop();
+static void UpdateIdleLoopFrameStats();
+
+static IdleLoopStats s_idle_loop_stats = {};
+static TickCount s_idle_loop_frame_ticks = 0;
+
+static void InvalidateBlock(CodeBlock* block);
+static bool BlockOverlapsRange(const CodeBlock* block, PhysicalMemoryAddress start_address,
+                               PhysicalMemoryAddress end_address);
+
 static BlockMap s_blocks;
 static std::array<std::vector<CodeBlock*>, Bus::RAM_8MB_CODE_PAGE_COUNT> m_ram_block_map;
 
+// Number of blocks overlapping each subpage of RAM, so writes to data next to code can be ignored.
+static std::array<u32, Bus::RAM_8MB_CODE_PAGE_COUNT * (HOST_PAGE_SIZE / CODE_SUBPAGE_SIZE)> s_ram_code_subpage_counts;
+static SMCStats s_smc_stats = {};
+
 #ifdef WITH_RECOMPILER
 static HostCodeMap s_host_code_map;
 
 static void AddBlockToHostCodeMap(CodeBlock* block);
 static void RemoveBlockFromHostCodeMap(CodeBlock* block);
 
+/// Blocks which haven't been promoted yet run through the compile function, which profiles them.
+static CodeBlock::HostCodePointer GetBlockEntryPoint(const CodeBlock* block);
+static bool ShouldCompileHostCode(const CodeBlock* block);
+static bool CompileBlockHostCode(CodeBlock* block);
+/// Returns false if the block should still be interpreted. If compiling failed, the block is freed and set to null.
+static bool PromoteBlock(CodeBlock*& block);
+
+static PromotionStats s_promotion_stats = {};
+
+static bool HasCodeSpaceForBlock(const CodeBlock* block);
+static void EvictNextCodeRegion();
+
+static EvictionStats s_eviction_stats = {};
+
+// Blocks can be compiled on a worker thread, from a copy of the decoded block. The worker only writes to the free part
+// of the code buffer, and the CPU thread keeps interpreting the block until the result is installed from the
+// dispatcher. Results for blocks which were changed in the meantime are dropped. Evicting needs the block maps, so
+// when the buffer fills up the worker waits for the CPU thread to do it.
+static bool IsUsingCompileThread();
+static void StartCompileThread();
+static void StopCompileThread();
+static void CompileThreadEntryPoint();
+static void QueueBlockCompile(CodeBlock* block);
+static void InstallCompiledBlocks();
+static void InstallCompiledBlock(std::unique_ptr<CodeBlock> compiled_block);
+
+static std::thread s_compile_thread;
+static std::mutex s_compile_mutex;
+static std::condition_variable s_compile_cv;
+static std::deque<std::unique_ptr<CodeBlock>> s_compile_queue;
+static std::vector<std::unique_ptr<CodeBlock>> s_compile_results;
+static std::atomic_bool s_compile_thread_needs_attention{false};
+static bool s_compile_thread_needs_space = false;
+static bool s_compile_thread_shutdown = false;
+static AsyncCompileStats s_async_compile_stats = {};
+
+// Writes /tmp/perf-<pid>.map, so perf can attribute samples in the code buffer to guest code.
+static void WritePerfMapEntry(const void* code, u32 code_size, const char* format, ...) printflike(3, 4);
+static void WritePerfMapDispatcherEntries();
+static void WritePerfMapBlockEntry(const CodeBlock* block);
+static void FlushPerfMap();
+static void ClosePerfMap();
+/// Perf map files can't express unmapping, so the map is rewritten from the live blocks when code space is reused.
+static void RewritePerfMap();
+
+#ifdef __linux__
+static std::FILE* s_perf_map_file = nullptr;
+#endif
+static const void* s_perf_map_dispatcher_code = nullptr;
+static u32 s_perf_map_dispatcher_code_size = 0;
+static const void* s_perf_map_dispatcher_far_code = nullptr;
+static u32 s_perf_map_dispatcher_far_code_size = 0;
+
 static bool InitializeFastmem();
 static void ShutdownFastmem();
 static Common::PageFaultHandler::HandlerResult LUTPageFaultHandler(void* exception_pc, void* fault_address,
@@ -231,6 +328,39 @@ static Common::PageFaultHandler::HandlerResult LUTPageFaultHandler(void* excepti
 static Common::PageFaultHandler::HandlerResult MMapPageFaultHandler(void* exception_pc, void* fault_address,
                                                                     bool is_write);
 #endif
+
+// The prewarm list stores the blocks which were compiled for a game, along with a hash of the guest instructions.
+// Host code contains absolute pointers to thunks/state and relative branches into the far code buffer, so it isn't
+// saved. Instead, the cached blocks are validated against RAM and compiled again ahead of their first execution,
+// spread over several frames. This doesn't save any compile work, but moves it out of the frames where the game first
+// runs the code.
+static constexpr u32 PREWARM_LIST_MAGIC = 0x4B4C4244; // DBLK
+static constexpr u32 PREWARM_LIST_VERSION = 1;
+static constexpr u32 PREWARM_LIST_CHECKS_PER_FRAME = 512;
+static constexpr u32 PREWARM_LIST_COMPILES_PER_FRAME = 64;
+
+struct PrewarmEntry
+{
+  u32 key;
+  u32 instruction_count;
+  u64 hash;
+};
+static_assert(sizeof(PrewarmEntry) == 16, "Prewarm entry has no padding");
+
+static std::string GetPrewarmListPath(const std::string& game_code);
+static void LoadPrewarmList(const std::string& game_code);
+static void UpdatePrewarm();
+static bool HashGuestInstructions(u32 pc, u32 instruction_count, u64* hash);
+static void AddBlockToPrewarmList(const CodeBlock* block);
+static void MarkPrewarmedBlockExecuted(CodeBlock* block);
+
+static std::string s_prewarm_game_code;
+static std::unordered_map<u32, PrewarmEntry> s_prewarm_entries;
+static std::vector<PrewarmEntry> s_prewarm_pending;
+static u32 s_prewarm_pending_position = 0;
+static bool s_prewarm_dirty = false;
+static bool s_prewarm_precompiling = false;
+static PrewarmStats s_prewarm_stats = {};
 #endif // WITH_RECOMPILER
 
 void Initialize()
@@ -258,15 +388,23 @@ void Initialize()
 
     CompileDispatcher();
     ResetFastMap();
+
+    if (g_settings.cpu_recompiler_async_compile)
+      StartCompileThread();
   }
 #endif
 }
 
 void ClearState()
 {
+#ifdef WITH_RECOMPILER
+  StopCompileThread();
+#endif
+
   Bus::ClearRAMCodePageFlags();
   for (auto& it : m_ram_block_map)
     it.clear();
+  s_ram_code_subpage_counts.fill(0);
 
   for (const auto& it : s_blocks)
     delete it.second;
@@ -276,11 +414,61 @@ void ClearState()
   s_host_code_map.clear();
   s_code_buffer.Reset();
   ResetFastMap();
+
+  // The next entry starts a new map, so nothing from the old code buffer contents is left behind.
+  ClosePerfMap();
 #endif
 }
 
 void Shutdown()
 {
+#ifdef WITH_RECOMPILER
+  SavePrewarmList();
+  s_prewarm_game_code.clear();
+  s_prewarm_entries.clear();
+  s_prewarm_pending.clear();
+  s_prewarm_stats = {};
+
+  if (s_promotion_stats.interpreted_blocks > 0)
+  {
+    Log_InfoPrintf("%u of %u interpreted blocks were promoted to the recompiler", s_promotion_stats.promoted_blocks,
+                   s_promotion_stats.interpreted_blocks);
+  }
+  s_promotion_stats = {};
+
+  if (s_eviction_stats.evicted_regions > 0)
+  {
+    Log_InfoPrintf("%u blocks were evicted from %u code regions", s_eviction_stats.evicted_blocks,
+                   s_eviction_stats.evicted_regions);
+  }
+  s_eviction_stats = {};
+
+  if (s_async_compile_stats.queued_blocks > 0)
+  {
+    Log_InfoPrintf("%u of %u blocks compiled in the background were installed", s_async_compile_stats.installed_blocks,
+                   s_async_compile_stats.queued_blocks);
+  }
+  s_async_compile_stats = {};
+
+  ClosePerfMap();
+#endif
+
+  if (s_idle_loop_stats.skipped_loops > 0)
+  {
+    Log_InfoPrintf("%u idle loops were skipped %u times, saving %" PRIu64 " CPU ticks",
+                   s_idle_loop_stats.detected_loops, s_idle_loop_stats.skipped_loops, s_idle_loop_stats.skipped_ticks);
+  }
+  s_idle_loop_stats = {};
+  s_idle_loop_frame_ticks = 0;
+
+  if (s_smc_stats.code_page_writes > 0)
+  {
+    Log_InfoPrintf("%u of %u writes to code pages didn't touch code, %u blocks invalidated, %u blocks spared",
+                   s_smc_stats.avoided_invalidations, s_smc_stats.code_page_writes, s_smc_stats.invalidated_blocks,
+                   s_smc_stats.spared_blocks);
+  }
+  s_smc_stats = {};
+
   ClearState();
 #ifdef WITH_RECOMPILER
   ShutdownFastmem();
@@ -344,6 +532,13 @@ static void ExecuteImpl()
       next_block_key = GetNextBlockKey();
       if (next_block_key.bits == block->key.bits)
       {
+        if (block->is_idle_loop)
+        {
+          // nothing will change until the next event, so go and run it
+          SkipIdleLoop();
+          break;
+        }
+
         // we can jump straight to it if there's no pending interrupts
         // ensure it's not a self-modifying block
         if (!block->invalidated || RevalidateBlock(block))
@@ -387,6 +582,7 @@ static void ExecuteImpl()
 
   // in case we switch to interpreter...
   g_state.regs.npc = g_state.regs.pc;
+  UpdateIdleLoopFrameStats();
 }
 
 void Execute()
@@ -408,6 +604,8 @@ void Execute()
 
 void CompileDispatcher()
 {
+  const u8* start_ptr = s_code_buffer.GetFreeCodePointer();
+  const u8* far_start_ptr = s_code_buffer.GetFreeFarCodePointer();
   s_code_buffer.WriteProtect(false);
 
   {
@@ -420,6 +618,116 @@ void CompileDispatcher()
   }
 
   s_code_buffer.WriteProtect(true);
+
+  s_perf_map_dispatcher_code = start_ptr;
+  s_perf_map_dispatcher_code_size = static_cast<u32>(s_code_buffer.GetFreeCodePointer() - start_ptr);
+  s_perf_map_dispatcher_far_code = far_start_ptr;
+  s_perf_map_dispatcher_far_code_size = static_cast<u32>(s_code_buffer.GetFreeFarCodePointer() - far_start_ptr);
+  if (g_settings.cpu_recompiler_perf_map)
+  {
+    WritePerfMapDispatcherEntries();
+    FlushPerfMap();
+  }
+
+  // Dispatchers stay resident, everything after them is evictable.
+  s_code_buffer.CreateRegions(RECOMPILER_CODE_REGION_COUNT);
+}
+
+u32 CompareInlineGTEInstructions(u32 iterations, u32 seed)
+{
+  // RTPS/RTPT and MVMVA with each sf/lm and matrix/vector/translation, NCLIP, AVSZ3, AVSZ4, and commands which are
+  // always called out, to check they're rejected
+  static constexpr std::array<u32, 20> commands = {
+    {0x00080001, 0x00000401, 0x00080030, 0x00000430, 0x00080012, 0x00000412, 0x00028012, 0x000CE012, 0x00012412,
+     0x00098012, 0x000BA412, 0x0005E012, 0x00000006, 0x0000002D, 0x0000002E, 0x000E0012, 0x00004012, 0x0000000C,
+     0x00000013, 0x0000003F}};
+
+  JitCodeBuffer code_buffer;
+  if (!code_buffer.Allocate(64 * 1024, 64 * 1024))
+  {
+    Log_ErrorPrintf("Failed to allocate code space");
+    return iterations;
+  }
+
+  std::array<CodeBlock::HostCodePointer, commands.size()> host_code = {};
+  SingleBlockDispatcherFunction dispatcher;
+  code_buffer.WriteProtect(false);
+  {
+    Recompiler::CodeGenerator cg(&code_buffer);
+    dispatcher = cg.CompileSingleBlockDispatcher();
+  }
+  for (size_t i = 0; i < commands.size(); i++)
+  {
+    Recompiler::CodeGenerator cg(&code_buffer);
+    if (!cg.CompileInlineGTEInstruction(commands[i], &host_code[i]))
+      Log_InfoPrintf("Command 0x%08X is not emitted inline", commands[i]);
+  }
+  code_buffer.WriteProtect(true);
+
+  // Regs isn't copy-assignable because of the bitfields in FLAG
+  std::array<u32, GTE::NUM_REGS> saved_regs;
+  std::memcpy(saved_regs.data(), g_state.gte_regs.r32, sizeof(g_state.gte_regs.r32));
+  const TickCount saved_completion_tick = g_state.gte_completion_tick;
+
+  std::mt19937 rng(seed);
+  auto random_value = [&rng]() -> u32 {
+    // bias towards values which hit the MAC0 overflow and OTZ saturation paths
+    switch (rng() % 6)
+    {
+      case 0:
+        return 0;
+      case 1:
+        return UINT32_C(0x7FFF7FFF);
+      case 2:
+        return UINT32_C(0x80008000);
+      case 3:
+        return UINT32_C(0xFFFFFFFF);
+      default:
+        return static_cast<u32>(rng());
+    }
+  };
+
+  u32 mismatches = 0;
+  u32 tested = 0;
+  for (u32 i = 0; i < iterations; i++)
+  {
+    const size_t command_index = i % commands.size();
+    if (!host_code[command_index])
+      continue;
+
+    std::array<u32, GTE::NUM_REGS> input;
+    for (u32 j = 0; j < GTE::NUM_REGS; j++)
+      input[j] = random_value();
+
+    std::memcpy(g_state.gte_regs.r32, input.data(), sizeof(g_state.gte_regs.r32));
+    GTE::ExecuteInstruction(commands[command_index]);
+
+    std::array<u32, GTE::NUM_REGS> expected;
+    std::memcpy(expected.data(), g_state.gte_regs.r32, sizeof(g_state.gte_regs.r32));
+
+    std::memcpy(g_state.gte_regs.r32, input.data(), sizeof(g_state.gte_regs.r32));
+    dispatcher(host_code[command_index]);
+    tested++;
+
+    if (std::memcmp(g_state.gte_regs.r32, expected.data(), sizeof(g_state.gte_regs.r32)) != 0)
+    {
+      mismatches++;
+      for (u32 j = 0; j < GTE::NUM_REGS; j++)
+      {
+        if (g_state.gte_regs.r32[j] != expected[j])
+        {
+          Log_ErrorPrintf("Command 0x%08X: register %u is 0x%08X, expected 0x%08X", commands[command_index], j,
+                          g_state.gte_regs.r32[j], expected[j]);
+        }
+      }
+    }
+  }
+
+  std::memcpy(g_state.gte_regs.r32, saved_regs.data(), sizeof(g_state.gte_regs.r32));
+  g_state.gte_completion_tick = saved_completion_tick;
+
+  Log_InfoPrintf("%u of %u commands differed between the inline GTE code and the GTE.", mismatches, tested);
+  return mismatches;
 }
 
 FastMapTable* GetFastMapPointer()
@@ -432,6 +740,12 @@ void ExecuteRecompiler()
   g_using_interpreter = false;
   g_state.frame_done = false;
 
+  if (IsUsingCompileThread())
+    InstallCompiledBlocks();
+
+  if (g_settings.cpu_recompiler_block_prewarm)
+    UpdatePrewarm();
+
 #if 0
   while (!g_state.frame_done)
   {
@@ -461,6 +775,7 @@ void ExecuteRecompiler()
 
   // in case we switch to interpreter...
   g_state.regs.npc = g_state.regs.pc;
+  UpdateIdleLoopFrameStats();
 }
 
 #endif
@@ -493,6 +808,9 @@ void Reinitialize()
     AllocateFastMap();
     CompileDispatcher();
     ResetFastMap();
+
+    if (g_settings.cpu_recompiler_async_compile)
+      StartCompileThread();
   }
 #endif
 }
@@ -502,10 +820,216 @@ void Flush()
   ClearState();
 #ifdef WITH_RECOMPILER
   if (g_settings.IsUsingRecompiler())
+  {
     CompileDispatcher();
+    if (g_settings.cpu_recompiler_async_compile)
+      StartCompileThread();
+  }
 #endif
 }
 
+#ifdef WITH_RECOMPILER
+
+const PrewarmStats& GetPrewarmStats()
+{
+  s_prewarm_stats.entries = static_cast<u32>(s_prewarm_entries.size());
+  s_prewarm_stats.pending = static_cast<u32>(s_prewarm_pending.size());
+  return s_prewarm_stats;
+}
+
+std::string GetPrewarmListPath(const std::string& game_code)
+{
+  return g_host_interface->GetUserDirectoryRelativePath("cache" FS_OSPATH_SEPARATOR_STR "blocks" FS_OSPATH_SEPARATOR_STR
+                                                        "%s.bin",
+                                                        game_code.c_str());
+}
+
+void LoadPrewarmList(const std::string& game_code)
+{
+  s_prewarm_game_code = game_code;
+  s_prewarm_entries.clear();
+  s_prewarm_pending.clear();
+  s_prewarm_pending_position = 0;
+  s_prewarm_dirty = false;
+  s_prewarm_stats = {};
+  if (game_code.empty())
+    return;
+
+  const std::string path(GetPrewarmListPath(game_code));
+  auto fp = FileSystem::OpenManagedCFile(path.c_str(), "rb");
+  if (!fp)
+    return;
+
+  u32 header[3];
+  if (std::fread(header, sizeof(header), 1, fp.get()) != 1 || header[0] != PREWARM_LIST_MAGIC ||
+      header[1] != PREWARM_LIST_VERSION)
+  {
+    Log_WarningPrintf("Block prewarm list '%s' is invalid or from another version, ignoring", path.c_str());
+    return;
+  }
+
+  s_prewarm_pending.resize(header[2]);
+  if (header[2] > 0 &&
+      std::fread(s_prewarm_pending.data(), sizeof(PrewarmEntry), header[2], fp.get()) != header[2])
+  {
+    Log_WarningPrintf("Failed to read %u entries from block prewarm list '%s'", header[2], path.c_str());
+    s_prewarm_pending.clear();
+    return;
+  }
+
+  for (const PrewarmEntry& entry : s_prewarm_pending)
+    s_prewarm_entries.emplace(entry.key, entry);
+
+  Log_InfoPrintf("Loaded %zu blocks from block prewarm list '%s'", s_prewarm_pending.size(),
+                 path.c_str());
+}
+
+void SavePrewarmList()
+{
+  if (!s_prewarm_dirty || s_prewarm_game_code.empty())
+    return;
+
+  const std::string path(GetPrewarmListPath(s_prewarm_game_code));
+  const std::string directory(FileSystem::GetPathDirectory(path.c_str()));
+  if (!FileSystem::DirectoryExists(directory.c_str()) && !FileSystem::CreateDirectory(directory.c_str(), true))
+  {
+    Log_ErrorPrintf("Failed to create block prewarm list directory '%s'", directory.c_str());
+    return;
+  }
+
+  auto fp = FileSystem::OpenManagedCFile(path.c_str(), "wb");
+  if (!fp)
+  {
+    Log_ErrorPrintf("Failed to open block prewarm list '%s' for writing", path.c_str());
+    return;
+  }
+
+  const u32 header[3] = {PREWARM_LIST_MAGIC, PREWARM_LIST_VERSION,
+                         static_cast<u32>(s_prewarm_entries.size())};
+  bool result = (std::fwrite(header, sizeof(header), 1, fp.get()) == 1);
+  for (const auto& it : s_prewarm_entries)
+    result = result && (std::fwrite(&it.second, sizeof(it.second), 1, fp.get()) == 1);
+
+  if (!result)
+  {
+    Log_ErrorPrintf("Failed to write block prewarm list '%s'", path.c_str());
+    return;
+  }
+
+  Log_InfoPrintf("Saved %zu blocks to block prewarm list '%s' (%u prewarmed, %u executed, %u misses)",
+                 s_prewarm_entries.size(), path.c_str(), s_prewarm_stats.prewarmed,
+                 s_prewarm_stats.executed, s_prewarm_stats.misses);
+  s_prewarm_dirty = false;
+}
+
+bool HashGuestInstructions(u32 pc, u32 instruction_count, u64* hash)
+{
+  static std::vector<u32> instructions;
+  instructions.resize(instruction_count);
+
+  for (u32 i = 0; i < instruction_count; i++)
+  {
+    if (!SafeReadInstruction(pc, &instructions[i]))
+      return false;
+
+    pc += sizeof(u32);
+  }
+
+  *hash = XXH64(instructions.data(), instructions.size() * sizeof(u32), 0);
+  return true;
+}
+
+void AddBlockToPrewarmList(const CodeBlock* block)
+{
+  if (s_prewarm_precompiling || block->prewarmed)
+    return;
+
+  s_prewarm_stats.misses++;
+
+  // Blocks with double or traced branches aren't contiguous in memory, and would need the branch targets saved.
+  if (block->contains_double_branches || block->contains_traced_branches || s_prewarm_game_code.empty())
+    return;
+
+  PrewarmEntry entry;
+  entry.key = block->key.bits;
+  entry.instruction_count = static_cast<u32>(block->instructions.size());
+  if (!HashGuestInstructions(block->GetPC(), entry.instruction_count, &entry.hash))
+    return;
+
+  auto iter = s_prewarm_entries.find(entry.key);
+  if (iter != s_prewarm_entries.end())
+  {
+    if (iter->second.instruction_count == entry.instruction_count && iter->second.hash == entry.hash)
+      return;
+
+    iter->second = entry;
+  }
+  else
+  {
+    s_prewarm_entries.emplace(entry.key, entry);
+  }
+
+  s_prewarm_dirty = true;
+}
+
+void UpdatePrewarm()
+{
+  const std::string& game_code = System::GetRunningCode();
+  if (game_code != s_prewarm_game_code)
+  {
+    SavePrewarmList();
+    LoadPrewarmList(game_code);
+  }
+
+  // Entries which don't match RAM are left in the list, since the game may not have loaded that code yet.
+  u32 checks = 0;
+  u32 compiles = 0;
+  while (!s_prewarm_pending.empty() && checks < PREWARM_LIST_CHECKS_PER_FRAME &&
+         compiles < PREWARM_LIST_COMPILES_PER_FRAME)
+  {
+    if (s_prewarm_pending_position >= s_prewarm_pending.size())
+      s_prewarm_pending_position = 0;
+
+    const PrewarmEntry entry = s_prewarm_pending[s_prewarm_pending_position];
+    checks++;
+
+    u64 hash;
+    const bool compiled = (s_blocks.find(entry.key) != s_blocks.end());
+    if (!compiled &&
+        (!HashGuestInstructions(CodeBlockKey{entry.key}.GetPC(), entry.instruction_count, &hash) || hash != entry.hash))
+    {
+      s_prewarm_pending_position++;
+      continue;
+    }
+
+    s_prewarm_pending[s_prewarm_pending_position] = s_prewarm_pending.back();
+    s_prewarm_pending.pop_back();
+    if (compiled)
+      continue;
+
+    s_prewarm_precompiling = true;
+    CodeBlock* block = LookupBlock(CodeBlockKey{entry.key});
+    s_prewarm_precompiling = false;
+    compiles++;
+    if (!block)
+      continue;
+
+    // Send the first execution through the dispatcher, so it can be counted.
+    block->prewarmed = true;
+    SetFastMap(block->GetPC(), GetBlockEntryPoint(block));
+    s_prewarm_stats.prewarmed++;
+  }
+}
+
+void MarkPrewarmedBlockExecuted(CodeBlock* block)
+{
+  block->prewarmed = false;
+  SetFastMap(block->GetPC(), GetBlockEntryPoint(block));
+  s_prewarm_stats.executed++;
+}
+
+#endif
+
 void LogCurrentState()
 {
   const auto& regs = g_state.regs;
@@ -563,8 +1087,11 @@ CodeBlock* LookupBlock(CodeBlockKey key)
     AddBlockToPageMap(block);
 
 #ifdef WITH_RECOMPILER
-    SetFastMap(block->GetPC(), block->host_code);
+    SetFastMap(block->GetPC(), GetBlockEntryPoint(block));
     AddBlockToHostCodeMap(block);
+
+    if (g_settings.cpu_recompiler_block_prewarm && block->host_code)
+      AddBlockToPrewarmList(block);
 #endif
   }
   else
@@ -596,7 +1123,7 @@ bool RevalidateBlock(CodeBlock* block)
   block->invalidated = false;
   AddBlockToPageMap(block);
 #ifdef WITH_RECOMPILER
-  SetFastMap(block->GetPC(), block->host_code);
+  SetFastMap(block->GetPC(), GetBlockEntryPoint(block));
 #endif
   return true;
 
@@ -633,6 +1160,7 @@ recompile:
   }
 
   block->instructions.clear();
+  block->prewarmed = false;
 
   if (!CompileBlock(block))
   {
@@ -645,8 +1173,11 @@ recompile:
 
 #ifdef WITH_RECOMPILER
   // re-add to page map again
-  SetFastMap(block->GetPC(), block->host_code);
+  SetFastMap(block->GetPC(), GetBlockEntryPoint(block));
   AddBlockToHostCodeMap(block);
+
+  if (g_settings.cpu_recompiler_block_prewarm && block->host_code)
+    AddBlockToPrewarmList(block);
 #endif
 
   // re-insert into the block map since we removed it earlier.
@@ -667,10 +1198,14 @@ bool CompileBlock(CodeBlock* block)
 
   block->icache_line_count = 0;
   block->uncached_fetch_ticks = 0;
+  block->compile_pending = false;
   block->contains_double_branches = false;
+  block->contains_traced_branches = false;
   block->contains_loadstore_instructions = false;
+  block->predecoded_instructions.clear();
 
   u32 last_cache_line = ICACHE_LINES;
+  u32 traced_branches = 0;
 
   for (;;)
   {
@@ -687,7 +1222,7 @@ bool CompileBlock(CodeBlock* block)
     cbi.is_load_instruction = IsMemoryLoadInstruction(cbi.instruction);
     cbi.is_store_instruction = IsMemoryStoreInstruction(cbi.instruction);
     cbi.has_load_delay = InstructionHasLoadDelay(cbi.instruction);
-    cbi.can_trap = CanInstructionTrap(cbi.instruction, InUserMode());
+    cbi.can_trap = CanInstructionTrap(cbi.instruction, block->key.user_mode);
     cbi.is_direct_branch_instruction = IsDirectBranchInstruction(cbi.instruction);
 
     if (g_settings.cpu_recompiler_icache)
@@ -731,7 +1266,22 @@ bool CompileBlock(CodeBlock* block)
     // if we're in a branch delay slot, the block is now done
     // except if this is a branch in a branch delay slot, then we grab the one after that, and so on...
     if (is_branch_delay_slot && !cbi.is_branch_instruction)
-      break;
+    {
+      // unconditional direct branches can continue the block at the target instead
+      CodeBlockInstruction& branch_cbi = block->instructions[block->instructions.size() - 2];
+      if (traced_branches == MAX_TRACED_BRANCHES_PER_BLOCK || !CanTraceBranch(block, branch_cbi))
+        break;
+
+      branch_cbi.is_traced_branch = true;
+      block->contains_traced_branches = true;
+      traced_branches++;
+
+      pc = GetDirectBranchTarget(branch_cbi.instruction, branch_cbi.pc);
+      Log_DevPrintf("Tracing branch at %08X into block %08X -> %08X", branch_cbi.pc, block->GetPC(), pc);
+      is_branch_delay_slot = false;
+      is_load_delay_slot = cbi.has_load_delay;
+      continue;
+    }
 
     // if this is a branch, we grab the next instruction (delay slot), and then exit
     is_branch_delay_slot = cbi.is_branch_instruction;
@@ -748,6 +1298,18 @@ bool CompileBlock(CodeBlock* block)
   {
     block->instructions.back().is_last_instruction = true;
 
+    // if the target couldn't be decoded, the traced branch has to exit the block normally
+    const size_t num_instructions = block->instructions.size();
+    if (num_instructions >= 2 && block->instructions.back().is_branch_delay_slot)
+      block->instructions[num_instructions - 2].is_traced_branch = false;
+
+    block->is_idle_loop = g_settings.cpu_idle_loop_skipping && IsIdleLoop(block);
+    if (block->is_idle_loop)
+    {
+      Log_DevPrintf("Block 0x%08X is an idle loop", block->GetPC());
+      s_idle_loop_stats.detected_loops++;
+    }
+
 #ifdef _DEBUG
     SmallString disasm;
     Log_DebugPrintf("Block at 0x%08X", block->GetPC());
@@ -768,115 +1330,991 @@ bool CompileBlock(CodeBlock* block)
 #ifdef WITH_RECOMPILER
   if (g_settings.IsUsingRecompiler())
   {
-    // Ensure we're not going to run out of space while compiling this block.
-    if (s_code_buffer.GetFreeCodeSpace() <
-          (block->instructions.size() * Recompiler::MAX_NEAR_HOST_BYTES_PER_INSTRUCTION) ||
-        s_code_buffer.GetFreeFarCodeSpace() <
-          (block->instructions.size() * Recompiler::MAX_FAR_HOST_BYTES_PER_INSTRUCTION))
+    if (!ShouldCompileHostCode(block))
     {
-      Log_WarningPrintf("Out of code space, flushing all blocks.");
-      Flush();
+      // Profile it in the cached interpreter first.
+      block->host_code = nullptr;
+      block->host_code_size = 0;
+      s_promotion_stats.interpreted_blocks++;
+      if (g_settings.cpu_cached_interpreter_predecode)
+        PredecodeBlock(block);
+
+      return true;
     }
 
-    s_code_buffer.WriteProtect(false);
-    Recompiler::CodeGenerator codegen(&s_code_buffer);
-    const bool compile_result = codegen.CompileBlock(block, &block->host_code, &block->host_code_size);
-    s_code_buffer.WriteProtect(true);
-
-    if (!compile_result)
+    if (IsUsingCompileThread())
     {
-      Log_ErrorPrintf("Failed to compile host code for block at 0x%08X", block->key.GetPC());
-      return false;
+      // Keep interpreting it until the worker is done.
+      block->host_code = nullptr;
+      block->host_code_size = 0;
+      if (g_settings.cpu_cached_interpreter_predecode)
+        PredecodeBlock(block);
+
+      QueueBlockCompile(block);
+      return true;
     }
+
+    return CompileBlockHostCode(block);
   }
 #endif
 
+  if (g_settings.cpu_cached_interpreter_predecode)
+    PredecodeBlock(block);
+
   return true;
 }
 
-#ifdef WITH_RECOMPILER
-
-void FastCompileBlockFunction()
+bool CanTraceBranch(const CodeBlock* block, const CodeBlockInstruction& cbi)
 {
-  CodeBlock* block = LookupBlock(GetNextBlockKey());
-  if (block)
+  // Memory exceptions need the branch state of the delay slot, which only exists at the end of a block.
+  // The icache check walks consecutive lines from the start of the block, which traced blocks don't have.
+  if (!g_settings.cpu_recompiler_superblocks || !g_settings.IsUsingRecompiler() ||
+      g_settings.cpu_recompiler_memory_exceptions || g_settings.cpu_recompiler_icache || cbi.is_branch_delay_slot ||
+      block->instructions.size() >= MAX_TRACED_BLOCK_INSTRUCTIONS)
   {
-    s_single_block_asm_dispatcher(block->host_code);
-    return;
+    return false;
   }
 
-  if (g_settings.gpu_pgxp_enable)
+  // Only branches which are always taken, IsUnconditionalBranchInstruction() includes all REGIMM branches.
+  // Conditional branches would need a side exit for the untaken path, so they still end the block.
+  const Instruction instruction = cbi.instruction;
+  switch (instruction.op)
   {
-    if (g_settings.gpu_pgxp_cpu)
-      InterpretUncachedBlock<PGXPMode::CPU>();
-    else
-      InterpretUncachedBlock<PGXPMode::Memory>();
+    case InstructionOp::j:
+    case InstructionOp::jal:
+      break;
+
+    case InstructionOp::beq:
+      if (instruction.i.rs != Reg::zero || instruction.i.rt != Reg::zero)
+        return false;
+      break;
+
+    case InstructionOp::b:
+      if (instruction.i.rs != Reg::zero || (static_cast<u8>(instruction.i.rt.GetValue()) & u8(1)) == 0)
+        return false;
+      break;
+
+    default:
+      return false;
   }
-  else
+
+  // Loops are left to block linking, and the target has to be in the same memory region for SMC tracking.
+  const u32 target = GetDirectBranchTarget(instruction, cbi.pc);
+  const bool target_in_ram = ((target & PHYSICAL_MEMORY_ADDRESS_MASK) < 0x200000);
+  if ((target & 3) != 0 || target_in_ram != block->IsInRAM())
+    return false;
+
+  for (const CodeBlockInstruction& existing_cbi : block->instructions)
   {
-    InterpretUncachedBlock<PGXPMode::Disabled>();
+    if (existing_cbi.pc == target)
+      return false;
   }
+
+  return true;
 }
 
-void InvalidCodeFunction()
+// Returns false if the instruction could have side effects, or depends on anything other than registers and memory.
+static bool GetIdleLoopRegisterUsage(const Instruction& instruction, u32* reads, u32* writes)
 {
-  Log_ErrorPrintf("Trying to execute invalid code at 0x%08X", g_state.regs.pc);
-  if (g_settings.gpu_pgxp_enable)
-  {
-    if (g_settings.gpu_pgxp_cpu)
-      InterpretUncachedBlock<PGXPMode::CPU>();
-    else
-      InterpretUncachedBlock<PGXPMode::Memory>();
-  }
-  else
+  const u32 rs = UINT32_C(1) << static_cast<u8>(instruction.i.rs.GetValue());
+  const u32 rt = UINT32_C(1) << static_cast<u8>(instruction.i.rt.GetValue());
+  const u32 rd = UINT32_C(1) << static_cast<u8>(instruction.r.rd.GetValue());
+  const u32 zero_mask = ~UINT32_C(1);
+  *reads = 0;
+  *writes = 0;
+
+  switch (instruction.op)
   {
-    InterpretUncachedBlock<PGXPMode::Disabled>();
-  }
-}
+    case InstructionOp::lb:
+    case InstructionOp::lbu:
+    case InstructionOp::lh:
+    case InstructionOp::lhu:
+    case InstructionOp::lw:
+    case InstructionOp::addiu:
+    case InstructionOp::andi:
+    case InstructionOp::ori:
+    case InstructionOp::xori:
+    case InstructionOp::slti:
+    case InstructionOp::sltiu:
+      *reads = rs & zero_mask;
+      *writes = rt & zero_mask;
+      return true;
+
+    case InstructionOp::lui:
+      *writes = rt & zero_mask;
+      return true;
+
+    case InstructionOp::beq:
+    case InstructionOp::bne:
+      *reads = (rs | rt) & zero_mask;
+      return true;
+
+    case InstructionOp::blez:
+    case InstructionOp::bgtz:
+      *reads = rs & zero_mask;
+      return true;
+
+    case InstructionOp::b:
+    {
+      // bltzal/bgezal write ra
+      if ((static_cast<u8>(instruction.i.rt.GetValue()) & u8(0x1E)) == u8(0x10))
+        return false;
 
-#endif
+      *reads = rs & zero_mask;
+      return true;
+    }
 
-void InvalidateBlocksWithPageIndex(u32 page_index)
-{
-  DebugAssert(page_index < Bus::RAM_8MB_CODE_PAGE_COUNT);
-  auto& blocks = m_ram_block_map[page_index];
-  for (CodeBlock* block : blocks)
-  {
-    // Invalidate forces the block to be checked again.
-    Log_DebugPrintf("Invalidating block at 0x%08X", block->GetPC());
-    block->invalidated = true;
+    case InstructionOp::j:
+      return true;
 
-    if (block->can_link)
+    case InstructionOp::funct:
     {
-      const u32 frame_number = System::GetFrameNumber();
-      const u32 frame_diff = frame_number - block->invalidate_frame_number;
-      if (frame_diff <= INVALIDATE_THRESHOLD_TO_DISABLE_LINKING)
-      {
-        Log_DevPrintf("Block 0x%08X has been invalidated in %u frames, disabling linking", block->GetPC(), frame_diff);
-        block->can_link = false;
-      }
-      else
+      switch (instruction.r.funct)
       {
-        // It's been a while since this block was modified, so it's all good.
-        block->invalidate_frame_number = frame_number;
+        case InstructionFunct::sll:
+        case InstructionFunct::srl:
+        case InstructionFunct::sra:
+          *reads = rt & zero_mask;
+          *writes = rd & zero_mask;
+          return true;
+
+        case InstructionFunct::sllv:
+        case InstructionFunct::srlv:
+        case InstructionFunct::srav:
+        case InstructionFunct::addu:
+        case InstructionFunct::subu:
+        case InstructionFunct::and_:
+        case InstructionFunct::or_:
+        case InstructionFunct::xor_:
+        case InstructionFunct::nor:
+        case InstructionFunct::slt:
+        case InstructionFunct::sltu:
+          *reads = (rs | rt) & zero_mask;
+          *writes = rd & zero_mask;
+          return true;
+
+        default:
+          return false;
       }
     }
 
-    UnlinkBlock(block);
-
-#ifdef WITH_RECOMPILER
-    SetFastMap(block->GetPC(), FastCompileBlockFunction);
-#endif
+    default:
+      return false;
   }
-
-  // Block will be re-added next execution.
-  blocks.clear();
-  Bus::ClearRAMCodePage(page_index);
+}
+
+// I/O registers such as the timer counters and status registers change without an event being scheduled, so only
+// loads which are known to hit RAM or the scratchpad can be repeated.
+static bool IsIdleLoopLoadAddress(VirtualMemoryAddress address, u32 size)
+{
+  if ((address & (size - 1)) != 0)
+    return false;
+
+  const Segment segment = GetSegmentForAddress(address);
+  if (segment == Segment::KSEG2)
+    return false;
+
+  const PhysicalMemoryAddress phys_addr = address & PHYSICAL_MEMORY_ADDRESS_MASK;
+  return (Bus::IsRAMAddress(phys_addr) ||
+          (segment != Segment::KSEG1 && (phys_addr & DCACHE_LOCATION_MASK) == DCACHE_LOCATION));
+}
+
+// Tracks registers which the loop sets to a constant, so the addresses of loads can be resolved.
+static void UpdateIdleLoopConstants(const Instruction& instruction, u32 writes, u32* constant_regs,
+                                    std::array<u32, 32>& constant_values)
+{
+  if (writes == 0)
+    return;
+
+  const u8 rs = static_cast<u8>(instruction.i.rs.GetValue());
+  const u8 rt = static_cast<u8>(instruction.i.rt.GetValue());
+  const bool rs_constant = ((*constant_regs >> rs) & 1u) != 0;
+  u32 value;
+  switch (instruction.op)
+  {
+    case InstructionOp::lui:
+      value = instruction.i.imm_zext32() << 16;
+      break;
+
+    case InstructionOp::addiu:
+    case InstructionOp::ori:
+    case InstructionOp::andi:
+    case InstructionOp::xori:
+    {
+      if (!rs_constant)
+      {
+        *constant_regs &= ~writes;
+        return;
+      }
+
+      const u32 rs_value = constant_values[rs];
+      if (instruction.op == InstructionOp::addiu)
+        value = rs_value + instruction.i.imm_sext32();
+      else if (instruction.op == InstructionOp::ori)
+        value = rs_value | instruction.i.imm_zext32();
+      else if (instruction.op == InstructionOp::andi)
+        value = rs_value & instruction.i.imm_zext32();
+      else
+        value = rs_value ^ instruction.i.imm_zext32();
+    }
+    break;
+
+    default:
+      *constant_regs &= ~writes;
+      return;
+  }
+
+  *constant_regs |= writes;
+  constant_values[rt] = value;
+}
+
+bool IsIdleLoop(const CodeBlock* block)
+{
+  const size_t num_instructions = block->instructions.size();
+  if (block->contains_double_branches || block->contains_traced_branches || num_instructions < 2)
+    return false;
+
+  // The block has to end with a direct branch back to its own start.
+  const CodeBlockInstruction& branch_cbi = block->instructions[num_instructions - 2];
+  if (!branch_cbi.is_direct_branch_instruction || !block->instructions.back().is_branch_delay_slot ||
+      GetDirectBranchTarget(branch_cbi.instruction, branch_cbi.pc) != block->GetPC())
+  {
+    return false;
+  }
+
+  u32 reads, writes;
+  u32 loop_writes = 0;
+  for (const CodeBlockInstruction& cbi : block->instructions)
+  {
+    if (!GetIdleLoopRegisterUsage(cbi.instruction, &reads, &writes))
+      return false;
+
+    loop_writes |= writes;
+  }
+
+  // Each iteration can only depend on registers which it writes before reading, or which the loop doesn't write, so
+  // that repeating it gives the same result until memory changes. Loads write their register after the next
+  // instruction, so a read in the delay slot still sees the previous iteration.
+  // The base of each load has to be a constant which the loop sets itself, otherwise we can't tell if it reads I/O.
+  std::array<u32, 32> constant_values = {};
+  u32 constant_regs = 1; // zero
+  u32 written = 0;
+  u32 pending_load = 0;
+  for (const CodeBlockInstruction& cbi : block->instructions)
+  {
+    GetIdleLoopRegisterUsage(cbi.instruction, &reads, &writes);
+    if ((reads & loop_writes & ~written) != 0)
+      return false;
+
+    written |= pending_load;
+    pending_load = 0;
+    if (IsMemoryLoadInstruction(cbi.instruction))
+    {
+      const u8 base = static_cast<u8>(cbi.instruction.i.rs.GetValue());
+      u32 size = 1;
+      if (cbi.instruction.op == InstructionOp::lw)
+        size = 4;
+      else if (cbi.instruction.op == InstructionOp::lh || cbi.instruction.op == InstructionOp::lhu)
+        size = 2;
+
+      if (((constant_regs >> base) & 1u) == 0 ||
+          !IsIdleLoopLoadAddress(constant_values[base] + cbi.instruction.i.imm_sext32(), size))
+      {
+        return false;
+      }
+
+      pending_load = writes;
+    }
+    else
+    {
+      written |= writes;
+    }
+
+    UpdateIdleLoopConstants(cbi.instruction, writes, &constant_regs, constant_values);
+  }
+
+  // A load in the branch delay slot would carry over into the next iteration.
+  return (pending_load == 0);
+}
+
+void SkipIdleLoop()
+{
+  const TickCount ticks = g_state.downcount - g_state.pending_ticks;
+  if (ticks <= 0)
+    return;
+
+  g_state.pending_ticks = g_state.downcount;
+  s_idle_loop_stats.skipped_loops++;
+  s_idle_loop_stats.skipped_ticks += static_cast<u64>(ticks);
+  s_idle_loop_frame_ticks += ticks;
+}
+
+void UpdateIdleLoopFrameStats()
+{
+  s_idle_loop_stats.frame_skipped_ticks = s_idle_loop_frame_ticks;
+  s_idle_loop_frame_ticks = 0;
+}
+
+const IdleLoopStats& GetIdleLoopStats()
+{
+  return s_idle_loop_stats;
+}
+
+#ifdef WITH_RECOMPILER
+
+bool ShouldCompileHostCode(const CodeBlock* block)
+{
+  return (s_prewarm_precompiling || block->execution_count >= g_settings.cpu_recompiler_promotion_threshold);
+}
+
+bool CompileBlockHostCode(CodeBlock* block)
+{
+  // Ensure we're not going to run out of space while compiling this block.
+  if (!HasCodeSpaceForBlock(block))
+  {
+    EvictNextCodeRegion();
+    if (!HasCodeSpaceForBlock(block))
+    {
+      Log_WarningPrintf("Out of code space, flushing all blocks.");
+      Flush();
+    }
+  }
+
+  s_code_buffer.WriteProtect(false);
+  Recompiler::CodeGenerator codegen(&s_code_buffer);
+  const u8* far_code_start = s_code_buffer.GetFreeFarCodePointer();
+  const bool compile_result = codegen.CompileBlock(block, &block->host_code, &block->host_code_size);
+  block->far_host_code = far_code_start;
+  block->far_host_code_size = static_cast<u32>(s_code_buffer.GetFreeFarCodePointer() - far_code_start);
+  s_code_buffer.WriteProtect(true);
+
+  if (!compile_result)
+  {
+    Log_ErrorPrintf("Failed to compile host code for block at 0x%08X", block->key.GetPC());
+    return false;
+  }
+
+  if (g_settings.cpu_recompiler_perf_map)
+  {
+    WritePerfMapBlockEntry(block);
+    FlushPerfMap();
+  }
+
+  return true;
+}
+
+bool PromoteBlock(CodeBlock*& block)
+{
+  block->execution_count++;
+  if (!ShouldCompileHostCode(block))
+    return false;
+
+  if (IsUsingCompileThread())
+  {
+    if (!block->compile_pending)
+      QueueBlockCompile(block);
+
+    return false;
+  }
+
+  // Compiling can flush the whole cache if we're out of space, so pull it out of the lookup tables first.
+  RemoveReferencesToBlock(block);
+  if (!CompileBlockHostCode(block))
+  {
+    Log_PerfPrintf("Failed to promote block 0x%08X, falling back to interpreter.", block->GetPC());
+    FallbackExistingBlockToInterpreter(block);
+    block = nullptr;
+    return false;
+  }
+
+  Log_DebugPrintf("Promoting block 0x%08X after %u executions", block->GetPC(), block->execution_count);
+  s_promotion_stats.promoted_blocks++;
+
+  AddBlockToPageMap(block);
+  SetFastMap(block->GetPC(), block->host_code);
+  AddBlockToHostCodeMap(block);
+  s_blocks.emplace(block->key.bits, block);
+
+  if (g_settings.cpu_recompiler_block_prewarm)
+    AddBlockToPrewarmList(block);
+
+  return true;
+}
+
+bool HasCodeSpaceForBlock(const CodeBlock* block)
+{
+  const u32 instruction_count = static_cast<u32>(block->instructions.size());
+  const u32 bytes_per_instruction = g_settings.UsingPGXPCPUMode() ?
+                                      Recompiler::MAX_NEAR_HOST_BYTES_PER_PGXP_INSTRUCTION :
+                                      Recompiler::MAX_NEAR_HOST_BYTES_PER_INSTRUCTION;
+  u32 near_bytes = instruction_count * bytes_per_instruction;
+  if (g_settings.cpu_recompiler_inline_gte)
+  {
+    for (const CodeBlockInstruction& cbi : block->instructions)
+    {
+      if (cbi.instruction.op == InstructionOp::cop2 && cbi.instruction.cop.IsCommonInstruction())
+      {
+        near_bytes += Recompiler::MAX_NEAR_HOST_BYTES_PER_INLINE_GTE_INSTRUCTION - bytes_per_instruction;
+      }
+    }
+  }
+
+  return (s_code_buffer.GetFreeCodeSpace() >= near_bytes &&
+          s_code_buffer.GetFreeFarCodeSpace() >= (instruction_count * Recompiler::MAX_FAR_HOST_BYTES_PER_INSTRUCTION));
+}
+
+void EvictNextCodeRegion()
+{
+  const u32 region = s_code_buffer.AdvanceRegion();
+  const CodeBlock::HostCodePointer region_start =
+    reinterpret_cast<CodeBlock::HostCodePointer>(s_code_buffer.GetRegionCodeStart(region));
+  const CodeBlock::HostCodePointer region_end =
+    reinterpret_cast<CodeBlock::HostCodePointer>(s_code_buffer.GetRegionCodeEnd(region));
+
+  // Blocks in the near region also own everything in the matching far region, so this covers both.
+  std::vector<CodeBlock*> evict_blocks;
+  for (auto iter = s_host_code_map.lower_bound(region_start);
+       iter != s_host_code_map.end() && iter->first < region_end; ++iter)
+  {
+    evict_blocks.push_back(iter->second);
+  }
+
+  Log_PerfPrintf("Out of code space, evicting %zu blocks from region %u.", evict_blocks.size(), region);
+
+  for (CodeBlock* block : evict_blocks)
+  {
+    // Invalidated blocks are still in the host code map, but not the page map.
+    const bool was_invalidated = block->invalidated;
+    RemoveReferencesToBlock(block);
+    if (was_invalidated)
+      RemoveBlockFromHostCodeMap(block);
+
+    delete block;
+  }
+
+  s_eviction_stats.evicted_regions++;
+  s_eviction_stats.evicted_blocks += static_cast<u32>(evict_blocks.size());
+
+  if (g_settings.cpu_recompiler_perf_map)
+    RewritePerfMap();
+}
+
+const EvictionStats& GetEvictionStats()
+{
+  return s_eviction_stats;
+}
+
+bool IsUsingCompileThread()
+{
+  return s_compile_thread.joinable();
+}
+
+void StartCompileThread()
+{
+  if (s_compile_thread.joinable())
+    return;
+
+  s_compile_thread_needs_space = false;
+  s_compile_thread_shutdown = false;
+  s_compile_thread = std::thread(CompileThreadEntryPoint);
+  Log_InfoPrint("Background block compile thread started");
+}
+
+void StopCompileThread()
+{
+  if (!s_compile_thread.joinable())
+    return;
+
+  {
+    std::unique_lock<std::mutex> lock(s_compile_mutex);
+    s_compile_thread_shutdown = true;
+    s_compile_cv.notify_one();
+  }
+
+  s_compile_thread.join();
+
+  // Anything which wasn't installed refers to code which is about to be thrown away.
+  s_compile_queue.clear();
+  s_compile_results.clear();
+  s_compile_thread_needs_attention.store(false);
+}
+
+void CompileThreadEntryPoint()
+{
+  std::unique_lock<std::mutex> lock(s_compile_mutex);
+  for (;;)
+  {
+    s_compile_cv.wait(lock, []() {
+      return s_compile_thread_shutdown || (!s_compile_queue.empty() && !s_compile_thread_needs_space);
+    });
+    if (s_compile_thread_shutdown)
+      break;
+
+    std::unique_ptr<CodeBlock> block = std::move(s_compile_queue.front());
+    s_compile_queue.pop_front();
+    lock.unlock();
+
+    // The CPU thread only moves the code buffer's free pointers when evicting, which happens while we're waiting.
+    const bool has_space = HasCodeSpaceForBlock(block.get());
+    if (has_space)
+    {
+      s_code_buffer.WriteProtect(false);
+      Recompiler::CodeGenerator codegen(&s_code_buffer);
+      codegen.DisableGuestStateSpeculation();
+      const u8* far_code_start = s_code_buffer.GetFreeFarCodePointer();
+      if (!codegen.CompileBlock(block.get(), &block->host_code, &block->host_code_size))
+      {
+        Log_ErrorPrintf("Failed to compile host code for block at 0x%08X", block->key.GetPC());
+        block->host_code = nullptr;
+      }
+      block->far_host_code = far_code_start;
+      block->far_host_code_size = static_cast<u32>(s_code_buffer.GetFreeFarCodePointer() - far_code_start);
+      s_code_buffer.WriteProtect(true);
+    }
+
+    lock.lock();
+    if (has_space)
+    {
+      s_compile_results.push_back(std::move(block));
+    }
+    else
+    {
+      s_compile_queue.push_front(std::move(block));
+      s_compile_thread_needs_space = true;
+    }
+
+    s_compile_thread_needs_attention.store(true);
+  }
+}
+
+void QueueBlockCompile(CodeBlock* block)
+{
+  std::unique_ptr<CodeBlock> compile_block = std::make_unique<CodeBlock>(*block);
+  compile_block->host_code = nullptr;
+  compile_block->host_code_size = 0;
+  compile_block->link_predecessors.clear();
+  compile_block->link_successors.clear();
+  compile_block->loadstore_backpatch_info.clear();
+  block->compile_pending = true;
+  s_async_compile_stats.queued_blocks++;
+
+  std::unique_lock<std::mutex> lock(s_compile_mutex);
+  s_compile_queue.push_back(std::move(compile_block));
+  s_compile_cv.notify_one();
+}
+
+void InstallCompiledBlocks()
+{
+  if (!s_compile_thread_needs_attention.load())
+    return;
+
+  std::vector<std::unique_ptr<CodeBlock>> results;
+  bool needs_space;
+  {
+    std::unique_lock<std::mutex> lock(s_compile_mutex);
+    results.swap(s_compile_results);
+    needs_space = s_compile_thread_needs_space;
+    s_compile_thread_needs_attention.store(false);
+  }
+
+  // The worker flushes the caches for the code it writes, but on ARM this thread also needs a barrier before it can
+  // safely execute code which another thread modified.
+  if (!results.empty())
+    JitCodeBuffer::SynchronizeInstructionFetch();
+
+  for (std::unique_ptr<CodeBlock>& compiled_block : results)
+    InstallCompiledBlock(std::move(compiled_block));
+
+  if (!needs_space)
+    return;
+
+  // The worker is waiting, so the buffer is ours. Results are installed first, so that they're evicted properly.
+  EvictNextCodeRegion();
+
+  std::unique_ptr<CodeBlock> oversized_block;
+  {
+    std::unique_lock<std::mutex> lock(s_compile_mutex);
+    if (!s_compile_queue.empty() &&
+        !HasCodeSpaceForBlock(s_compile_queue.front().get()))
+    {
+      // Won't fit in a region, so leave it to the interpreter.
+      oversized_block = std::move(s_compile_queue.front());
+      s_compile_queue.pop_front();
+    }
+
+    s_compile_thread_needs_space = false;
+    s_compile_cv.notify_one();
+  }
+
+  if (oversized_block)
+    InstallCompiledBlock(std::move(oversized_block));
+}
+
+void InstallCompiledBlock(std::unique_ptr<CodeBlock> compiled_block)
+{
+  auto iter = s_blocks.find(compiled_block->key.bits);
+  CodeBlock* block = (iter != s_blocks.end()) ? iter->second : nullptr;
+  if (!block || !block->compile_pending || block->host_code ||
+      block->instructions.size() != compiled_block->instructions.size() ||
+      !std::equal(block->instructions.begin(), block->instructions.end(), compiled_block->instructions.begin(),
+                  [](const CodeBlockInstruction& lhs, const CodeBlockInstruction& rhs) {
+                    return (lhs.pc == rhs.pc && lhs.instruction.bits == rhs.instruction.bits);
+                  }))
+  {
+    // Recompiled or thrown away while the worker had it. The code stays in the buffer until it's evicted.
+    Log_DebugPrintf("Dropping background compile of block 0x%08X", compiled_block->GetPC());
+    s_async_compile_stats.discarded_blocks++;
+    return;
+  }
+
+  block->compile_pending = false;
+  if (block->invalidated)
+  {
+    // It'll be queued again when it's promoted after revalidating.
+    s_async_compile_stats.discarded_blocks++;
+    return;
+  }
+
+  RemoveReferencesToBlock(block);
+  if (!compiled_block->host_code)
+  {
+    Log_PerfPrintf("Failed to compile block 0x%08X in the background, falling back to interpreter.", block->GetPC());
+    FallbackExistingBlockToInterpreter(block);
+    return;
+  }
+
+  // Pick up anything which changed while it was being interpreted.
+  CodeBlock* new_block = compiled_block.release();
+  new_block->execution_count = block->execution_count;
+  new_block->can_link = block->can_link;
+  new_block->recompile_frame_number = block->recompile_frame_number;
+  new_block->recompile_count = block->recompile_count;
+  new_block->invalidate_frame_number = block->invalidate_frame_number;
+  new_block->prewarmed = block->prewarmed;
+  delete block;
+
+  AddBlockToPageMap(new_block);
+  SetFastMap(new_block->GetPC(), GetBlockEntryPoint(new_block));
+  AddBlockToHostCodeMap(new_block);
+  s_blocks.emplace(new_block->key.bits, new_block);
+  s_async_compile_stats.installed_blocks++;
+
+  if (g_settings.cpu_recompiler_perf_map)
+  {
+    WritePerfMapBlockEntry(new_block);
+    FlushPerfMap();
+  }
+
+  if (g_settings.cpu_recompiler_block_prewarm)
+    AddBlockToPrewarmList(new_block);
+}
+
+void WritePerfMapEntry(const void* code, u32 code_size, const char* format, ...)
+{
+#ifdef __linux__
+  if (!s_perf_map_file)
+  {
+    const std::string filename = StringUtil::StdStringFromFormat("/tmp/perf-%d.map", static_cast<int>(getpid()));
+    s_perf_map_file = std::fopen(filename.c_str(), "w");
+    if (!s_perf_map_file)
+    {
+      Log_ErrorPrintf("Failed to open perf map '%s'", filename.c_str());
+      return;
+    }
+
+    Log_InfoPrintf("Writing recompiler symbols to '%s'", filename.c_str());
+  }
+
+  std::fprintf(s_perf_map_file, "%" PRIxPTR " %x ", reinterpret_cast<uintptr_t>(code), code_size);
+
+  std::va_list ap;
+  va_start(ap, format);
+  std::vfprintf(s_perf_map_file, format, ap);
+  va_end(ap);
+
+  std::fputc('\n', s_perf_map_file);
+#endif
+}
+
+void WritePerfMapDispatcherEntries()
+{
+  WritePerfMapEntry(s_perf_map_dispatcher_code, s_perf_map_dispatcher_code_size, "psx_dispatchers");
+  if (s_perf_map_dispatcher_far_code_size > 0)
+    WritePerfMapEntry(s_perf_map_dispatcher_far_code, s_perf_map_dispatcher_far_code_size, "psx_dispatchers_far");
+}
+
+void WritePerfMapBlockEntry(const CodeBlock* block)
+{
+  // perf only shows the first part of the name in most views, so put the address first.
+  const std::string& code = System::GetRunningCode();
+  WritePerfMapEntry(reinterpret_cast<const void*>(block->host_code), block->host_code_size, "psx_%08X_%s",
+                    block->GetPC(), code.empty() ? "bios" : code.c_str());
+  if (block->far_host_code_size > 0)
+  {
+    WritePerfMapEntry(block->far_host_code, block->far_host_code_size, "psx_%08X_%s_far", block->GetPC(),
+                      code.empty() ? "bios" : code.c_str());
+  }
+}
+
+void FlushPerfMap()
+{
+#ifdef __linux__
+  // perf can be attached while we're running, so don't hold entries back.
+  if (s_perf_map_file)
+    std::fflush(s_perf_map_file);
+#endif
+}
+
+void ClosePerfMap()
+{
+#ifdef __linux__
+  if (!s_perf_map_file)
+    return;
+
+  std::fclose(s_perf_map_file);
+  s_perf_map_file = nullptr;
+#endif
+}
+
+void RewritePerfMap()
+{
+  // Reopening truncates the file, then everything which still owns code space is written again.
+  ClosePerfMap();
+  WritePerfMapDispatcherEntries();
+  for (const auto& it : s_host_code_map)
+    WritePerfMapBlockEntry(it.second);
+
+  FlushPerfMap();
+}
+
+const AsyncCompileStats& GetAsyncCompileStats()
+{
+  return s_async_compile_stats;
+}
+
+CodeBlock::HostCodePointer GetBlockEntryPoint(const CodeBlock* block)
+{
+  return (block->host_code && !block->prewarmed) ? block->host_code : FastCompileBlockFunction;
+}
+
+const PromotionStats& GetPromotionStats()
+{
+  return s_promotion_stats;
+}
+
+#endif
+
+#ifdef WITH_RECOMPILER
+
+void FastCompileBlockFunction()
+{
+  if (IsUsingCompileThread())
+    InstallCompiledBlocks();
+
+  CodeBlock* block = LookupBlock(GetNextBlockKey());
+  if (block && (block->host_code || PromoteBlock(block)))
+  {
+    if (block->prewarmed)
+      MarkPrewarmedBlockExecuted(block);
+
+    s_single_block_asm_dispatcher(block->host_code);
+    return;
+  }
+
+  // PromoteBlock() clears the block if compilation failed.
+  if (block)
+  {
+    if (g_settings.cpu_recompiler_icache)
+      CheckAndUpdateICacheTags(block->icache_line_count, block->uncached_fetch_ticks);
+
+    if (g_settings.gpu_pgxp_enable)
+    {
+      if (g_settings.gpu_pgxp_cpu)
+        InterpretCachedBlock<PGXPMode::CPU>(*block);
+      else
+        InterpretCachedBlock<PGXPMode::Memory>(*block);
+    }
+    else
+    {
+      InterpretCachedBlock<PGXPMode::Disabled>(*block);
+    }
+
+    return;
+  }
+
+  if (g_settings.gpu_pgxp_enable)
+  {
+    if (g_settings.gpu_pgxp_cpu)
+      InterpretUncachedBlock<PGXPMode::CPU>();
+    else
+      InterpretUncachedBlock<PGXPMode::Memory>();
+  }
+  else
+  {
+    InterpretUncachedBlock<PGXPMode::Disabled>();
+  }
+}
+
+void InvalidCodeFunction()
+{
+  Log_ErrorPrintf("Trying to execute invalid code at 0x%08X", g_state.regs.pc);
+  if (g_settings.gpu_pgxp_enable)
+  {
+    if (g_settings.gpu_pgxp_cpu)
+      InterpretUncachedBlock<PGXPMode::CPU>();
+    else
+      InterpretUncachedBlock<PGXPMode::Memory>();
+  }
+  else
+  {
+    InterpretUncachedBlock<PGXPMode::Disabled>();
+  }
+}
+
+#endif
+
+void InvalidateBlock(CodeBlock* block)
+{
+  // Invalidate forces the block to be checked again.
+  Log_DebugPrintf("Invalidating block at 0x%08X", block->GetPC());
+  block->invalidated = true;
+
+  if (block->can_link)
+  {
+    const u32 frame_number = System::GetFrameNumber();
+    const u32 frame_diff = frame_number - block->invalidate_frame_number;
+    if (frame_diff <= INVALIDATE_THRESHOLD_TO_DISABLE_LINKING)
+    {
+      Log_DevPrintf("Block 0x%08X has been invalidated in %u frames, disabling linking", block->GetPC(), frame_diff);
+      block->can_link = false;
+    }
+    else
+    {
+      // It's been a while since this block was modified, so it's all good.
+      block->invalidate_frame_number = frame_number;
+    }
+  }
+
+  // Block will be re-added next execution. This also drops it from any other pages it spans.
+  RemoveBlockFromPageMap(block);
+  UnlinkBlock(block);
+
+#ifdef WITH_RECOMPILER
+  SetFastMap(block->GetPC(), FastCompileBlockFunction);
+#endif
+
+  s_smc_stats.invalidated_blocks++;
+}
+
+bool BlockOverlapsRange(const CodeBlock* block, PhysicalMemoryAddress start_address, PhysicalMemoryAddress end_address)
+{
+  if (!block->contains_traced_branches)
+  {
+    const PhysicalMemoryAddress block_start = block->key.GetPCPhysicalAddress();
+    const PhysicalMemoryAddress block_end = block_start + block->GetSizeInBytes();
+    return (block_start < end_address && start_address < block_end);
+  }
+
+  for (const CodeBlockInstruction& cbi : block->instructions)
+  {
+    const PhysicalMemoryAddress address = cbi.pc & PHYSICAL_MEMORY_ADDRESS_MASK;
+    if (address < end_address && start_address < (address + sizeof(u32)))
+      return true;
+  }
+
+  return false;
+}
+
+void InvalidateBlocksWithPageIndex(u32 page_index)
+{
+  DebugAssert(page_index < Bus::RAM_8MB_CODE_PAGE_COUNT);
+  auto& blocks = m_ram_block_map[page_index];
+  while (!blocks.empty())
+    InvalidateBlock(blocks.back());
+
+  Bus::ClearRAMCodePage(page_index);
+}
+
+void InvalidateBlocksWithRange(PhysicalMemoryAddress address, u32 size)
+{
+  const u32 page_index = address / HOST_PAGE_SIZE;
+  DebugAssert(page_index < Bus::RAM_8MB_CODE_PAGE_COUNT && ((address + size - 1) / HOST_PAGE_SIZE) == page_index);
+  s_smc_stats.code_page_writes++;
+
+  // Data which shares a page with code doesn't need to throw the code away.
+  const PhysicalMemoryAddress end_address = address + size;
+  const u32 start_subpage = address / CODE_SUBPAGE_SIZE;
+  const u32 end_subpage = (end_address - 1) / CODE_SUBPAGE_SIZE;
+  bool has_code = false;
+  for (u32 subpage = start_subpage; subpage <= end_subpage; subpage++)
+    has_code |= (s_ram_code_subpage_counts[subpage] != 0);
+  if (!has_code)
+  {
+    s_smc_stats.avoided_invalidations++;
+    return;
+  }
+
+  auto& blocks = m_ram_block_map[page_index];
+  for (size_t i = 0; i < blocks.size();)
+  {
+    CodeBlock* block = blocks[i];
+    if (!BlockOverlapsRange(block, address, end_address))
+    {
+      s_smc_stats.spared_blocks++;
+      i++;
+      continue;
+    }
+
+    // removes it from the page's list
+    InvalidateBlock(block);
+  }
+
+  if (blocks.empty())
+    Bus::ClearRAMCodePage(page_index);
+}
+
+const SMCStats& GetSMCStats()
+{
+  return s_smc_stats;
+}
+
+u32 GetContainingBlockPC(u32 pc)
+{
+  CodeBlockKey key = {};
+  key.SetPC(pc);
+  key.user_mode = InUserMode();
+
+  BlockMap::const_iterator iter = s_blocks.find(key.bits);
+  if (iter != s_blocks.end() && iter->second)
+    return pc;
+
+  // only RAM blocks are tracked by page, blocks elsewhere can only be found by their start address
+  const PhysicalMemoryAddress address = pc & PHYSICAL_MEMORY_ADDRESS_MASK;
+  if (address >= Bus::RAM_8MB_SIZE)
+    return pc;
+
+  const CodeBlock* found_block = nullptr;
+  for (const CodeBlock* block : m_ram_block_map[address / HOST_PAGE_SIZE])
+  {
+    if (block->key.user_mode != key.user_mode || (found_block && found_block->GetPC() > block->GetPC()))
+      continue;
+
+    for (const CodeBlockInstruction& cbi : block->instructions)
+    {
+      if (cbi.pc == pc)
+      {
+        found_block = block;
+        break;
+      }
+    }
+  }
+
+  return found_block ? found_block->GetPC() : pc;
 }
 
 void RemoveReferencesToBlock(CodeBlock* block)
 {
-  BlockMap::iterator iter = s_blocks.find(block->key.GetPC());
+  BlockMap::iterator iter = s_blocks.find(block->key.bits);
   Assert(iter != s_blocks.end() && iter->second == block);
 
 #ifdef WITH_RECOMPILER
@@ -896,18 +2334,64 @@ void RemoveReferencesToBlock(CodeBlock* block)
   s_blocks.erase(iter);
 }
 
+template<typename T>
+static void EnumerateBlockPages(const CodeBlock* block, const T& callback)
+{
+  if (!block->contains_traced_branches)
+  {
+    const u32 start_page = block->GetStartPageIndex();
+    const u32 end_page = block->GetEndPageIndex();
+    for (u32 page = start_page; page <= end_page; page++)
+      callback(page);
+
+    return;
+  }
+
+  // Traced blocks aren't contiguous, so visit each page which contains an instruction once.
+  std::array<u32, (MAX_TRACED_BRANCHES_PER_BLOCK + 1) * 2> pages;
+  u32 num_pages = 0;
+  for (const CodeBlockInstruction& cbi : block->instructions)
+  {
+    const u32 page = (cbi.pc & PHYSICAL_MEMORY_ADDRESS_MASK) / HOST_PAGE_SIZE;
+    if (std::find(pages.begin(), pages.begin() + num_pages, page) != pages.begin() + num_pages)
+      continue;
+
+    Assert(num_pages < pages.size());
+    pages[num_pages++] = page;
+    callback(page);
+  }
+}
+
+template<typename T>
+static void EnumerateBlockSubpages(const CodeBlock* block, const T& callback)
+{
+  if (!block->contains_traced_branches)
+  {
+    const u32 start_address = block->key.GetPCPhysicalAddress();
+    const u32 start_subpage = start_address / CODE_SUBPAGE_SIZE;
+    const u32 end_subpage = (start_address + block->GetSizeInBytes() - 1) / CODE_SUBPAGE_SIZE;
+    for (u32 subpage = start_subpage; subpage <= end_subpage; subpage++)
+      callback(subpage);
+
+    return;
+  }
+
+  // Visits subpages once per instruction, which is fine as long as adding and removing are symmetric.
+  for (const CodeBlockInstruction& cbi : block->instructions)
+    callback((cbi.pc & PHYSICAL_MEMORY_ADDRESS_MASK) / CODE_SUBPAGE_SIZE);
+}
+
 void AddBlockToPageMap(CodeBlock* block)
 {
   if (!block->IsInRAM())
     return;
 
-  const u32 start_page = block->GetStartPageIndex();
-  const u32 end_page = block->GetEndPageIndex();
-  for (u32 page = start_page; page <= end_page; page++)
-  {
+  EnumerateBlockPages(block, [block](u32 page) {
     m_ram_block_map[page].push_back(block);
     Bus::SetRAMCodePage(page);
-  }
+  });
+
+  EnumerateBlockSubpages(block, [](u32 subpage) { s_ram_code_subpage_counts[subpage]++; });
 }
 
 void RemoveBlockFromPageMap(CodeBlock* block)
@@ -915,15 +2399,17 @@ void RemoveBlockFromPageMap(CodeBlock* block)
   if (!block->IsInRAM())
     return;
 
-  const u32 start_page = block->GetStartPageIndex();
-  const u32 end_page = block->GetEndPageIndex();
-  for (u32 page = start_page; page <= end_page; page++)
-  {
+  EnumerateBlockPages(block, [block](u32 page) {
     auto& page_blocks = m_ram_block_map[page];
     auto page_block_iter = std::find(page_blocks.begin(), page_blocks.end(), block);
     Assert(page_block_iter != page_blocks.end());
     page_blocks.erase(page_block_iter);
-  }
+  });
+
+  EnumerateBlockSubpages(block, [](u32 subpage) {
+    DebugAssert(s_ram_code_subpage_counts[subpage] > 0);
+    s_ram_code_subpage_counts[subpage]--;
+  });
 }
 
 void LinkBlock(CodeBlock* from, CodeBlock* to, void* host_pc, void* host_resolve_pc, u32 host_pc_size)
@@ -1012,7 +2498,7 @@ void UnlinkBlock(CodeBlock* block)
 
 void AddBlockToHostCodeMap(CodeBlock* block)
 {
-  if (!g_settings.IsUsingRecompiler())
+  if (!g_settings.IsUsingRecompiler() || !block->host_code)
     return;
 
   auto ir = s_host_code_map.emplace(block->host_code, block);
@@ -1021,7 +2507,7 @@ void AddBlockToHostCodeMap(CodeBlock* block)
 
 void RemoveBlockFromHostCodeMap(CodeBlock* block)
 {
-  if (!g_settings.IsUsingRecompiler())
+  if (!g_settings.IsUsingRecompiler() || !block->host_code)
     return;
 
   HostCodeMap::iterator hc_iter = s_host_code_map.find(block->host_code);
@@ -1101,7 +2587,16 @@ Common::PageFaultHandler::HandlerResult MMapPageFaultHandler(void* exception_pc,
         const u32 code_page_index = Bus::GetRAMCodePageIndex(fastmem_address);
         if (Bus::IsRAMCodePage(code_page_index))
         {
-          if (++lbi.fault_count < CODE_WRITE_FAULT_THRESHOLD_FOR_SLOWMEM)
+          // The page stays protected while any block in it is valid, so data writes which don't touch code go
+          // through slowmem, where they're checked at subpage granularity.
+          const u32 ram_address = (fastmem_address & Bus::g_ram_mask) & ~UINT32_C(3);
+          if (s_ram_code_subpage_counts[ram_address / CODE_SUBPAGE_SIZE] == 0)
+          {
+            Log_DevPrintf("Backpatching data write at %p (%08X) address %p (%08X) in code page to slowmem",
+                          exception_pc, lbi.guest_pc, fault_address, fastmem_address);
+            s_smc_stats.avoided_invalidations++;
+          }
+          else if (++lbi.fault_count < CODE_WRITE_FAULT_THRESHOLD_FOR_SLOWMEM)
           {
             InvalidateBlocksWithPageIndex(code_page_index);
             return Common::PageFaultHandler::HandlerResult::ContinueExecution;
@@ -1191,10 +2686,18 @@ void CPU::Recompiler::Thunks::ResolveBranch(CodeBlock* block, void* host_pc, voi
 {
   using namespace CPU::CodeCache;
 
-  CodeBlockKey key = GetNextBlockKey();
-  CodeBlock* successor_block = LookupBlock(key);
-  if (!successor_block || (successor_block->invalidated && !RevalidateBlock(successor_block)) || !block->can_link ||
-      !successor_block->can_link)
+  // Never compile here. Compiling can evict or flush the calling block while we're still executing its far code.
+  // Branches to blocks which haven't been compiled, are being profiled in the interpreter, or need revalidating keep
+  // the resolver and return to the dispatcher, which sorts out the block. They're linked the next time they're taken.
+  auto iter = s_blocks.find(GetNextBlockKey().bits);
+  if (iter == s_blocks.end())
+    return;
+
+  CodeBlock* successor_block = iter->second;
+  if (successor_block && (successor_block->invalidated || !successor_block->host_code))
+    return;
+
+  if (!successor_block || !block->can_link || !successor_block->can_link)
   {
     // just turn it into a return to the dispatcher instead.
     s_code_buffer.WriteProtect(false);
@@ -1203,11 +2706,20 @@ void CPU::Recompiler::Thunks::ResolveBranch(CodeBlock* block, void* host_pc, voi
   }
   else
   {
+    // later runs go through the link instead of the dispatcher, so count it here
+    if (successor_block->prewarmed)
+      MarkPrewarmedBlockExecuted(successor_block);
+
     // link blocks!
     LinkBlock(block, successor_block, host_pc, host_resolve_pc, host_pc_size);
   }
 }
 
+void CPU::Recompiler::Thunks::SkipIdleLoop()
+{
+  CPU::CodeCache::SkipIdleLoop();
+}
+
 void CPU::Recompiler::Thunks::LogPC(u32 pc)
 {
 #if 0
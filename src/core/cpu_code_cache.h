@@ -4,6 +4,7 @@
 #include "common/jit_code_buffer.h"
 #include "common/page_fault_handler.h"
 #include "cpu_types.h"
+#include <algorithm>
 #include <array>
 #include <map>
 #include <memory>
@@ -54,6 +55,24 @@ struct CodeBlockInstruction
   bool is_last_instruction : 1;
   bool has_load_delay : 1;
   bool can_trap : 1;
+  bool is_traced_branch : 1;
+  bool is_dead_write : 1;
+  bool skip_load_delay : 1;
+};
+
+struct CodeBlockPredecodedInstruction
+{
+  using Handler = void (*)(const CodeBlockPredecodedInstruction&);
+
+  Handler handler;
+  Instruction instruction;
+  u32 pc;
+  u32 imm; // extended immediate, shift amount or jump target
+
+  Reg rs;
+  Reg rt;
+  Reg rd;
+  bool is_branch_delay_slot;
 };
 
 struct CodeBlock
@@ -78,21 +97,34 @@ struct CodeBlock
   std::vector<LinkInfo> link_predecessors;
   std::vector<LinkInfo> link_successors;
 
+  // Handlers for the cached interpreter, filled when predecoding is enabled.
+  std::vector<CodeBlockPredecodedInstruction> predecoded_instructions;
+  PGXPMode predecoded_pgxp_mode = PGXPMode::Disabled;
+
   TickCount uncached_fetch_ticks = 0;
   u32 icache_line_count = 0;
 
 #ifdef WITH_RECOMPILER
   std::vector<Recompiler::LoadStoreBackpatchInfo> loadstore_backpatch_info;
+
+  // Slow paths and block exits, only kept for the perf map.
+  const void* far_host_code = nullptr;
+  u32 far_host_code_size = 0;
 #endif
 
   bool contains_loadstore_instructions = false;
   bool contains_double_branches = false;
+  bool contains_traced_branches = false;
+  bool is_idle_loop = false;
+  bool compile_pending = false;
   bool invalidated = false;
   bool can_link = true;
+  bool prewarmed = false; // compiled from the prewarm list, and not executed yet
 
   u32 recompile_frame_number = 0;
   u32 recompile_count = 0;
   u32 invalidate_frame_number = 0;
+  u32 execution_count = 0;
 
   const u32 GetPC() const { return key.GetPC(); }
   const u32 GetSizeInBytes() const { return static_cast<u32>(instructions.size()) * sizeof(Instruction); }
@@ -115,6 +147,9 @@ enum : u32
   FAST_MAP_TABLE_COUNT = 0x10000,
   FAST_MAP_TABLE_SIZE = 0x10000 / 4, // 16384
   FAST_MAP_TABLE_SHIFT = 16,
+
+  // Granularity of self-modifying code checks within a page.
+  CODE_SUBPAGE_SIZE = 256,
 };
 
 using FastMapTable = CodeBlock::HostCodePointer*;
@@ -129,6 +164,10 @@ using SingleBlockDispatcherFunction = void(*)(const CodeBlock::HostCodePointer);
 
 FastMapTable* GetFastMapPointer();
 void ExecuteRecompiler();
+
+/// Runs random register files through the recompiler's inline GTE code and the GTE, and compares the results.
+/// Returns the number of commands which differed.
+u32 CompareInlineGTEInstructions(u32 iterations, u32 seed);
 #endif
 
 /// Flushes the code cache, forcing all blocks to be recompiled.
@@ -137,9 +176,85 @@ void Flush();
 /// Changes whether the recompiler is enabled.
 void Reinitialize();
 
+#ifdef WITH_RECOMPILER
+struct PrewarmStats
+{
+  u32 entries;   // blocks known for the running game
+  u32 pending;   // blocks loaded from disk which have not been compiled yet
+  u32 prewarmed; // blocks compiled ahead of execution from the prewarm list
+  u32 executed;  // prewarmed blocks which were later executed
+  u32 misses;    // blocks which had to be compiled on first execution
+};
+
+/// Returns statistics for the block prewarm list of the running game.
+const PrewarmStats& GetPrewarmStats();
+
+/// Writes the block prewarm list for the running game to disk, if it has changed.
+void SavePrewarmList();
+
+struct PromotionStats
+{
+  u32 interpreted_blocks; // blocks which were decoded, but ran in the cached interpreter
+  u32 promoted_blocks;    // blocks which crossed the execution threshold and were compiled
+};
+
+/// Returns the number of blocks which have been promoted from the cached interpreter to the recompiler.
+const PromotionStats& GetPromotionStats();
+
+struct EvictionStats
+{
+  u32 evicted_regions; // code buffer regions which were reclaimed because the buffer was full
+  u32 evicted_blocks;  // blocks discarded by reclaiming regions, which will be recompiled on their next execution
+};
+
+/// Returns statistics for partial evictions of the code buffer.
+const EvictionStats& GetEvictionStats();
+
+struct AsyncCompileStats
+{
+  u32 queued_blocks;    // blocks sent to the background compile thread
+  u32 installed_blocks; // compiled blocks which replaced the interpreted block
+  u32 discarded_blocks; // compiled blocks which were dropped because the guest code changed in the meantime
+};
+
+/// Returns statistics for background block compilation.
+const AsyncCompileStats& GetAsyncCompileStats();
+#endif
+
+struct IdleLoopStats
+{
+  u32 detected_loops;            // blocks which were recognized as idle loops
+  u32 skipped_loops;             // times an idle loop skipped ahead to the next event
+  TickCount frame_skipped_ticks; // CPU ticks skipped during the last frame
+  u64 skipped_ticks;             // CPU ticks skipped since the code cache was initialized
+};
+
+/// Returns statistics for idle loop skipping.
+const IdleLoopStats& GetIdleLoopStats();
+
 /// Invalidates all blocks which are in the range of the specified code page.
 void InvalidateBlocksWithPageIndex(u32 page_index);
 
+/// Invalidates blocks which overlap the specified range of RAM. The range must not cross a page.
+void InvalidateBlocksWithRange(PhysicalMemoryAddress address, u32 size);
+
+struct SMCStats
+{
+  u32 code_page_writes;      // writes to RAM pages which contain code
+  u32 avoided_invalidations; // writes to code pages which didn't overlap any code
+  u32 invalidated_blocks;    // blocks invalidated because they were overwritten
+  u32 spared_blocks;         // blocks kept because the write to their page didn't overlap them
+};
+
+/// Returns statistics for self-modifying code detection.
+const SMCStats& GetSMCStats();
+
+/// Returns the start address of the block which contains the instruction at pc, or pc if it isn't in a known block.
+u32 GetContainingBlockPC(u32 pc);
+
+/// Builds the handler table used by the cached interpreter for a decoded block.
+void PredecodeBlock(CodeBlock* block);
+
 template<PGXPMode pgxp_mode>
 void InterpretCachedBlock(const CodeBlock& block);
 
@@ -149,12 +264,17 @@ void InterpretUncachedBlock();
 /// Invalidates any code pages which overlap the specified range.
 ALWAYS_INLINE void InvalidateCodePages(PhysicalMemoryAddress address, u32 word_count)
 {
+  const u32 end_address = address + word_count * sizeof(u32);
   const u32 start_page = address / HOST_PAGE_SIZE;
-  const u32 end_page = (address + word_count * sizeof(u32) - sizeof(u32)) / HOST_PAGE_SIZE;
+  const u32 end_page = (end_address - sizeof(u32)) / HOST_PAGE_SIZE;
   for (u32 page = start_page; page <= end_page; page++)
   {
     if (Bus::m_ram_code_bits[page])
-      CPU::CodeCache::InvalidateBlocksWithPageIndex(page);
+    {
+      const u32 range_start = std::max<u32>(address, page * HOST_PAGE_SIZE);
+      const u32 range_end = std::min<u32>(end_address, (page + 1) * HOST_PAGE_SIZE);
+      CPU::CodeCache::InvalidateBlocksWithRange(range_start, range_end - range_start);
+    }
   }
 }
 
@@ -6,6 +6,7 @@
 #include "common/state_wrapper.h"
 #include "cpu_core_private.h"
 #include "cpu_disasm.h"
+#include "cpu_profiler.h"
 #include "cpu_recompiler_thunks.h"
 #include "gte.h"
 #include "host_interface.h"
@@ -107,6 +108,7 @@ void Shutdown()
 {
   ClearBreakpoints();
   StopTrace();
+  Profiler::Stop();
 }
 
 void Reset()
@@ -1981,11 +1983,610 @@ void SingleStep()
 
 namespace CodeCache {
 
+// Handlers for the predecoded cached interpreter. Operands are extracted when the block is compiled, so the common
+// instructions which can't trap skip the decode in ExecuteInstruction(). Everything else goes through it as normal.
+namespace PredecodedHandlers {
+
+using PI = CodeBlockPredecodedInstruction;
+
+template<PGXPMode pgxp_mode>
+static void Generic(const PI& pi)
+{
+  ExecuteInstruction<pgxp_mode, false>();
+}
+
+static void nop(const PI& pi) {}
+
+template<PGXPMode pgxp_mode>
+static void sll(const PI& pi)
+{
+  const u32 new_value = ReadReg(pi.rt) << pi.imm;
+  if constexpr (pgxp_mode >= PGXPMode::CPU)
+    PGXP::CPU_SLL(pi.instruction.bits, ReadReg(pi.rt));
+
+  WriteReg(pi.rd, new_value);
+}
+
+template<PGXPMode pgxp_mode>
+static void srl(const PI& pi)
+{
+  const u32 new_value = ReadReg(pi.rt) >> pi.imm;
+  if constexpr (pgxp_mode >= PGXPMode::CPU)
+    PGXP::CPU_SRL(pi.instruction.bits, ReadReg(pi.rt));
+
+  WriteReg(pi.rd, new_value);
+}
+
+template<PGXPMode pgxp_mode>
+static void sra(const PI& pi)
+{
+  const u32 new_value = static_cast<u32>(static_cast<s32>(ReadReg(pi.rt)) >> pi.imm);
+  if constexpr (pgxp_mode >= PGXPMode::CPU)
+    PGXP::CPU_SRA(pi.instruction.bits, ReadReg(pi.rt));
+
+  WriteReg(pi.rd, new_value);
+}
+
+template<PGXPMode pgxp_mode>
+static void and_(const PI& pi)
+{
+  const u32 new_value = ReadReg(pi.rs) & ReadReg(pi.rt);
+  if constexpr (pgxp_mode >= PGXPMode::CPU)
+    PGXP::CPU_AND_(pi.instruction.bits, ReadReg(pi.rs), ReadReg(pi.rt));
+
+  WriteReg(pi.rd, new_value);
+}
+
+template<PGXPMode pgxp_mode>
+static void or_(const PI& pi)
+{
+  const u32 new_value = ReadReg(pi.rs) | ReadReg(pi.rt);
+  if constexpr (pgxp_mode >= PGXPMode::CPU)
+    PGXP::CPU_OR_(pi.instruction.bits, ReadReg(pi.rs), ReadReg(pi.rt));
+
+  WriteReg(pi.rd, new_value);
+}
+
+template<PGXPMode pgxp_mode>
+static void xor_(const PI& pi)
+{
+  const u32 new_value = ReadReg(pi.rs) ^ ReadReg(pi.rt);
+  if constexpr (pgxp_mode >= PGXPMode::CPU)
+    PGXP::CPU_XOR_(pi.instruction.bits, ReadReg(pi.rs), ReadReg(pi.rt));
+
+  WriteReg(pi.rd, new_value);
+}
+
+template<PGXPMode pgxp_mode>
+static void nor(const PI& pi)
+{
+  const u32 new_value = ~(ReadReg(pi.rs) | ReadReg(pi.rt));
+  if constexpr (pgxp_mode >= PGXPMode::CPU)
+    PGXP::CPU_NOR(pi.instruction.bits, ReadReg(pi.rs), ReadReg(pi.rt));
+
+  WriteReg(pi.rd, new_value);
+}
+
+template<PGXPMode pgxp_mode>
+static void addu(const PI& pi)
+{
+  const u32 old_value = ReadReg(pi.rs);
+  const u32 add_value = ReadReg(pi.rt);
+  const u32 new_value = old_value + add_value;
+  if constexpr (pgxp_mode >= PGXPMode::CPU)
+    PGXP::CPU_ADD(pi.instruction.bits, old_value, add_value);
+  else if constexpr (pgxp_mode >= PGXPMode::Memory)
+  {
+    if (add_value == 0)
+      PGXP::CPU_MOVE((static_cast<u32>(pi.rd) << 8) | static_cast<u32>(pi.rs), old_value);
+  }
+
+  WriteReg(pi.rd, new_value);
+}
+
+template<PGXPMode pgxp_mode>
+static void subu(const PI& pi)
+{
+  const u32 new_value = ReadReg(pi.rs) - ReadReg(pi.rt);
+  if constexpr (pgxp_mode >= PGXPMode::CPU)
+    PGXP::CPU_SUB(pi.instruction.bits, ReadReg(pi.rs), ReadReg(pi.rt));
+
+  WriteReg(pi.rd, new_value);
+}
+
+template<PGXPMode pgxp_mode>
+static void slt(const PI& pi)
+{
+  const u32 result = BoolToUInt32(static_cast<s32>(ReadReg(pi.rs)) < static_cast<s32>(ReadReg(pi.rt)));
+  if constexpr (pgxp_mode >= PGXPMode::CPU)
+    PGXP::CPU_SLT(pi.instruction.bits, ReadReg(pi.rs), ReadReg(pi.rt));
+
+  WriteReg(pi.rd, result);
+}
+
+template<PGXPMode pgxp_mode>
+static void sltu(const PI& pi)
+{
+  const u32 result = BoolToUInt32(ReadReg(pi.rs) < ReadReg(pi.rt));
+  if constexpr (pgxp_mode >= PGXPMode::CPU)
+    PGXP::CPU_SLTU(pi.instruction.bits, ReadReg(pi.rs), ReadReg(pi.rt));
+
+  WriteReg(pi.rd, result);
+}
+
+static void jr(const PI& pi)
+{
+  g_state.next_instruction_is_branch_delay_slot = true;
+  Branch(ReadReg(pi.rs));
+}
+
+template<PGXPMode pgxp_mode>
+static void lui(const PI& pi)
+{
+  WriteReg(pi.rt, pi.imm);
+
+  if constexpr (pgxp_mode >= PGXPMode::CPU)
+    PGXP::CPU_LUI(pi.instruction.bits);
+}
+
+template<PGXPMode pgxp_mode>
+static void andi(const PI& pi)
+{
+  const u32 new_value = ReadReg(pi.rs) & pi.imm;
+
+  if constexpr (pgxp_mode >= PGXPMode::CPU)
+    PGXP::CPU_ANDI(pi.instruction.bits, ReadReg(pi.rs));
+
+  WriteReg(pi.rt, new_value);
+}
+
+template<PGXPMode pgxp_mode>
+static void ori(const PI& pi)
+{
+  const u32 new_value = ReadReg(pi.rs) | pi.imm;
+
+  if constexpr (pgxp_mode >= PGXPMode::CPU)
+    PGXP::CPU_ORI(pi.instruction.bits, ReadReg(pi.rs));
+
+  WriteReg(pi.rt, new_value);
+}
+
+template<PGXPMode pgxp_mode>
+static void xori(const PI& pi)
+{
+  const u32 new_value = ReadReg(pi.rs) ^ pi.imm;
+
+  if constexpr (pgxp_mode >= PGXPMode::CPU)
+    PGXP::CPU_XORI(pi.instruction.bits, ReadReg(pi.rs));
+
+  WriteReg(pi.rt, new_value);
+}
+
+template<PGXPMode pgxp_mode>
+static void addiu(const PI& pi)
+{
+  const u32 old_value = ReadReg(pi.rs);
+  const u32 new_value = old_value + pi.imm;
+
+  if constexpr (pgxp_mode >= PGXPMode::CPU)
+    PGXP::CPU_ADDI(pi.instruction.bits, old_value);
+  else if constexpr (pgxp_mode >= PGXPMode::Memory)
+  {
+    if (pi.imm == 0)
+      PGXP::CPU_MOVE((static_cast<u32>(pi.rt) << 8) | static_cast<u32>(pi.rs), old_value);
+  }
+
+  WriteReg(pi.rt, new_value);
+}
+
+template<PGXPMode pgxp_mode>
+static void slti(const PI& pi)
+{
+  const u32 result = BoolToUInt32(static_cast<s32>(ReadReg(pi.rs)) < static_cast<s32>(pi.imm));
+
+  if constexpr (pgxp_mode >= PGXPMode::CPU)
+    PGXP::CPU_SLTI(pi.instruction.bits, ReadReg(pi.rs));
+
+  WriteReg(pi.rt, result);
+}
+
+template<PGXPMode pgxp_mode>
+static void sltiu(const PI& pi)
+{
+  const u32 result = BoolToUInt32(ReadReg(pi.rs) < pi.imm);
+
+  if constexpr (pgxp_mode >= PGXPMode::CPU)
+    PGXP::CPU_SLTIU(pi.instruction.bits, ReadReg(pi.rs));
+
+  WriteReg(pi.rt, result);
+}
+
+template<PGXPMode pgxp_mode>
+static void lb(const PI& pi)
+{
+  const VirtualMemoryAddress addr = ReadReg(pi.rs) + pi.imm;
+  u8 value;
+  if (!ReadMemoryByte(addr, &value))
+    return;
+
+  const u32 sxvalue = SignExtend32(value);
+  WriteRegDelayed(pi.rt, sxvalue);
+
+  if constexpr (pgxp_mode >= PGXPMode::Memory)
+    PGXP::CPU_LBx(pi.instruction.bits, sxvalue, addr);
+}
+
+template<PGXPMode pgxp_mode>
+static void lh(const PI& pi)
+{
+  const VirtualMemoryAddress addr = ReadReg(pi.rs) + pi.imm;
+  u16 value;
+  if (!ReadMemoryHalfWord(addr, &value))
+    return;
+
+  const u32 sxvalue = SignExtend32(value);
+  WriteRegDelayed(pi.rt, sxvalue);
+
+  if constexpr (pgxp_mode >= PGXPMode::Memory)
+    PGXP::CPU_LHx(pi.instruction.bits, sxvalue, addr);
+}
+
+template<PGXPMode pgxp_mode>
+static void lw(const PI& pi)
+{
+  const VirtualMemoryAddress addr = ReadReg(pi.rs) + pi.imm;
+  u32 value;
+  if (!ReadMemoryWord(addr, &value))
+    return;
+
+  WriteRegDelayed(pi.rt, value);
+
+  if constexpr (pgxp_mode >= PGXPMode::Memory)
+    PGXP::CPU_LW(pi.instruction.bits, value, addr);
+}
+
+template<PGXPMode pgxp_mode>
+static void lbu(const PI& pi)
+{
+  const VirtualMemoryAddress addr = ReadReg(pi.rs) + pi.imm;
+  u8 value;
+  if (!ReadMemoryByte(addr, &value))
+    return;
+
+  const u32 zxvalue = ZeroExtend32(value);
+  WriteRegDelayed(pi.rt, zxvalue);
+
+  if constexpr (pgxp_mode >= PGXPMode::Memory)
+    PGXP::CPU_LBx(pi.instruction.bits, zxvalue, addr);
+}
+
+template<PGXPMode pgxp_mode>
+static void lhu(const PI& pi)
+{
+  const VirtualMemoryAddress addr = ReadReg(pi.rs) + pi.imm;
+  u16 value;
+  if (!ReadMemoryHalfWord(addr, &value))
+    return;
+
+  const u32 zxvalue = ZeroExtend32(value);
+  WriteRegDelayed(pi.rt, zxvalue);
+
+  if constexpr (pgxp_mode >= PGXPMode::Memory)
+    PGXP::CPU_LHx(pi.instruction.bits, zxvalue, addr);
+}
+
+template<PGXPMode pgxp_mode>
+static void sb(const PI& pi)
+{
+  const VirtualMemoryAddress addr = ReadReg(pi.rs) + pi.imm;
+  const u32 value = ReadReg(pi.rt);
+  WriteMemoryByte(addr, value);
+
+  if constexpr (pgxp_mode >= PGXPMode::Memory)
+    PGXP::CPU_SB(pi.instruction.bits, Truncate8(value), addr);
+}
+
+template<PGXPMode pgxp_mode>
+static void sh(const PI& pi)
+{
+  const VirtualMemoryAddress addr = ReadReg(pi.rs) + pi.imm;
+  const u32 value = ReadReg(pi.rt);
+  WriteMemoryHalfWord(addr, value);
+
+  if constexpr (pgxp_mode >= PGXPMode::Memory)
+    PGXP::CPU_SH(pi.instruction.bits, Truncate16(value), addr);
+}
+
+template<PGXPMode pgxp_mode>
+static void sw(const PI& pi)
+{
+  const VirtualMemoryAddress addr = ReadReg(pi.rs) + pi.imm;
+  const u32 value = ReadReg(pi.rt);
+  WriteMemoryWord(addr, value);
+
+  if constexpr (pgxp_mode >= PGXPMode::Memory)
+    PGXP::CPU_SW(pi.instruction.bits, value, addr);
+}
+
+// Branch targets are relative to the pc at execution time, not the instruction's address, because of double branches.
+static void j(const PI& pi)
+{
+  g_state.next_instruction_is_branch_delay_slot = true;
+  Branch((g_state.regs.pc & UINT32_C(0xF0000000)) | pi.imm);
+}
+
+static void jal(const PI& pi)
+{
+  WriteReg(Reg::ra, g_state.regs.npc);
+  g_state.next_instruction_is_branch_delay_slot = true;
+  Branch((g_state.regs.pc & UINT32_C(0xF0000000)) | pi.imm);
+}
+
+static void beq(const PI& pi)
+{
+  g_state.next_instruction_is_branch_delay_slot = true;
+  if (ReadReg(pi.rs) == ReadReg(pi.rt))
+    Branch(g_state.regs.pc + pi.imm);
+}
+
+static void bne(const PI& pi)
+{
+  g_state.next_instruction_is_branch_delay_slot = true;
+  if (ReadReg(pi.rs) != ReadReg(pi.rt))
+    Branch(g_state.regs.pc + pi.imm);
+}
+
+static void bgtz(const PI& pi)
+{
+  g_state.next_instruction_is_branch_delay_slot = true;
+  if (static_cast<s32>(ReadReg(pi.rs)) > 0)
+    Branch(g_state.regs.pc + pi.imm);
+}
+
+static void blez(const PI& pi)
+{
+  g_state.next_instruction_is_branch_delay_slot = true;
+  if (static_cast<s32>(ReadReg(pi.rs)) <= 0)
+    Branch(g_state.regs.pc + pi.imm);
+}
+
+} // namespace PredecodedHandlers
+
+template<PGXPMode pgxp_mode>
+static void PredecodeInstruction(CodeBlockPredecodedInstruction* pi)
+{
+  namespace H = PredecodedHandlers;
+
+  const Instruction inst = pi->instruction;
+  pi->handler = &H::Generic<pgxp_mode>;
+  pi->imm = 0;
+  if (inst.bits == 0)
+  {
+    pi->handler = &H::nop;
+    return;
+  }
+
+  switch (inst.op)
+  {
+    case InstructionOp::funct:
+    {
+      switch (inst.r.funct)
+      {
+        case InstructionFunct::sll:
+          pi->handler = &H::sll<pgxp_mode>;
+          pi->imm = inst.r.shamt;
+          break;
+        case InstructionFunct::srl:
+          pi->handler = &H::srl<pgxp_mode>;
+          pi->imm = inst.r.shamt;
+          break;
+        case InstructionFunct::sra:
+          pi->handler = &H::sra<pgxp_mode>;
+          pi->imm = inst.r.shamt;
+          break;
+        case InstructionFunct::and_:
+          pi->handler = &H::and_<pgxp_mode>;
+          break;
+        case InstructionFunct::or_:
+          pi->handler = &H::or_<pgxp_mode>;
+          break;
+        case InstructionFunct::xor_:
+          pi->handler = &H::xor_<pgxp_mode>;
+          break;
+        case InstructionFunct::nor:
+          pi->handler = &H::nor<pgxp_mode>;
+          break;
+        case InstructionFunct::addu:
+          pi->handler = &H::addu<pgxp_mode>;
+          break;
+        case InstructionFunct::subu:
+          pi->handler = &H::subu<pgxp_mode>;
+          break;
+        case InstructionFunct::slt:
+          pi->handler = &H::slt<pgxp_mode>;
+          break;
+        case InstructionFunct::sltu:
+          pi->handler = &H::sltu<pgxp_mode>;
+          break;
+        case InstructionFunct::jr:
+          pi->handler = &H::jr;
+          break;
+        default:
+          break;
+      }
+    }
+    break;
+
+    case InstructionOp::lui:
+      pi->handler = &H::lui<pgxp_mode>;
+      pi->imm = inst.i.imm_zext32() << 16;
+      break;
+    case InstructionOp::andi:
+      pi->handler = &H::andi<pgxp_mode>;
+      pi->imm = inst.i.imm_zext32();
+      break;
+    case InstructionOp::ori:
+      pi->handler = &H::ori<pgxp_mode>;
+      pi->imm = inst.i.imm_zext32();
+      break;
+    case InstructionOp::xori:
+      pi->handler = &H::xori<pgxp_mode>;
+      pi->imm = inst.i.imm_zext32();
+      break;
+    case InstructionOp::addiu:
+      pi->handler = &H::addiu<pgxp_mode>;
+      pi->imm = inst.i.imm_sext32();
+      break;
+    case InstructionOp::slti:
+      pi->handler = &H::slti<pgxp_mode>;
+      pi->imm = inst.i.imm_sext32();
+      break;
+    case InstructionOp::sltiu:
+      pi->handler = &H::sltiu<pgxp_mode>;
+      pi->imm = inst.i.imm_sext32();
+      break;
+    case InstructionOp::lb:
+      pi->handler = &H::lb<pgxp_mode>;
+      pi->imm = inst.i.imm_sext32();
+      break;
+    case InstructionOp::lh:
+      pi->handler = &H::lh<pgxp_mode>;
+      pi->imm = inst.i.imm_sext32();
+      break;
+    case InstructionOp::lw:
+      pi->handler = &H::lw<pgxp_mode>;
+      pi->imm = inst.i.imm_sext32();
+      break;
+    case InstructionOp::lbu:
+      pi->handler = &H::lbu<pgxp_mode>;
+      pi->imm = inst.i.imm_sext32();
+      break;
+    case InstructionOp::lhu:
+      pi->handler = &H::lhu<pgxp_mode>;
+      pi->imm = inst.i.imm_sext32();
+      break;
+    case InstructionOp::sb:
+      pi->handler = &H::sb<pgxp_mode>;
+      pi->imm = inst.i.imm_sext32();
+      break;
+    case InstructionOp::sh:
+      pi->handler = &H::sh<pgxp_mode>;
+      pi->imm = inst.i.imm_sext32();
+      break;
+    case InstructionOp::sw:
+      pi->handler = &H::sw<pgxp_mode>;
+      pi->imm = inst.i.imm_sext32();
+      break;
+    case InstructionOp::j:
+      pi->handler = &H::j;
+      pi->imm = inst.j.target << 2;
+      break;
+    case InstructionOp::jal:
+      pi->handler = &H::jal;
+      pi->imm = inst.j.target << 2;
+      break;
+    case InstructionOp::beq:
+      pi->handler = &H::beq;
+      pi->imm = inst.i.imm_sext32() << 2;
+      break;
+    case InstructionOp::bne:
+      pi->handler = &H::bne;
+      pi->imm = inst.i.imm_sext32() << 2;
+      break;
+    case InstructionOp::bgtz:
+      pi->handler = &H::bgtz;
+      pi->imm = inst.i.imm_sext32() << 2;
+      break;
+    case InstructionOp::blez:
+      pi->handler = &H::blez;
+      pi->imm = inst.i.imm_sext32() << 2;
+      break;
+    default:
+      break;
+  }
+}
+
+void PredecodeBlock(CodeBlock* block)
+{
+  const PGXPMode pgxp_mode =
+    g_settings.gpu_pgxp_enable ? (g_settings.gpu_pgxp_cpu ? PGXPMode::CPU : PGXPMode::Memory) : PGXPMode::Disabled;
+
+  block->predecoded_pgxp_mode = pgxp_mode;
+  block->predecoded_instructions.clear();
+  block->predecoded_instructions.reserve(block->instructions.size());
+  for (const CodeBlockInstruction& cbi : block->instructions)
+  {
+    CodeBlockPredecodedInstruction pi = {};
+    pi.instruction.bits = cbi.instruction.bits;
+    pi.pc = cbi.pc;
+    pi.rs = cbi.instruction.r.rs;
+    pi.rt = cbi.instruction.r.rt;
+    pi.rd = cbi.instruction.r.rd;
+    pi.is_branch_delay_slot = cbi.is_branch_delay_slot;
+
+    switch (pgxp_mode)
+    {
+      case PGXPMode::CPU:
+        PredecodeInstruction<PGXPMode::CPU>(&pi);
+        break;
+      case PGXPMode::Memory:
+        PredecodeInstruction<PGXPMode::Memory>(&pi);
+        break;
+      default:
+        PredecodeInstruction<PGXPMode::Disabled>(&pi);
+        break;
+    }
+
+    block->predecoded_instructions.push_back(pi);
+  }
+}
+
+template<PGXPMode pgxp_mode>
+static void InterpretPredecodedBlock(const CodeBlock& block)
+{
+  g_state.regs.npc = block.GetPC() + 4;
+
+  for (const CodeBlockPredecodedInstruction& pi : block.predecoded_instructions)
+  {
+    g_state.pending_ticks++;
+
+    // now executing the instruction we previously fetched
+    g_state.current_instruction.bits = pi.instruction.bits;
+    g_state.current_instruction_pc = pi.pc;
+    g_state.current_instruction_in_branch_delay_slot = pi.is_branch_delay_slot;
+    g_state.current_instruction_was_branch_taken = g_state.branch_was_taken;
+    g_state.branch_was_taken = false;
+    g_state.exception_raised = false;
+
+    // update pc
+    g_state.regs.pc = g_state.regs.npc;
+    g_state.regs.npc += 4;
+
+    // dispatch straight to the handler, the instruction has already been decoded
+    pi.handler(pi);
+
+    // next load delay
+    UpdateLoadDelay();
+
+    if (g_state.exception_raised)
+      break;
+  }
+
+  // cleanup so the interpreter can kick in if needed
+  g_state.next_instruction_is_branch_delay_slot = false;
+}
+
 template<PGXPMode pgxp_mode>
 void InterpretCachedBlock(const CodeBlock& block)
 {
   // set up the state so we've already fetched the instruction
   DebugAssert(g_state.regs.pc == block.GetPC());
+  if (block.predecoded_pgxp_mode == pgxp_mode && !block.predecoded_instructions.empty())
+  {
+    InterpretPredecodedBlock<pgxp_mode>(block);
+    return;
+  }
+
   g_state.regs.npc = block.GetPC() + 4;
 
   for (const CodeBlockInstruction& cbi : block.instructions)
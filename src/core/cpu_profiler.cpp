@@ -0,0 +1,234 @@
+#include "cpu_profiler.h"
+#include "bus.h"
+#include "common/file_system.h"
+#include "common/log.h"
+#include "common/string_util.h"
+#include "cpu_code_cache.h"
+#include "cpu_core.h"
+#include "host_interface.h"
+#include "system.h"
+#include "timing_event.h"
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+Log_SetChannel(CPU::Profiler);
+
+namespace CPU::Profiler {
+
+// Samples are taken from a timing event, so they are evenly spaced in guest time regardless of the execution mode. The
+// recompilers only run events between blocks, so in practice the sampled pc is the start of the next block to run.
+// There is no reliable way to walk the guest stack, so the caller is guessed from ra. This is accurate for leaf
+// functions, which are usually the interesting ones for HLE, but non-leaf functions will show the last call they made.
+
+struct Symbol
+{
+  PhysicalMemoryAddress address;
+  std::string name;
+};
+
+static void LoadSymbols();
+static const Symbol* LookupSymbol(u32 pc);
+static std::string GetFrameName(u32 pc);
+static void SampleEvent(void*, TickCount ticks, TickCount ticks_late);
+static void WriteProfile();
+
+static std::unique_ptr<TimingEvent> s_sample_event;
+static TickCount s_sample_period = 0;
+static u32 s_jitter_state = 0;
+static u32 s_sample_count = 0;
+
+// (caller block << 32) | block, caller block is zero when ra isn't a plausible return address
+static std::unordered_map<u64, u32> s_samples;
+static std::vector<Symbol> s_symbols;
+
+void Start(u32 sample_rate /* = DEFAULT_SAMPLE_RATE */)
+{
+  if (s_sample_event)
+    return;
+
+  s_sample_period = std::max<TickCount>(System::GetTicksPerSecond() / static_cast<TickCount>(sample_rate), 1);
+  s_jitter_state = 0x9E3779B9u;
+  s_sample_count = 0;
+  s_samples.clear();
+  LoadSymbols();
+
+  s_sample_event = TimingEvents::CreateTimingEvent("CPU Profiler", s_sample_period, s_sample_period, SampleEvent,
+                                                   nullptr, true);
+  Log_InfoPrintf("Started profiling at %u samples per second", sample_rate);
+}
+
+void Stop()
+{
+  if (!s_sample_event)
+    return;
+
+  s_sample_event.reset();
+  WriteProfile();
+
+  s_samples = {};
+  s_symbols = {};
+}
+
+bool IsActive()
+{
+  return static_cast<bool>(s_sample_event);
+}
+
+u32 GetSampleCount()
+{
+  return s_sample_count;
+}
+
+std::string GetProfilePath()
+{
+  return g_host_interface->GetUserDirectoryRelativePath("cpu_profile.txt");
+}
+
+void SampleEvent(void*, TickCount ticks, TickCount ticks_late)
+{
+  const u32 pc = g_state.regs.pc;
+  const u32 block_pc = CodeCache::GetContainingBlockPC(pc);
+
+  // jal/jalr store the address after the delay slot, so the call is two instructions back
+  const u32 ra = g_state.regs.ra;
+  const PhysicalMemoryAddress ra_address = ra & PHYSICAL_MEMORY_ADDRESS_MASK;
+  u32 caller_pc = 0;
+  if ((ra & 3) == 0 && (Bus::IsRAMAddress(ra_address) ? (ra_address >= 8) :
+                                                         (ra_address >= (Bus::BIOS_BASE + 8) &&
+                                                          ra_address < (Bus::BIOS_BASE + Bus::BIOS_SIZE))))
+  {
+    caller_pc = CodeCache::GetContainingBlockPC(ra - 8);
+  }
+
+  s_samples[(static_cast<u64>(caller_pc) << 32) | block_pc]++;
+  s_sample_count++;
+
+  // Vary the period slightly, so loops which run in lockstep with the sample rate don't skew the results.
+  s_jitter_state ^= s_jitter_state << 13;
+  s_jitter_state ^= s_jitter_state >> 17;
+  s_jitter_state ^= s_jitter_state << 5;
+  const TickCount max_jitter = std::max<TickCount>(s_sample_period / 8, 1);
+  const TickCount jitter = static_cast<TickCount>(s_jitter_state % static_cast<u32>(max_jitter * 2 + 1)) - max_jitter;
+  s_sample_event->Schedule(std::max<TickCount>(s_sample_period + jitter, 1));
+}
+
+void LoadSymbols()
+{
+  s_symbols.clear();
+
+  // Symbol maps are plain text, with an address followed by a name on each line. This covers no$psx .sym files and
+  // the symbol sections of linker .map files, other lines are ignored.
+  const std::string& running_path = System::GetRunningPath();
+  if (running_path.empty())
+    return;
+
+  std::optional<std::string> data;
+  std::string path;
+  for (const char* extension : {"sym", "map"})
+  {
+    path = FileSystem::ReplaceExtension(running_path, extension);
+    data = FileSystem::ReadFileToString(path.c_str());
+    if (data.has_value())
+      break;
+  }
+  if (!data.has_value())
+    return;
+
+  std::string_view remaining(data.value());
+  while (!remaining.empty())
+  {
+    std::string_view::size_type pos = remaining.find('\n');
+    std::string_view line(remaining.substr(0, pos));
+    remaining = (pos != std::string_view::npos) ? remaining.substr(pos + 1) : std::string_view();
+
+    const auto skip_whitespace = [&line]() {
+      while (!line.empty() && (line.front() == ' ' || line.front() == '\t' || line.front() == '\r'))
+        line.remove_prefix(1);
+    };
+
+    skip_whitespace();
+    if (StringUtil::StartsWith(line, "0x"))
+      line.remove_prefix(2);
+
+    pos = line.find_first_of(" \t");
+    if (pos != 8)
+      continue;
+
+    std::optional<u32> address = StringUtil::FromChars<u32>(line.substr(0, pos), 16);
+    line.remove_prefix(pos);
+    skip_whitespace();
+    while (!line.empty() && (line.back() == ' ' || line.back() == '\t' || line.back() == '\r'))
+      line.remove_suffix(1);
+    if (!address.has_value() || line.empty() || line.find_first_of(" \t") != std::string_view::npos)
+      continue;
+
+    // ';' separates frames in the collapsed-stack format
+    std::string name(line);
+    std::replace(name.begin(), name.end(), ';', ':');
+    s_symbols.push_back(Symbol{address.value() & PHYSICAL_MEMORY_ADDRESS_MASK, std::move(name)});
+  }
+
+  std::stable_sort(s_symbols.begin(), s_symbols.end(),
+                   [](const Symbol& lhs, const Symbol& rhs) { return lhs.address < rhs.address; });
+  Log_InfoPrintf("Loaded %zu symbols from '%s'", s_symbols.size(), path.c_str());
+}
+
+const Symbol* LookupSymbol(u32 pc)
+{
+  const PhysicalMemoryAddress address = pc & PHYSICAL_MEMORY_ADDRESS_MASK;
+  auto iter = std::upper_bound(s_symbols.begin(), s_symbols.end(), address,
+                               [](PhysicalMemoryAddress lhs, const Symbol& rhs) { return lhs < rhs.address; });
+  return (iter != s_symbols.begin()) ? &(*(iter - 1)) : nullptr;
+}
+
+std::string GetFrameName(u32 pc)
+{
+  const Symbol* symbol = LookupSymbol(pc);
+  return symbol ? symbol->name : StringUtil::StdStringFromFormat("sub_%08X", pc);
+}
+
+void WriteProfile()
+{
+  const std::string path = GetProfilePath();
+  auto fp = FileSystem::OpenManagedCFile(path.c_str(), "wb");
+  if (!fp)
+  {
+    Log_ErrorPrintf("Failed to open '%s' for writing", path.c_str());
+    return;
+  }
+
+  // Frames are caller;function;block. Without symbols the function is the block itself, so it's omitted.
+  std::unordered_map<std::string, u32> stacks;
+  for (const auto& it : s_samples)
+  {
+    const u32 caller_pc = static_cast<u32>(it.first >> 32);
+    const u32 block_pc = static_cast<u32>(it.first);
+    const Symbol* symbol = LookupSymbol(block_pc);
+
+    std::string stack;
+    if (caller_pc != 0 && caller_pc != block_pc && (!symbol || LookupSymbol(caller_pc) != symbol))
+    {
+      stack = GetFrameName(caller_pc);
+      stack += ';';
+    }
+    if (symbol)
+    {
+      stack += symbol->name;
+      stack += ';';
+    }
+    stack += StringUtil::StdStringFromFormat("block_%08X", block_pc);
+    stacks[std::move(stack)] += it.second;
+  }
+
+  std::vector<std::pair<std::string, u32>> sorted_stacks(stacks.begin(), stacks.end());
+  std::sort(sorted_stacks.begin(), sorted_stacks.end(),
+            [](const auto& lhs, const auto& rhs) { return lhs.second > rhs.second; });
+  for (const auto& it : sorted_stacks)
+    std::fprintf(fp.get(), "%s %u\n", it.first.c_str(), it.second);
+
+  Log_InfoPrintf("Wrote %u samples in %zu stacks to '%s'", s_sample_count, sorted_stacks.size(), path.c_str());
+}
+
+} // namespace CPU::Profiler
@@ -0,0 +1,28 @@
+#pragma once
+#include "types.h"
+#include <string>
+
+namespace CPU {
+namespace Profiler {
+
+enum : u32
+{
+  DEFAULT_SAMPLE_RATE = 2000, // samples per emulated second
+};
+
+/// Starts sampling the guest program counter. Symbols are loaded from a .sym/.map file next to the running image.
+void Start(u32 sample_rate = DEFAULT_SAMPLE_RATE);
+
+/// Stops sampling, and writes the collected samples to the profile file.
+void Stop();
+
+bool IsActive();
+
+/// Number of samples taken since the profiler was started.
+u32 GetSampleCount();
+
+/// Path which the profile is written to, in collapsed-stack format for flamegraph.pl.
+std::string GetProfilePath();
+
+} // namespace Profiler
+} // namespace CPU
@@ -18,6 +18,9 @@ bool CodeGenerator::CompileBlock(CodeBlock* block, CodeBlock::HostCodePointer* o
 {
   // TODO: Align code buffer.
 
+  if (g_settings.cpu_recompiler_optimize_blocks)
+    OptimizeBlock(block);
+
   m_block = block;
   m_block_start = block->instructions.data();
   m_block_end = block->instructions.data() + block->instructions.size();
@@ -27,6 +30,7 @@ bool CodeGenerator::CompileBlock(CodeBlock* block, CodeBlock::HostCodePointer* o
 
   m_fastmem_load_base_in_register = false;
   m_fastmem_store_base_in_register = false;
+  m_block_may_run_events = false;
 
   EmitBeginBlock(true);
   BlockPrologue();
@@ -65,9 +69,21 @@ bool CodeGenerator::CompileBlock(CodeBlock* block, CodeBlock::HostCodePointer* o
   return true;
 }
 
+bool CodeGenerator::CompileInlineGTEInstruction(u32 inst_bits, CodeBlock::HostCodePointer* out_host_code)
+{
+  if (!EmitInlineGTEInstruction(inst_bits))
+    return false;
+
+  EmitEndBlock(false, true);
+
+  u32 host_code_size;
+  FinalizeBlock(out_host_code, &host_code_size);
+  return true;
+}
+
 bool CodeGenerator::CompileInstruction(const CodeBlockInstruction& cbi)
 {
-  if (IsNopInstruction(cbi.instruction))
+  if (IsNopInstruction(cbi.instruction) || cbi.is_dead_write)
   {
     InstructionPrologue(cbi, 1);
     InstructionEpilogue(cbi);
@@ -955,6 +971,9 @@ void CodeGenerator::BlockPrologue()
 {
   InitSpeculativeRegs();
 
+  // pinned guest registers are passed in host registers from the previous block or the dispatcher
+  m_register_cache.AssumePinnedGuestRegistersAreLoaded();
+
   EmitStoreCPUStructField(offsetof(State, exception_raised), Value::FromConstantU8(0));
 
 #if 0
@@ -979,7 +998,8 @@ void CodeGenerator::BlockEpilogue()
   m_emit->nop();
 #endif
 
-  m_register_cache.FlushAllGuestRegisters(true, true);
+  // pinned registers are written back by EmitEndBlock() only if we return to the dispatcher
+  m_register_cache.FlushAllUnpinnedGuestRegisters(true, true);
   if (m_register_cache.HasLoadDelay())
     m_register_cache.WriteLoadDelayToCPU(true);
 
@@ -1067,6 +1087,241 @@ void CodeGenerator::TruncateBlockAtCurrentInstruction()
   WriteNewPC(CalculatePC(), true);
 }
 
+namespace {
+struct InstructionRegisterUsage
+{
+  u32 reads;          // registers read by the instruction
+  u32 writes;         // registers written at the end of the instruction
+  u32 delayed_writes; // registers written after the load delay slot
+  bool pure;          // no side effects other than writing a register
+  bool barrier;       // can raise an exception or touch arbitrary state, so all registers are live
+};
+} // namespace
+
+static constexpr u32 RegMask(Reg reg)
+{
+  return (reg == Reg::zero) ? 0u : (1u << static_cast<u8>(reg));
+}
+
+static InstructionRegisterUsage GetInstructionRegisterUsage(const Instruction& instruction)
+{
+  InstructionRegisterUsage usage = {};
+  const Reg rs = instruction.i.rs;
+  const Reg rt = instruction.i.rt;
+  const Reg rd = instruction.r.rd;
+
+  switch (instruction.op)
+  {
+    case InstructionOp::lui:
+      usage.writes = RegMask(rt);
+      usage.pure = true;
+      break;
+
+    case InstructionOp::addiu:
+    case InstructionOp::slti:
+    case InstructionOp::sltiu:
+    case InstructionOp::andi:
+    case InstructionOp::ori:
+    case InstructionOp::xori:
+      usage.reads = RegMask(rs);
+      usage.writes = RegMask(rt);
+      usage.pure = true;
+      break;
+
+    case InstructionOp::lb:
+    case InstructionOp::lbu:
+    case InstructionOp::lh:
+    case InstructionOp::lhu:
+    case InstructionOp::lw:
+      usage.reads = RegMask(rs);
+      usage.delayed_writes = RegMask(rt);
+      usage.barrier = g_settings.cpu_recompiler_memory_exceptions;
+      break;
+
+    case InstructionOp::lwl:
+    case InstructionOp::lwr:
+      usage.reads = RegMask(rs) | RegMask(rt);
+      usage.delayed_writes = RegMask(rt);
+      usage.barrier = g_settings.cpu_recompiler_memory_exceptions;
+      break;
+
+    case InstructionOp::sb:
+    case InstructionOp::sh:
+    case InstructionOp::sw:
+    case InstructionOp::swl:
+    case InstructionOp::swr:
+      // Stores which speculatively hit the block truncate it, so the rest of the block might not run.
+      usage.reads = RegMask(rs) | RegMask(rt);
+      usage.barrier = true;
+      break;
+
+    case InstructionOp::j:
+      break;
+
+    case InstructionOp::jal:
+      usage.writes = RegMask(Reg::ra);
+      break;
+
+    case InstructionOp::beq:
+    case InstructionOp::bne:
+      usage.reads = RegMask(rs) | RegMask(rt);
+      break;
+
+    case InstructionOp::blez:
+    case InstructionOp::bgtz:
+      usage.reads = RegMask(rs);
+      break;
+
+    case InstructionOp::b:
+      usage.reads = RegMask(rs);
+      if ((static_cast<u8>(rt) & u8(0x1E)) == u8(0x10))
+        usage.writes = RegMask(Reg::ra);
+      break;
+
+    case InstructionOp::funct:
+    {
+      switch (instruction.r.funct)
+      {
+        case InstructionFunct::sll:
+        case InstructionFunct::srl:
+        case InstructionFunct::sra:
+          usage.reads = RegMask(rt);
+          usage.writes = RegMask(rd);
+          usage.pure = true;
+          break;
+
+        case InstructionFunct::sllv:
+        case InstructionFunct::srlv:
+        case InstructionFunct::srav:
+        case InstructionFunct::addu:
+        case InstructionFunct::subu:
+        case InstructionFunct::and_:
+        case InstructionFunct::or_:
+        case InstructionFunct::xor_:
+        case InstructionFunct::nor:
+        case InstructionFunct::slt:
+        case InstructionFunct::sltu:
+          usage.reads = RegMask(rs) | RegMask(rt);
+          usage.writes = RegMask(rd);
+          usage.pure = true;
+          break;
+
+        case InstructionFunct::mfhi:
+        case InstructionFunct::mflo:
+          usage.writes = RegMask(rd);
+          usage.pure = true;
+          break;
+
+        case InstructionFunct::mthi:
+        case InstructionFunct::mtlo:
+          usage.reads = RegMask(rs);
+          break;
+
+        case InstructionFunct::mult:
+        case InstructionFunct::multu:
+        case InstructionFunct::div:
+        case InstructionFunct::divu:
+          usage.reads = RegMask(rs) | RegMask(rt);
+          break;
+
+        case InstructionFunct::jr:
+          usage.reads = RegMask(rs);
+          break;
+
+        case InstructionFunct::jalr:
+          usage.reads = RegMask(rs);
+          usage.writes = RegMask(rd);
+          break;
+
+        default:
+          // add/sub can overflow, syscall/break raise exceptions.
+          usage.barrier = true;
+          break;
+      }
+    }
+    break;
+
+    default:
+      // addi can overflow, coprocessor instructions are interpreted or access GTE state.
+      usage.barrier = true;
+      break;
+  }
+
+  return usage;
+}
+
+void CodeGenerator::OptimizeBlock(CodeBlock* block)
+{
+  // PGXP tracks every register write, so none of them can be dropped.
+  const bool allow_dead_writes = !g_settings.UsingPGXPCPUMode();
+  const size_t count = block->instructions.size();
+  u32 num_dead_writes = 0;
+  u32 num_skipped_load_delays = 0;
+
+  // Backwards pass: a pure write is dead if it's overwritten before being read, without a barrier in between.
+  // Everything is live at the end of the block, and loads don't kill liveness since the old value is still visible in
+  // their delay slot.
+  u32 live = UINT32_C(0xFFFFFFFF);
+  for (size_t i = count; i > 0; i--)
+  {
+    CodeBlockInstruction& cbi = block->instructions[i - 1];
+    cbi.is_dead_write = false;
+
+    const InstructionRegisterUsage usage = GetInstructionRegisterUsage(cbi.instruction);
+    if (usage.barrier)
+    {
+      live = UINT32_C(0xFFFFFFFF);
+      continue;
+    }
+
+    // The first instruction can have a load delay from the previous block, and writes in a load delay slot cancel
+    // the load, so they have to stay.
+    if (allow_dead_writes && usage.pure && usage.writes != 0 && (live & usage.writes) == 0 && i > 1 &&
+        !cbi.is_load_delay_slot)
+    {
+      cbi.is_dead_write = true;
+      num_dead_writes++;
+      continue;
+    }
+
+    live = (live & ~usage.writes) | usage.reads;
+  }
+
+  // Forwards pass: the load delay can't be observed if the next instruction neither reads nor writes the register.
+  for (size_t i = 0; i < count; i++)
+  {
+    CodeBlockInstruction& cbi = block->instructions[i];
+    cbi.skip_load_delay = false;
+
+    const Instruction instruction = cbi.instruction;
+    if (i == 0 || (i + 1) == count || cbi.is_load_delay_slot || instruction.i.rt == Reg::zero ||
+        (instruction.op != InstructionOp::lb && instruction.op != InstructionOp::lbu &&
+         instruction.op != InstructionOp::lh && instruction.op != InstructionOp::lhu &&
+         instruction.op != InstructionOp::lw))
+    {
+      continue;
+    }
+
+    const CodeBlockInstruction& next_cbi = block->instructions[i + 1];
+    const InstructionRegisterUsage next_usage = GetInstructionRegisterUsage(next_cbi.instruction);
+    const u32 mask = RegMask(instruction.i.rt);
+    if (next_cbi.is_dead_write || next_usage.barrier ||
+        ((next_usage.reads | next_usage.writes | next_usage.delayed_writes) & mask) != 0)
+    {
+      continue;
+    }
+
+    cbi.skip_load_delay = true;
+    num_skipped_load_delays++;
+  }
+
+  if (num_dead_writes > 0 || num_skipped_load_delays > 0)
+  {
+    Log_ProfilePrintf("Block 0x%08X: %u dead writes removed, %u load delays skipped", block->GetPC(), num_dead_writes,
+                      num_skipped_load_delays);
+  }
+}
+
 void CodeGenerator::AddPendingCycles(bool commit)
 {
   if (m_delayed_cycles_add == 0 && m_gte_done_cycle <= m_delayed_cycles_add)
@@ -1153,6 +1408,14 @@ void CodeGenerator::WriteNewPC(const Value& value, bool commit)
   }
 }
 
+bool CodeGenerator::NeedsDownCountCheck(u32 target_pc) const
+{
+  // With lazy checks, exits to blocks further ahead skip the check. A chain of forward links can't be longer than the
+  // address space, so the events still run at the next backward branch, idle loop or return to the dispatcher.
+  return (!g_settings.cpu_recompiler_lazy_downcount || m_block_may_run_events || m_block->is_idle_loop ||
+          target_pc <= m_block->GetPC());
+}
+
 bool CodeGenerator::Compile_Fallback(const CodeBlockInstruction& cbi)
 {
   InstructionPrologue(cbi, 1, true);
@@ -1186,6 +1449,7 @@ bool CodeGenerator::Compile_Fallback(const CodeBlockInstruction& cbi)
   m_current_instruction_in_branch_delay_slot_dirty = cbi.is_branch_instruction;
   m_branch_was_taken_dirty = cbi.is_branch_instruction;
   m_next_load_delay_dirty = cbi.has_load_delay;
+  m_block_may_run_events = true;
   InvalidateSpeculativeValues();
   InstructionEpilogue(cbi);
   return true;
@@ -1228,7 +1492,7 @@ bool CodeGenerator::Compile_Bitwise(const CodeBlockInstruction& cbi)
   {
     case InstructionOp::ori:
     {
-      if (g_settings.UsingPGXPCPUMode())
+      if (g_settings.UsingPGXPCPUMode() && !EmitInlinePGXPBitwiseImmediate(cbi.instruction.bits, lhs))
         EmitFunctionCall(nullptr, &PGXP::CPU_ORI, Value::FromConstantU32(cbi.instruction.bits), lhs);
 
       result = OrValues(lhs, rhs);
@@ -1239,7 +1503,7 @@ bool CodeGenerator::Compile_Bitwise(const CodeBlockInstruction& cbi)
 
     case InstructionOp::andi:
     {
-      if (g_settings.UsingPGXPCPUMode())
+      if (g_settings.UsingPGXPCPUMode() && !EmitInlinePGXPBitwiseImmediate(cbi.instruction.bits, lhs))
         EmitFunctionCall(nullptr, &PGXP::CPU_ANDI, Value::FromConstantU32(cbi.instruction.bits), lhs);
 
       result = AndValues(lhs, rhs);
@@ -1470,7 +1734,7 @@ bool CodeGenerator::Compile_Load(const CodeBlockInstruction& cbi)
     case InstructionOp::lw:
     {
       result = EmitLoadGuestMemory(cbi, address, address_spec, RegSize_32);
-      if (g_settings.gpu_pgxp_enable)
+      if (g_settings.gpu_pgxp_enable && !EmitInlinePGXPLoadWord(cbi.instruction.bits, address, result))
         EmitFunctionCall(nullptr, PGXP::CPU_LW, Value::FromConstantU32(cbi.instruction.bits), result, address);
 
       if (address_spec)
@@ -1483,7 +1747,16 @@ bool CodeGenerator::Compile_Load(const CodeBlockInstruction& cbi)
       break;
   }
 
-  m_register_cache.WriteGuestRegisterDelayed(cbi.instruction.i.rt, std::move(result));
+  if (cbi.skip_load_delay)
+  {
+    // nothing can observe the old value, so write it straight away
+    EmitCancelInterpreterLoadDelayForReg(cbi.instruction.i.rt);
+    m_register_cache.WriteGuestRegister(cbi.instruction.i.rt, std::move(result));
+  }
+  else
+  {
+    m_register_cache.WriteGuestRegisterDelayed(cbi.instruction.i.rt, std::move(result));
+  }
   SpeculativeWriteReg(cbi.instruction.i.rt, value_spec);
 
   InstructionEpilogue(cbi);
@@ -1571,7 +1844,7 @@ bool CodeGenerator::Compile_Store(const CodeBlockInstruction& cbi)
 
     case InstructionOp::sw:
     {
-      if (g_settings.gpu_pgxp_enable)
+      if (g_settings.gpu_pgxp_enable && !EmitInlinePGXPStoreWord(cbi.instruction.bits, address, value))
         EmitFunctionCall(nullptr, PGXP::CPU_SW, Value::FromConstantU32(cbi.instruction.bits), value, address);
 
       EmitStoreGuestMemory(cbi, address, address_spec, RegSize_32, value);
@@ -1675,7 +1948,7 @@ bool CodeGenerator::Compile_LoadLeftRight(const CodeBlockInstruction& cbi)
 
   shift.ReleaseAndClear();
 
-  if (g_settings.gpu_pgxp_enable)
+  if (g_settings.gpu_pgxp_enable && !EmitInlinePGXPLoadWord(cbi.instruction.bits, address, mem))
     EmitFunctionCall(nullptr, PGXP::CPU_LW, Value::FromConstantU32(cbi.instruction.bits), mem, address);
 
   m_register_cache.WriteGuestRegisterDelayed(cbi.instruction.i.rt, std::move(mem));
@@ -1738,7 +2011,7 @@ bool CodeGenerator::Compile_StoreLeftRight(const CodeBlockInstruction& cbi)
   shift.ReleaseAndClear();
 
   EmitStoreGuestMemory(cbi, address, address_spec, RegSize_32, mem);
-  if (g_settings.gpu_pgxp_enable)
+  if (g_settings.gpu_pgxp_enable && !EmitInlinePGXPStoreWord(cbi.instruction.bits, address, mem))
     EmitFunctionCall(nullptr, PGXP::CPU_SW, Value::FromConstantU32(cbi.instruction.bits), mem, address);
 
   InstructionEpilogue(cbi);
@@ -1754,8 +2027,11 @@ bool CodeGenerator::Compile_MoveHiLo(const CodeBlockInstruction& cbi)
     case InstructionFunct::mfhi:
     {
       Value hi = m_register_cache.ReadGuestRegister(Reg::hi);
-      if (g_settings.UsingPGXPCPUMode())
+      if (g_settings.UsingPGXPCPUMode() &&
+          !EmitInlinePGXPMove(static_cast<u32>(cbi.instruction.r.rd.GetValue()), PGXP::CPU_REG_HI, hi))
+      {
         EmitFunctionCall(nullptr, &PGXP::CPU_MFHI, Value::FromConstantU32(cbi.instruction.bits), hi);
+      }
 
       m_register_cache.WriteGuestRegister(cbi.instruction.r.rd, std::move(hi));
       SpeculativeWriteReg(cbi.instruction.r.rd, std::nullopt);
@@ -1765,8 +2041,12 @@ bool CodeGenerator::Compile_MoveHiLo(const CodeBlockInstruction& cbi)
     case InstructionFunct::mthi:
     {
       Value rs = m_register_cache.ReadGuestRegister(cbi.instruction.r.rs);
-      if (g_settings.UsingPGXPCPUMode())
+      // PGXP takes the source from the rd field here
+      if (g_settings.UsingPGXPCPUMode() &&
+          !EmitInlinePGXPMove(PGXP::CPU_REG_HI, static_cast<u32>(cbi.instruction.r.rd.GetValue()), rs))
+      {
         EmitFunctionCall(nullptr, &PGXP::CPU_MTHI, Value::FromConstantU32(cbi.instruction.bits), rs);
+      }
 
       m_register_cache.WriteGuestRegister(Reg::hi, std::move(rs));
     }
@@ -1775,8 +2055,11 @@ bool CodeGenerator::Compile_MoveHiLo(const CodeBlockInstruction& cbi)
     case InstructionFunct::mflo:
     {
       Value lo = m_register_cache.ReadGuestRegister(Reg::lo);
-      if (g_settings.UsingPGXPCPUMode())
+      if (g_settings.UsingPGXPCPUMode() &&
+          !EmitInlinePGXPMove(static_cast<u32>(cbi.instruction.r.rd.GetValue()), PGXP::CPU_REG_LO, lo))
+      {
         EmitFunctionCall(nullptr, &PGXP::CPU_MFLO, Value::FromConstantU32(cbi.instruction.bits), lo);
+      }
 
       m_register_cache.WriteGuestRegister(cbi.instruction.r.rd, std::move(lo));
       SpeculativeWriteReg(cbi.instruction.r.rd, std::nullopt);
@@ -1786,8 +2069,12 @@ bool CodeGenerator::Compile_MoveHiLo(const CodeBlockInstruction& cbi)
     case InstructionFunct::mtlo:
     {
       Value rs = m_register_cache.ReadGuestRegister(cbi.instruction.r.rs);
-      if (g_settings.UsingPGXPCPUMode())
+      // PGXP takes the source from the rd field here
+      if (g_settings.UsingPGXPCPUMode() &&
+          !EmitInlinePGXPMove(PGXP::CPU_REG_LO, static_cast<u32>(cbi.instruction.r.rd.GetValue()), rs))
+      {
         EmitFunctionCall(nullptr, &PGXP::CPU_MTLO, Value::FromConstantU32(cbi.instruction.bits), rs);
+      }
 
       m_register_cache.WriteGuestRegister(Reg::lo, std::move(rs));
     }
@@ -1851,13 +2138,19 @@ bool CodeGenerator::Compile_Add(const CodeBlockInstruction& cbi)
   // detect register moves and handle them for pgxp
   if (g_settings.gpu_pgxp_enable && rhs.HasConstantValue(0))
   {
-    EmitFunctionCall(nullptr, &PGXP::CPU_MOVE,
-                     Value::FromConstantU32((static_cast<u32>(dest) << 8) | (static_cast<u32>(lhs_src))), lhs);
+    if (!EmitInlinePGXPMove(static_cast<u32>(dest), static_cast<u32>(lhs_src), lhs))
+    {
+      EmitFunctionCall(nullptr, &PGXP::CPU_MOVE,
+                       Value::FromConstantU32((static_cast<u32>(dest) << 8) | (static_cast<u32>(lhs_src))), lhs);
+    }
   }
   else if (g_settings.UsingPGXPCPUMode())
   {
     if (cbi.instruction.op != InstructionOp::funct)
-      EmitFunctionCall(nullptr, &PGXP::CPU_ADDI, Value::FromConstantU32(cbi.instruction.bits), lhs);
+    {
+      if (!EmitInlinePGXPAddImmediate(cbi.instruction.bits, lhs))
+        EmitFunctionCall(nullptr, &PGXP::CPU_ADDI, Value::FromConstantU32(cbi.instruction.bits), lhs);
+    }
     else
       EmitFunctionCall(nullptr, &PGXP::CPU_ADD, Value::FromConstantU32(cbi.instruction.bits), lhs, rhs);
   }
@@ -2195,6 +2488,26 @@ bool CodeGenerator::Compile_Branch(const CodeBlockInstruction& cbi)
 
   auto DoBranch = [this, &cbi](Condition condition, const Value& lhs, const Value& rhs, Reg lr_reg,
                                Value&& branch_target) {
+    if (cbi.is_traced_branch)
+    {
+      // the target is part of this block, so just compile the delay slot and carry on
+      DebugAssert(condition == Condition::Always && branch_target.IsConstant());
+      if (lr_reg != Reg::count && lr_reg != Reg::zero)
+      {
+        EmitCancelInterpreterLoadDelayForReg(lr_reg);
+        m_register_cache.WriteGuestRegister(lr_reg, CalculatePC(4));
+      }
+
+      InstructionEpilogue(cbi);
+      m_current_instruction++;
+      if (!CompileInstruction(*m_current_instruction))
+        return false;
+
+      m_pc = static_cast<u32>(branch_target.constant_value);
+      m_pc_valid = true;
+      return true;
+    }
+
     const bool can_link_block = cbi.is_direct_branch_instruction && g_settings.cpu_recompiler_block_linking;
 
     // ensure the lr register is flushed, since we want it's correct value after the branch
@@ -2328,10 +2641,18 @@ bool CodeGenerator::Compile_Branch(const CodeBlockInstruction& cbi)
       m_block_linked = true;
 
       // check downcount
-      Value pending_ticks = m_register_cache.AllocateScratch(RegSize_32);
-      Value downcount = m_register_cache.AllocateScratch(RegSize_32);
-      EmitLoadCPUStructField(pending_ticks.GetHostRegister(), RegSize_32, offsetof(State, pending_ticks));
-      EmitLoadCPUStructField(downcount.GetHostRegister(), RegSize_32, offsetof(State, downcount));
+      const bool check_taken_downcount = NeedsDownCountCheck(static_cast<u32>(branch_target.constant_value));
+      const bool check_not_taken_downcount =
+        (condition != Condition::Always) && NeedsDownCountCheck(static_cast<u32>(CalculatePC(4).constant_value));
+      Value pending_ticks;
+      Value downcount;
+      if (check_taken_downcount || check_not_taken_downcount)
+      {
+        pending_ticks = m_register_cache.AllocateScratch(RegSize_32);
+        downcount = m_register_cache.AllocateScratch(RegSize_32);
+        EmitLoadCPUStructField(pending_ticks.GetHostRegister(), RegSize_32, offsetof(State, pending_ticks));
+        EmitLoadCPUStructField(downcount.GetHostRegister(), RegSize_32, offsetof(State, downcount));
+      }
 
       // pending < downcount
       LabelType return_to_dispatcher;
@@ -2342,8 +2663,16 @@ bool CodeGenerator::Compile_Branch(const CodeBlockInstruction& cbi)
         m_register_cache.PushState();
         {
           WriteNewPC(branch_target, false);
-          EmitConditionalBranch(Condition::GreaterEqual, false, pending_ticks.GetHostRegister(), downcount,
-                                &return_to_dispatcher);
+          if (m_block->is_idle_loop)
+          {
+            EmitFunctionCall(nullptr, &CPU::Recompiler::Thunks::SkipIdleLoop);
+            EmitLoadCPUStructField(pending_ticks.GetHostRegister(), RegSize_32, offsetof(State, pending_ticks));
+          }
+          if (check_taken_downcount)
+          {
+            EmitConditionalBranch(Condition::GreaterEqual, false, pending_ticks.GetHostRegister(), downcount,
+                                  &return_to_dispatcher);
+          }
 
           // we're committed at this point :D
           EmitEndBlock(true, false);
@@ -2369,17 +2698,28 @@ bool CodeGenerator::Compile_Branch(const CodeBlockInstruction& cbi)
 
       m_register_cache.PushState();
 
+      bool check_downcount;
       if (condition != Condition::Always)
       {
         WriteNewPC(next_pc, true);
+        check_downcount = check_not_taken_downcount;
       }
       else
       {
         WriteNewPC(branch_target, true);
+        if (m_block->is_idle_loop)
+        {
+          EmitFunctionCall(nullptr, &CPU::Recompiler::Thunks::SkipIdleLoop);
+          EmitLoadCPUStructField(pending_ticks.GetHostRegister(), RegSize_32, offsetof(State, pending_ticks));
+        }
+        check_downcount = check_taken_downcount;
       }
 
-      EmitConditionalBranch(Condition::GreaterEqual, false, pending_ticks.GetHostRegister(), downcount,
-                            &return_to_dispatcher);
+      if (check_downcount)
+      {
+        EmitConditionalBranch(Condition::GreaterEqual, false, pending_ticks.GetHostRegister(), downcount,
+                              &return_to_dispatcher);
+      }
 
       EmitEndBlock(true, false);
 
@@ -2540,8 +2880,11 @@ bool CodeGenerator::Compile_lui(const CodeBlockInstruction& cbi)
 {
   InstructionPrologue(cbi, 1);
 
-  if (g_settings.UsingPGXPCPUMode())
+  if (g_settings.UsingPGXPCPUMode() &&
+      !EmitInlinePGXPLoadUpper(static_cast<u32>(cbi.instruction.i.rt.GetValue()), cbi.instruction.i.imm_zext32()))
+  {
     EmitFunctionCall(nullptr, &PGXP::CPU_LUI, Value::FromConstantU32(cbi.instruction.bits));
+  }
 
   // rt <- (imm << 16)
   const u32 value = cbi.instruction.i.imm_zext32() << 16;
@@ -2713,6 +3056,7 @@ bool CodeGenerator::Compile_cop0(const CodeBlockInstruction& cbi)
             EmitTest(sr_value.host_reg, Value::FromConstantU32(0xFF00));
             EmitConditionalBranch(Condition::Zero, false, &no_interrupt);
             EmitStoreCPUStructField(offsetof(State, downcount), Value::FromConstantU32(0));
+            m_block_may_run_events = true;
             EmitBindLabel(&no_interrupt);
             m_register_cache.UninhibitAllocation();
           }
@@ -2793,6 +3137,7 @@ bool CodeGenerator::Compile_cop0(const CodeBlockInstruction& cbi)
         EmitConditionalBranch(Condition::Zero, false, &no_interrupt);
         m_register_cache.InhibitAllocation();
         EmitStoreCPUStructField(offsetof(State, downcount), Value::FromConstantU32(0));
+        m_block_may_run_events = true;
         EmitBindLabel(&no_interrupt);
         m_register_cache.UninhibitAllocation();
 
@@ -3025,8 +3370,12 @@ bool CodeGenerator::Compile_cop2(const CodeBlockInstruction& cbi)
     StallUntilGTEComplete();
     InstructionPrologue(cbi, 1);
 
-    Value instruction_bits = Value::FromConstantU32(cbi.instruction.bits & GTE::Instruction::REQUIRED_BITS_MASK);
-    EmitFunctionCall(nullptr, func, instruction_bits);
+    if (!g_settings.cpu_recompiler_inline_gte || !EmitInlineGTEInstruction(cbi.instruction.bits))
+    {
+      Value instruction_bits = Value::FromConstantU32(cbi.instruction.bits & GTE::Instruction::REQUIRED_BITS_MASK);
+      EmitFunctionCall(nullptr, func, instruction_bits);
+    }
+
     AddGTETicks(func_ticks);
 
     InstructionEpilogue(cbi);
@@ -3036,6 +3385,12 @@ bool CodeGenerator::Compile_cop2(const CodeBlockInstruction& cbi)
 
 void CodeGenerator::InitSpeculativeRegs()
 {
+  if (!m_guest_state_speculation)
+  {
+    InvalidateSpeculativeValues();
+    return;
+  }
+
   for (u8 i = 0; i < static_cast<u8>(Reg::count); i++)
     m_speculative_constants.regs[i] = g_state.regs.r[i];
 
@@ -3067,6 +3422,9 @@ CodeGenerator::SpeculativeValue CodeGenerator::SpeculativeReadMemory(VirtualMemo
   if (it != m_speculative_constants.memory.end())
     return it->second;
 
+  if (!m_guest_state_speculation)
+    return std::nullopt;
+
   u32 value;
   if ((phys_addr & DCACHE_LOCATION_MASK) == DCACHE_LOCATION)
   {
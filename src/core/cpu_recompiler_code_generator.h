@@ -31,9 +31,16 @@ public:
 
   bool CompileBlock(CodeBlock* block, CodeBlock::HostCodePointer* out_host_code, u32* out_host_code_size);
 
+  /// Stops speculative constants being seeded from guest registers/memory, for compiling off the CPU thread.
+  void DisableGuestStateSpeculation() { m_guest_state_speculation = false; }
+
   CodeCache::DispatcherFunction CompileDispatcher();
   CodeCache::SingleBlockDispatcherFunction CompileSingleBlockDispatcher();
 
+  /// Compiles a standalone function which runs the inline sequence for a GTE command, for testing. It has to be called
+  /// through the single block dispatcher. Returns false if the command isn't emitted inline.
+  bool CompileInlineGTEInstruction(u32 inst_bits, CodeBlock::HostCodePointer* out_host_code);
+
   //////////////////////////////////////////////////////////////////////////
   // Code Generation
   //////////////////////////////////////////////////////////////////////////
@@ -75,6 +82,17 @@ public:
   void EmitCancelInterpreterLoadDelayForReg(Reg reg);
   void EmitICacheCheckAndUpdate();
   void EmitStallUntilGTEComplete();
+  bool EmitInlineGTEInstruction(u32 inst_bits); // false if the command has to be called out to the GTE
+
+  // PGXP shadow state updates, false if the backend has to call out to PGXP instead. Shifts, multiply/divide,
+  // xori and the set-less-than family always call out.
+  bool EmitInlinePGXPMove(u32 dest_reg, u32 src_reg, const Value& src_value);
+  bool EmitInlinePGXPLoadUpper(u32 dest_reg, u32 imm);
+  bool EmitInlinePGXPBitwiseImmediate(u32 inst_bits, const Value& src_value);
+  bool EmitInlinePGXPAddImmediate(u32 inst_bits, const Value& src_value);
+  bool EmitInlinePGXPLoadWord(u32 inst_bits, const Value& address, const Value& value);
+  bool EmitInlinePGXPStoreWord(u32 inst_bits, const Value& address, const Value& value);
+
   void EmitLoadCPUStructField(HostReg host_reg, RegSize size, u32 offset);
   void EmitStoreCPUStructField(u32 offset, const Value& value);
   void EmitAddCPUStructField(u32 offset, const Value& value);
@@ -204,6 +222,7 @@ private:
   void InstructionPrologue(const CodeBlockInstruction& cbi, TickCount cycles, bool force_sync = false);
   void InstructionEpilogue(const CodeBlockInstruction& cbi);
   void TruncateBlockAtCurrentInstruction();
+  void OptimizeBlock(CodeBlock* block);
   void AddPendingCycles(bool commit);
   void AddGTETicks(TickCount ticks);
   void StallUntilGTEComplete();
@@ -211,6 +230,7 @@ private:
   Value CalculatePC(u32 offset = 0);
   Value GetCurrentInstructionPC(u32 offset = 0);
   void WriteNewPC(const Value& value, bool commit);
+  bool NeedsDownCountCheck(u32 target_pc) const;
 
   Value DoGTERegisterRead(u32 index);
   void DoGTERegisterWrite(u32 index, const Value& value);
@@ -255,6 +275,7 @@ private:
   u32 m_pc = 0;
   bool m_pc_valid = false;
   bool m_block_linked = false;
+  bool m_block_may_run_events = false; // I/O accesses or interrupt changes, downcount has to be checked on exit
 
   // whether various flags need to be reset.
   bool m_current_instruction_in_branch_delay_slot_dirty = false;
@@ -266,6 +287,7 @@ private:
 
   bool m_fastmem_load_base_in_register = false;
   bool m_fastmem_store_base_in_register = false;
+  bool m_guest_state_speculation = true;
 
   //////////////////////////////////////////////////////////////////////////
   // Speculative Constants
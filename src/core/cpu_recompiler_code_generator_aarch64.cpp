@@ -1996,6 +1996,43 @@ void CodeGenerator::EmitStallUntilGTEComplete()
   m_emit->str(GetHostReg32(RARG1), a64::MemOperand(GetCPUPtrReg(), offsetof(State, pending_ticks)));
 }
 
+bool CodeGenerator::EmitInlineGTEInstruction(u32 inst_bits)
+{
+  // Not implemented for this backend, all commands are called out to the GTE.
+  return false;
+}
+
+bool CodeGenerator::EmitInlinePGXPMove(u32 dest_reg, u32 src_reg, const Value& src_value)
+{
+  // Not implemented for this backend, PGXP is always called.
+  return false;
+}
+
+bool CodeGenerator::EmitInlinePGXPLoadUpper(u32 dest_reg, u32 imm)
+{
+  return false;
+}
+
+bool CodeGenerator::EmitInlinePGXPBitwiseImmediate(u32 inst_bits, const Value& src_value)
+{
+  return false;
+}
+
+bool CodeGenerator::EmitInlinePGXPAddImmediate(u32 inst_bits, const Value& src_value)
+{
+  return false;
+}
+
+bool CodeGenerator::EmitInlinePGXPLoadWord(u32 inst_bits, const Value& address, const Value& value)
+{
+  return false;
+}
+
+bool CodeGenerator::EmitInlinePGXPStoreWord(u32 inst_bits, const Value& address, const Value& value)
+{
+  return false;
+}
+
 void CodeGenerator::EmitBranch(const void* address, bool allow_scratch)
 {
   const s64 jump_distance =
@@ -26,6 +26,16 @@ void CodeGenerator::EmitStoreInterpreterLoadDelay(Reg reg, const Value& value)
   m_load_delay_dirty = true;
 }
 
+// RAM, the scratchpad and the BIOS don't have side effects on the event queue.
+static bool IsEventFreeAddress(VirtualMemoryAddress address)
+{
+  if ((address & DCACHE_LOCATION_MASK) == DCACHE_LOCATION)
+    return true;
+
+  const PhysicalMemoryAddress paddr = address & PHYSICAL_MEMORY_ADDRESS_MASK;
+  return (paddr < Bus::RAM_MIRROR_END || (paddr >= Bus::BIOS_BASE && paddr < (Bus::BIOS_BASE + Bus::BIOS_SIZE)));
+}
+
 Value CodeGenerator::EmitLoadGuestMemory(const CodeBlockInstruction& cbi, const Value& address,
                                          const SpeculativeValue& address_spec, RegSize size)
 {
@@ -59,6 +69,9 @@ Value CodeGenerator::EmitLoadGuestMemory(const CodeBlockInstruction& cbi, const
 
   Value result = m_register_cache.AllocateScratch(HostPointerSize);
 
+  if (!address_spec || !IsEventFreeAddress(*address_spec))
+    m_block_may_run_events = true;
+
   const bool use_fastmem =
     (address_spec ? Bus::CanUseFastmemForAddress(*address_spec) : true) && !SpeculativeIsCacheIsolated();
   if (address_spec)
@@ -132,6 +145,9 @@ void CodeGenerator::EmitStoreGuestMemory(const CodeBlockInstruction& cbi, const
     }
   }
 
+  if (!address_spec || !IsEventFreeAddress(*address_spec))
+    m_block_may_run_events = true;
+
   const bool use_fastmem =
     (address_spec ? Bus::CanUseFastmemForAddress(*address_spec) : true) && !SpeculativeIsCacheIsolated();
   if (address_spec)
@@ -5,6 +5,8 @@
 #include "cpu_core_private.h"
 #include "cpu_recompiler_code_generator.h"
 #include "cpu_recompiler_thunks.h"
+#include "gte.h"
+#include "pgxp.h"
 #include "settings.h"
 #include "timing_event.h"
 Log_SetChannel(Recompiler::CodeGenerator);
@@ -31,6 +33,9 @@ constexpr HostReg RARG4 = Xbyak::Operand::RCX;
 constexpr u32 FUNCTION_CALL_SHADOW_SPACE = 0;
 #endif
 
+// Writes back the pinned guest registers and returns to the dispatcher, used for unlinked block exits.
+static const void* s_pinned_register_return = nullptr;
+
 static const Xbyak::Reg8 GetHostReg8(HostReg reg)
 {
   return Xbyak::Reg8(reg, reg >= Xbyak::Operand::SPL);
@@ -162,6 +167,19 @@ void CodeGenerator::InitHostRegs()
 #endif
 
   m_register_cache.SetCPUPtrHostReg(RCPUPTR);
+
+  if (g_settings.cpu_recompiler_pinned_registers)
+  {
+    // Guest registers which are accessed in most blocks live in callee-saved registers across block links. Only two
+    // are pinned, the unaligned load/store sequences need most of the remaining registers when fastmem is enabled.
+#if defined(ABI_WIN64)
+    m_register_cache.PinGuestRegister(Reg::sp, Xbyak::Operand::R12);
+    m_register_cache.PinGuestRegister(Reg::ra, Xbyak::Operand::R13);
+#elif defined(ABI_SYSV)
+    m_register_cache.PinGuestRegister(Reg::sp, Xbyak::Operand::R13);
+    m_register_cache.PinGuestRegister(Reg::ra, Xbyak::Operand::R14);
+#endif
+  }
 }
 
 void CodeGenerator::SwitchToFarCode()
@@ -229,6 +247,12 @@ void CodeGenerator::EmitBeginBlock(bool allocate_registers /* = true */)
 
 void CodeGenerator::EmitEndBlock(bool free_registers /* = true */, bool emit_return /* = true */)
 {
+  // the next block expects pinned registers in their host registers, the dispatcher expects them in the CPU state
+  if (emit_return)
+    m_register_cache.StorePinnedGuestRegisters();
+  else
+    m_register_cache.LoadPinnedGuestRegisters();
+
   if (free_registers)
   {
     m_register_cache.FreeHostReg(RCPUPTR);
@@ -1975,6 +1999,58 @@ void CodeGenerator::EmitLoadGuestMemoryFastmem(const CodeBlockInstruction& cbi,
   bpi.host_slowmem_pc = GetCurrentFarCodePointer();
   SwitchToFarCode();
 
+  // Once backpatched, every access from this instruction comes through here. Instructions which touch both I/O and
+  // memory (e.g. memcpy) are common, so look up the region again, and only call out when it isn't RAM or scratchpad.
+  if (g_settings.cpu_fastmem_mode == CPUFastmemMode::LUT)
+  {
+    Xbyak::Label check_scratchpad;
+    Xbyak::Label slowmem;
+    const auto emit_load = [this, size, &result](const Xbyak::Reg64& base, const Xbyak::Reg64& offset, u32 disp) {
+      switch (size)
+      {
+        case RegSize_8:
+          m_emit->mov(GetHostReg8(result.host_reg), m_emit->byte[base + offset + disp]);
+          break;
+
+        case RegSize_16:
+          m_emit->mov(GetHostReg16(result.host_reg), m_emit->word[base + offset + disp]);
+          break;
+
+        case RegSize_32:
+          m_emit->mov(GetHostReg32(result.host_reg), m_emit->dword[base + offset + disp]);
+          break;
+      }
+    };
+
+    // the base is null while the cache is isolated
+    m_emit->test(GetFastmemBasePtrReg(), GetFastmemBasePtrReg());
+    m_emit->jz(slowmem);
+    EmitCopyValue(RARG1, address);
+    m_emit->mov(GetHostReg32(RARG2), GetHostReg32(RARG1));
+    m_emit->shr(GetHostReg32(RARG1), 12);
+    m_emit->and_(GetHostReg32(RARG2), HOST_PAGE_OFFSET_MASK);
+    m_emit->mov(GetHostReg64(RARG1), m_emit->qword[GetFastmemBasePtrReg() + GetHostReg64(RARG1) * 8]);
+    m_emit->test(GetHostReg64(RARG1), GetHostReg64(RARG1));
+    m_emit->jz(check_scratchpad);
+    emit_load(GetHostReg64(RARG1), GetHostReg64(RARG2), 0);
+    m_emit->jmp(GetCurrentNearCodePointer());
+
+    // scratchpad is only mapped in KUSEG/KSEG0, and reads don't take any cycles
+    m_emit->L(check_scratchpad);
+    EmitCopyValue(RARG1, address);
+    m_emit->mov(GetHostReg32(RARG2), GetHostReg32(RARG1));
+    m_emit->and_(GetHostReg32(RARG2), DCACHE_LOCATION_MASK & UINT32_C(0x7FFFFFFF));
+    m_emit->cmp(GetHostReg32(RARG2), DCACHE_LOCATION);
+    m_emit->jne(slowmem);
+    m_emit->and_(GetHostReg32(RARG1), DCACHE_OFFSET_MASK);
+    emit_load(GetCPUPtrReg(), GetHostReg64(RARG1), static_cast<u32>(offsetof(State, dcache)));
+    EmitAddCPUStructField(offsetof(State, pending_ticks),
+                          Value::FromConstantU32(static_cast<u32>(-static_cast<s32>(Bus::RAM_READ_TICKS))));
+    m_emit->jmp(GetCurrentNearCodePointer());
+
+    m_emit->L(slowmem);
+  }
+
   // we add the ticks *after* the add here, since we counted incorrectly, then correct for it below
   DebugAssert(m_delayed_cycles_add > 0);
   EmitAddCPUStructField(offsetof(State, pending_ticks), Value::FromConstantU32(static_cast<u32>(m_delayed_cycles_add)));
@@ -2245,6 +2321,70 @@ void CodeGenerator::EmitStoreGuestMemoryFastmem(const CodeBlockInstruction& cbi,
   bpi.host_slowmem_pc = GetCurrentFarCodePointer();
   SwitchToFarCode();
 
+  // Same as loads, writes to code pages still have to go through the slow path to invalidate blocks.
+  if (g_settings.cpu_fastmem_mode == CPUFastmemMode::LUT)
+  {
+    Xbyak::Label check_scratchpad;
+    Xbyak::Label slowmem;
+    const auto emit_store = [this, size, &value](const Xbyak::Reg64& base, const Xbyak::Reg64& offset, u32 disp) {
+      switch (size)
+      {
+        case RegSize_8:
+        {
+          if (value.IsConstant())
+            m_emit->mov(m_emit->byte[base + offset + disp], value.constant_value & 0xFFu);
+          else
+            m_emit->mov(m_emit->byte[base + offset + disp], GetHostReg8(value.host_reg));
+        }
+        break;
+
+        case RegSize_16:
+        {
+          if (value.IsConstant())
+            m_emit->mov(m_emit->word[base + offset + disp], value.constant_value & 0xFFFFu);
+          else
+            m_emit->mov(m_emit->word[base + offset + disp], GetHostReg16(value.host_reg));
+        }
+        break;
+
+        case RegSize_32:
+        {
+          if (value.IsConstant())
+            m_emit->mov(m_emit->dword[base + offset + disp], value.constant_value);
+          else
+            m_emit->mov(m_emit->dword[base + offset + disp], GetHostReg32(value.host_reg));
+        }
+        break;
+      }
+    };
+
+    // the base is null while the cache is isolated, those writes go to the icache
+    m_emit->test(GetFastmemBasePtrReg(), GetFastmemBasePtrReg());
+    m_emit->jz(slowmem);
+    EmitCopyValue(RARG1, address);
+    m_emit->mov(GetHostReg32(RARG2), GetHostReg32(RARG1));
+    m_emit->shr(GetHostReg32(RARG1), 12);
+    m_emit->and_(GetHostReg32(RARG2), HOST_PAGE_OFFSET_MASK);
+    m_emit->mov(GetHostReg64(RARG1),
+                m_emit->qword[GetFastmemBasePtrReg() + GetHostReg64(RARG1) * 8 + (Bus::FASTMEM_LUT_NUM_PAGES * 8)]);
+    m_emit->test(GetHostReg64(RARG1), GetHostReg64(RARG1));
+    m_emit->jz(check_scratchpad);
+    emit_store(GetHostReg64(RARG1), GetHostReg64(RARG2), 0);
+    m_emit->jmp(GetCurrentNearCodePointer());
+
+    m_emit->L(check_scratchpad);
+    EmitCopyValue(RARG1, address);
+    m_emit->mov(GetHostReg32(RARG2), GetHostReg32(RARG1));
+    m_emit->and_(GetHostReg32(RARG2), DCACHE_LOCATION_MASK & UINT32_C(0x7FFFFFFF));
+    m_emit->cmp(GetHostReg32(RARG2), DCACHE_LOCATION);
+    m_emit->jne(slowmem);
+    m_emit->and_(GetHostReg32(RARG1), DCACHE_OFFSET_MASK);
+    emit_store(GetCPUPtrReg(), GetHostReg64(RARG1), static_cast<u32>(offsetof(State, dcache)));
+    m_emit->jmp(GetCurrentNearCodePointer());
+
+    m_emit->L(slowmem);
+  }
+
   DebugAssert(m_delayed_cycles_add > 0);
   EmitAddCPUStructField(offsetof(State, pending_ticks), Value::FromConstantU32(static_cast<u32>(m_delayed_cycles_add)));
 
@@ -2362,7 +2502,10 @@ void CodeGenerator::BackpatchReturn(void* pc, u32 pc_size)
   Log_ProfilePrintf("Backpatching %p to return", pc);
 
   Xbyak::CodeGenerator cg(pc_size, pc);
-  cg.ret();
+  if (s_pinned_register_return)
+    cg.jmp(s_pinned_register_return);
+  else
+    cg.ret();
 
   const s32 nops =
     static_cast<s32>(pc_size) - static_cast<s32>(static_cast<ptrdiff_t>(cg.getCurr() - static_cast<u8*>(pc)));
@@ -2606,6 +2749,16 @@ void CodeGenerator::EmitFlushInterpreterLoadDelay()
   m_emit->mov(GetHostReg32(value), load_delay_value);
   m_emit->mov(reg_ptr, GetHostReg32(value));
 
+  // pinned registers which were carried in from the last block need the delayed value too
+  for (u8 i = 0; i < static_cast<u8>(Reg::count); i++)
+  {
+    if (!m_register_cache.IsPinnedGuestRegisterUnmodified(static_cast<Reg>(i)))
+      continue;
+
+    m_emit->cmp(GetHostReg32(reg.host_reg), i);
+    m_emit->cmove(GetHostReg32(m_register_cache.GetPinnedHostRegister(static_cast<Reg>(i))), GetHostReg32(value));
+  }
+
   // load_delay_reg = Reg::count
   m_emit->mov(load_delay_reg, static_cast<u8>(Reg::count));
 
@@ -2694,6 +2847,728 @@ void CodeGenerator::EmitStallUntilGTEComplete()
   m_emit->mov(m_emit->dword[GetCPUPtrReg() + offsetof(State, pending_ticks)], GetHostReg32(RRETURN));
 }
 
+bool CodeGenerator::EmitInlineGTEInstruction(u32 inst_bits)
+{
+  // The projection, matrix and averaging commands are emitted inline, the lighting and colour commands are called out.
+  // The argument/return registers are never allocated to guest registers, so they're free to use here. RCX is one of
+  // them on both ABIs, and is kept apart since variable shifts need it.
+  const GTE::Instruction inst{inst_bits};
+  std::array<HostReg, 3> temp_regs;
+  {
+    u32 num_temp_regs = 0;
+    for (const HostReg reg : {RARG1, RARG2, RARG3, RARG4})
+    {
+      if (reg != Xbyak::Operand::RCX)
+        temp_regs[num_temp_regs++] = reg;
+    }
+  }
+  const Xbyak::Reg64 acc = GetHostReg64(RRETURN);
+  const Xbyak::Reg64 temp = GetHostReg64(temp_regs[0]);
+  const Xbyak::Reg64 temp2 = GetHostReg64(temp_regs[1]);
+  const Xbyak::Reg32 acc32 = acc.cvt32();
+  const Xbyak::Reg32 temp32 = temp.cvt32();
+  const Xbyak::Reg32 temp2_32 = temp2.cvt32();
+  const Xbyak::Reg32 flag = GetHostReg32(temp_regs[2]);
+  const Xbyak::Reg64 count = m_emit->rcx;
+  const Xbyak::Reg32 count32 = m_emit->ecx;
+  const auto gte_reg = [](u32 index) { return State::GTERegisterOffset(index); };
+
+  // FLAG is cleared by every command, and the MAC0/OTZ bits set here are all part of the error bit.
+  const auto set_mac0 = [this, &acc, &acc32, &temp32, &flag, &gte_reg]() {
+    m_emit->xor_(flag, flag);
+    m_emit->mov(temp32, UINT32_C(0x80010000));
+    m_emit->cmp(acc, INT32_C(0x7FFFFFFF));
+    m_emit->cmovg(flag, temp32);
+    m_emit->mov(temp32, UINT32_C(0x80008000));
+    m_emit->cmp(acc, UINT32_C(0x80000000)); // sign-extended to -80000000h
+    m_emit->cmovl(flag, temp32);
+    m_emit->mov(m_emit->dword[GetCPUPtrReg() + gte_reg(24)], acc32);
+  };
+
+  // Same as above without clearing FLAG, for values which are only range checked against MAC0.
+  const auto check_mac0 = [this, &flag](const Xbyak::Reg64& value) {
+    Xbyak::Label not_overflow, done;
+    m_emit->cmp(value, INT32_C(0x7FFFFFFF));
+    m_emit->jle(not_overflow);
+    m_emit->or_(flag, UINT32_C(0x80010000));
+    m_emit->jmp(done);
+    m_emit->L(not_overflow);
+    m_emit->cmp(value, UINT32_C(0x80000000)); // sign-extended to -80000000h
+    m_emit->jge(done);
+    m_emit->or_(flag, UINT32_C(0x80008000));
+    m_emit->L(done);
+  };
+
+  // Sets the MAC1-3 overflow bits if acc doesn't fit in 44 bits, optionally sign-extending acc from bit 43.
+  const auto check_mac123 = [this, &acc, &temp, &temp2_32, &count32, &flag](u32 index, bool sign_extend) {
+    Xbyak::Label in_range;
+    m_emit->mov(temp, acc);
+    m_emit->shl(temp, 20);
+    m_emit->sar(temp, 20);
+    m_emit->cmp(temp, acc);
+    m_emit->je(in_range);
+    m_emit->mov(temp2_32, UINT32_C(0x80000000) | (UINT32_C(1) << (31 - index)));
+    m_emit->mov(count32, UINT32_C(0x80000000) | (UINT32_C(1) << (28 - index)));
+    m_emit->cmovg(temp2_32, count32); // sign-extended value is greater, so it was below the minimum
+    m_emit->or_(flag, temp2_32);
+    m_emit->L(in_range);
+    if (sign_extend)
+      m_emit->mov(acc, temp);
+  };
+
+  // Clamps value to [min_value, max_value], setting flag_bits if it was outside.
+  const auto saturate = [this, &flag](const Xbyak::Reg32& value, s32 min_value, s32 max_value, u32 flag_bits) {
+    Xbyak::Label not_below, done;
+    m_emit->cmp(value, min_value);
+    m_emit->jge(not_below);
+    m_emit->mov(value, static_cast<u32>(min_value));
+    m_emit->or_(flag, flag_bits);
+    m_emit->jmp(done);
+    m_emit->L(not_below);
+    m_emit->cmp(value, max_value);
+    m_emit->jle(done);
+    m_emit->mov(value, static_cast<u32>(max_value));
+    m_emit->or_(flag, flag_bits);
+    m_emit->L(done);
+  };
+
+  // acc = (T[row] * 1000h) + M[row][0] * V[0] + M[row][1] * V[1] + M[row][2] * V[2], with each step checked like
+  // the GTE does. Offsets are relative to the GTE registers, a translation offset of zero means no translation.
+  const auto dot3 = [this, &acc, &acc32, &temp, &temp2, &check_mac123](u32 index, u32 row_offset,
+                                                                        u32 translation_offset,
+                                                                        const std::array<u32, 3>& vector_offsets) {
+    if (translation_offset != 0)
+    {
+      m_emit->movsxd(acc, m_emit->dword[GetCPUPtrReg() + translation_offset]);
+      m_emit->shl(acc, 12);
+    }
+    else
+    {
+      m_emit->xor_(acc32, acc32);
+    }
+
+    for (u32 i = 0; i < 3; i++)
+    {
+      m_emit->movsx(temp, m_emit->word[GetCPUPtrReg() + row_offset + (i * sizeof(s16))]);
+      m_emit->movsx(temp2, m_emit->word[GetCPUPtrReg() + vector_offsets[i]]);
+      m_emit->imul(temp, temp2);
+      m_emit->add(acc, temp);
+
+      // without a translation the first two products can't leave the 44-bit range
+      if (i < 2 && translation_offset != 0)
+        check_mac123(index, true);
+    }
+
+    check_mac123(index, false);
+  };
+
+  const auto vector_offsets = [&gte_reg](u32 vector) -> std::array<u32, 3> {
+    if (vector == 3)
+      return {{gte_reg(9), gte_reg(10), gte_reg(11)}};
+    else
+      return {{gte_reg(vector * 2), gte_reg(vector * 2) + static_cast<u32>(sizeof(s16)), gte_reg(vector * 2 + 1)}};
+  };
+
+  // MAC = acc SAR shift
+  const auto set_mac = [this, &acc, &acc32, &gte_reg](u32 index, u8 shift) {
+    if (shift > 0)
+      m_emit->sar(acc, shift);
+    m_emit->mov(m_emit->dword[GetCPUPtrReg() + gte_reg(24 + index)], acc32);
+  };
+
+  // IR = saturated MAC. IR1/IR2 saturation is part of the error bit, IR3 isn't.
+  const auto set_ir = [this, &acc32, &saturate, &gte_reg](u32 index, bool lm) {
+    m_emit->mov(acc32, m_emit->dword[GetCPUPtrReg() + gte_reg(24 + index)]);
+    saturate(acc32, lm ? 0 : -0x8000, 0x7FFF,
+             ((index < 3) ? UINT32_C(0x80000000) : 0) | (UINT32_C(1) << (25 - index)));
+    m_emit->mov(m_emit->dword[GetCPUPtrReg() + gte_reg(8 + index)], acc32);
+  };
+
+  // Projects vertex V[vector] to the SXY and SZ FIFOs, see GTE's RTPS().
+  const auto rtps = [&](u32 vector, bool last) {
+    const u8 shift = inst.GetShift();
+    const bool lm = inst.lm;
+    const std::array<u32, 3> v = vector_offsets(vector);
+    for (u32 i = 0; i < 2; i++)
+    {
+      dot3(i + 1, gte_reg(32) + (i * 3 * sizeof(s16)), gte_reg(37 + i), v);
+      set_mac(i + 1, shift);
+      set_ir(i + 1, lm);
+    }
+
+    // IR3 is saturated from MAC3, but the flag is only set if MAC3 SAR 12 is out of range.
+    Xbyak::Label ir3_saturated, ir3_done;
+    dot3(3, gte_reg(32) + (6 * sizeof(s16)), gte_reg(39), v);
+    m_emit->mov(temp, acc);
+    if (shift > 0)
+      m_emit->sar(temp, shift);
+    m_emit->mov(m_emit->dword[GetCPUPtrReg() + gte_reg(27)], temp32);
+    m_emit->mov(temp2_32, lm ? 0u : static_cast<u32>(-0x8000));
+    m_emit->cmp(temp32, temp2_32);
+    m_emit->cmovl(temp32, temp2_32);
+    m_emit->mov(temp2_32, 0x7FFF);
+    m_emit->cmp(temp32, temp2_32);
+    m_emit->cmovg(temp32, temp2_32);
+    m_emit->mov(m_emit->dword[GetCPUPtrReg() + gte_reg(11)], temp32);
+    m_emit->sar(acc, 12);
+    m_emit->cmp(acc32, -0x8000);
+    m_emit->jl(ir3_saturated);
+    m_emit->cmp(acc32, 0x7FFF);
+    m_emit->jle(ir3_done);
+    m_emit->L(ir3_saturated);
+    m_emit->or_(flag, UINT32_C(0x00400000));
+    m_emit->L(ir3_done);
+
+    // SZ3 = MAC3 SAR 12, pushed to the FIFO
+    saturate(acc32, 0, 0xFFFF, UINT32_C(0x80040000));
+    for (u32 reg = 16; reg < 19; reg++)
+    {
+      m_emit->mov(temp32, m_emit->dword[GetCPUPtrReg() + gte_reg(reg + 1)]);
+      m_emit->mov(m_emit->dword[GetCPUPtrReg() + gte_reg(reg)], temp32);
+    }
+    m_emit->mov(m_emit->dword[GetCPUPtrReg() + gte_reg(19)], acc32);
+
+    // acc = UNR(H / SZ3), overflows when SZ3 * 2 <= H
+    Xbyak::Label divide_overflow, divide_done;
+    m_emit->movzx(temp32, m_emit->word[GetCPUPtrReg() + gte_reg(58)]);
+    m_emit->lea(temp2_32, m_emit->dword[acc + acc]);
+    m_emit->cmp(temp2_32, temp32);
+    m_emit->jbe(divide_overflow, Xbyak::CodeGenerator::T_NEAR);
+
+    // normalize SZ3 to bit 15, SZ3 isn't zero here
+    m_emit->bsr(count32, acc32);
+    m_emit->xor_(count32, 15);
+    m_emit->shl(temp32, m_emit->cl);
+    m_emit->shl(acc32, m_emit->cl);
+    m_emit->or_(acc32, 0x8000);
+
+    // x = 101h + table[((divisor & 7FFFh) + 40h) SAR 7]
+    m_emit->mov(count32, acc32);
+    m_emit->and_(count32, 0x7FFF);
+    m_emit->add(count32, 0x40);
+    m_emit->shr(count32, 7);
+    m_emit->mov(temp2, reinterpret_cast<size_t>(GTE::GetUNRTable()));
+    m_emit->movzx(count32, m_emit->byte[temp2 + count]);
+    m_emit->add(count32, 0x101);
+
+    // d = ((divisor * -x) + 80h) SAR 8, recip = ((x * (20000h + d)) + 80h) SAR 8
+    m_emit->imul(acc32, count32);
+    m_emit->neg(acc32);
+    m_emit->add(acc32, 0x80);
+    m_emit->sar(acc32, 8);
+    m_emit->add(acc32, 0x20000);
+    m_emit->imul(acc32, count32);
+    m_emit->add(acc32, 0x80);
+    m_emit->sar(acc32, 8);
+
+    // min(1FFFFh, ((lhs * recip) + 8000h) SHR 16), the 32-bit ops leave the upper halves clear
+    m_emit->imul(acc, temp);
+    m_emit->add(acc, 0x8000);
+    m_emit->shr(acc, 16);
+    m_emit->mov(temp32, 0x1FFFF);
+    m_emit->cmp(acc32, temp32);
+    m_emit->cmova(acc32, temp32);
+    m_emit->jmp(divide_done);
+
+    m_emit->L(divide_overflow);
+    m_emit->mov(acc32, 0x1FFFF);
+    m_emit->or_(flag, UINT32_C(0x80020000));
+    m_emit->L(divide_done);
+
+    // SX2 = (acc * IR1 + OFX) SAR 16, SY2 = (acc * IR2 + OFY) SAR 16, pushed to the FIFO
+    m_emit->movsx(temp, m_emit->word[GetCPUPtrReg() + gte_reg(9)]);
+    m_emit->imul(temp, acc);
+    m_emit->movsxd(temp2, m_emit->dword[GetCPUPtrReg() + gte_reg(56)]);
+    m_emit->add(temp, temp2);
+    check_mac0(temp);
+    m_emit->sar(temp, 16);
+    saturate(temp32, -0x400, 0x3FF, UINT32_C(0x80004000));
+
+    m_emit->movsx(temp2, m_emit->word[GetCPUPtrReg() + gte_reg(10)]);
+    m_emit->imul(temp2, acc);
+    m_emit->movsxd(count, m_emit->dword[GetCPUPtrReg() + gte_reg(57)]);
+    m_emit->add(temp2, count);
+    check_mac0(temp2);
+    m_emit->sar(temp2, 16);
+    saturate(temp2_32, -0x400, 0x3FF, UINT32_C(0x80002000));
+
+    m_emit->mov(count32, m_emit->dword[GetCPUPtrReg() + gte_reg(13)]);
+    m_emit->mov(m_emit->dword[GetCPUPtrReg() + gte_reg(12)], count32);
+    m_emit->mov(count32, m_emit->dword[GetCPUPtrReg() + gte_reg(14)]);
+    m_emit->mov(m_emit->dword[GetCPUPtrReg() + gte_reg(13)], count32);
+    m_emit->movzx(temp32, temp.cvt16());
+    m_emit->shl(temp2_32, 16);
+    m_emit->or_(temp32, temp2_32);
+    m_emit->mov(m_emit->dword[GetCPUPtrReg() + gte_reg(14)], temp32);
+
+    if (last)
+    {
+      // MAC0 = acc * DQA + DQB, IR0 = clamp(MAC0 SAR 12, 0, 1000h)
+      m_emit->movsx(temp, m_emit->word[GetCPUPtrReg() + gte_reg(59)]);
+      m_emit->imul(temp, acc);
+      m_emit->movsxd(temp2, m_emit->dword[GetCPUPtrReg() + gte_reg(60)]);
+      m_emit->add(temp, temp2);
+      check_mac0(temp);
+      m_emit->mov(m_emit->dword[GetCPUPtrReg() + gte_reg(24)], temp32);
+      m_emit->sar(temp, 12);
+      saturate(temp32, 0, 0x1000, UINT32_C(0x00001000));
+      m_emit->mov(m_emit->dword[GetCPUPtrReg() + gte_reg(8)], temp32);
+    }
+  };
+
+  switch (inst.command)
+  {
+    case 0x01: // RTPS
+    case 0x30: // RTPT
+    {
+      // PGXP and the widescreen hack change the projection, so they go through the GTE.
+      if (g_settings.gpu_pgxp_enable || GTE::IsProjectionScaled())
+        return false;
+
+      m_emit->xor_(flag, flag);
+      if (inst.command == 0x01)
+      {
+        rtps(0, true);
+      }
+      else
+      {
+        rtps(0, false);
+        rtps(1, false);
+        rtps(2, true);
+      }
+
+      m_emit->mov(m_emit->dword[GetCPUPtrReg() + gte_reg(63)], flag);
+      return true;
+    }
+
+    case 0x06: // NCLIP
+    {
+      if (g_settings.gpu_pgxp_enable && g_settings.gpu_pgxp_culling)
+        return false;
+
+      // MAC0 = SX0*SY1 + SX1*SY2 + SX2*SY0 - SX0*SY2 - SX1*SY0 - SX2*SY1
+      const auto multiply_sxy = [this, &temp, &temp2, &gte_reg](u32 x_reg, u32 y_reg) {
+        m_emit->movsx(temp, m_emit->word[GetCPUPtrReg() + gte_reg(x_reg)]);
+        m_emit->movsx(temp2, m_emit->word[GetCPUPtrReg() + gte_reg(y_reg) + sizeof(s16)]);
+        m_emit->imul(temp, temp2);
+      };
+
+      multiply_sxy(12, 13);
+      m_emit->mov(acc, temp);
+      multiply_sxy(13, 14);
+      m_emit->add(acc, temp);
+      multiply_sxy(14, 12);
+      m_emit->add(acc, temp);
+      multiply_sxy(12, 14);
+      m_emit->sub(acc, temp);
+      multiply_sxy(13, 12);
+      m_emit->sub(acc, temp);
+      multiply_sxy(14, 13);
+      m_emit->sub(acc, temp);
+
+      set_mac0();
+      m_emit->mov(m_emit->dword[GetCPUPtrReg() + gte_reg(63)], flag);
+      return true;
+    }
+
+    case 0x12: // MVMVA
+    {
+      // The garbage matrix and the broken FC translation are left to the GTE.
+      const u32 matrix = inst.mvmva_multiply_matrix;
+      const u32 translation = inst.mvmva_translation_vector;
+      if (matrix == 3 || translation == 2)
+        return false;
+
+      // RT/LLM/LCM and TR/BK are 8 registers apart. The vector can be IR1-3, so they're only written at the end.
+      const std::array<u32, 3> v = vector_offsets(inst.mvmva_multiply_vector);
+      m_emit->xor_(flag, flag);
+      for (u32 i = 0; i < 3; i++)
+      {
+        dot3(i + 1, gte_reg(32 + (matrix * 8)) + (i * 3 * sizeof(s16)),
+             (translation == 3) ? 0 : gte_reg(37 + (translation * 8) + i), v);
+        set_mac(i + 1, inst.GetShift());
+      }
+      for (u32 i = 0; i < 3; i++)
+        set_ir(i + 1, inst.lm);
+
+      m_emit->mov(m_emit->dword[GetCPUPtrReg() + gte_reg(63)], flag);
+      return true;
+    }
+
+    case 0x2D: // AVSZ3
+    case 0x2E: // AVSZ4
+    {
+      // MAC0 = ZSF3 * (SZ1 + SZ2 + SZ3) or ZSF4 * (SZ0 + SZ1 + SZ2 + SZ3)
+      const bool avsz4 = (inst.command == 0x2E);
+      const u32 first_sz = avsz4 ? 16 : 17;
+      m_emit->movzx(temp32, m_emit->word[GetCPUPtrReg() + gte_reg(first_sz)]);
+      for (u32 reg = first_sz + 1; reg <= 19; reg++)
+      {
+        m_emit->movzx(temp2_32, m_emit->word[GetCPUPtrReg() + gte_reg(reg)]);
+        m_emit->add(temp32, temp2_32);
+      }
+
+      // the 32-bit adds zero the upper half of temp
+      m_emit->movsx(acc, m_emit->word[GetCPUPtrReg() + gte_reg(avsz4 ? 62 : 61)]);
+      m_emit->imul(acc, temp);
+      set_mac0();
+
+      // OTZ = clamp(s32(MAC0 SAR 12), 0, FFFFh)
+      m_emit->sar(acc, 12);
+      saturate(acc32, 0, 0xFFFF, UINT32_C(0x80040000));
+      m_emit->mov(m_emit->dword[GetCPUPtrReg() + gte_reg(7)], acc32);
+      m_emit->mov(m_emit->dword[GetCPUPtrReg() + gte_reg(63)], flag);
+      return true;
+    }
+
+    default:
+      return false;
+  }
+}
+
+// Looks up the PGXP shadow memory entry for the address in addr, leaving a pointer to it in entry. Scratchpad and
+// non-RAM addresses jump to slow, RAM pages which don't have shadow memory yet jump to unallocated.
+static void EmitPGXPMemoryLookup(Xbyak::CodeGenerator* emit, const Xbyak::Reg64& addr, const Xbyak::Reg64& temp,
+                                 const Xbyak::Reg64& entry, Xbyak::Label& slow, Xbyak::Label& unallocated)
+{
+  emit->mov(temp.cvt32(), addr.cvt32());
+  emit->and_(temp.cvt32(), CPU::DCACHE_LOCATION_MASK);
+  emit->cmp(temp.cvt32(), CPU::DCACHE_LOCATION);
+  emit->je(slow, Xbyak::CodeGenerator::T_NEAR);
+  emit->and_(addr.cvt32(), CPU::PHYSICAL_MEMORY_ADDRESS_MASK);
+  emit->cmp(addr.cvt32(), Bus::RAM_MIRROR_END);
+  emit->jae(slow, Xbyak::CodeGenerator::T_NEAR);
+  emit->mov(temp, reinterpret_cast<size_t>(&Bus::g_ram_mask));
+  emit->and_(addr.cvt32(), emit->dword[temp]);
+
+  emit->mov(temp.cvt32(), addr.cvt32());
+  emit->shr(temp.cvt32(), PGXP::MEM_PAGE_SHIFT);
+  emit->mov(entry, reinterpret_cast<size_t>(PGXP::GetMemPageTable()));
+  emit->mov(entry, emit->qword[entry + temp * 8]);
+  emit->test(entry, entry);
+  emit->jz(unallocated, Xbyak::CodeGenerator::T_NEAR);
+
+  // one entry per word
+  emit->and_(addr.cvt32(), ((1u << PGXP::MEM_PAGE_SHIFT) - 1u) & ~3u);
+  emit->lea(entry, emit->qword[entry + addr * (PGXP::MEM_VALUE_SIZE / sizeof(u32))]);
+}
+
+bool CodeGenerator::EmitInlinePGXPMove(u32 dest_reg, u32 src_reg, const Value& src_value)
+{
+  // Validate(src); dest = src. The argument/return registers aren't allocated to guest registers.
+  DebugAssert(src_value.IsConstant() || (src_value.GetHostRegister() != RRETURN && src_value.GetHostRegister() != RARG1));
+  const Xbyak::Reg64 regs = GetHostReg64(RARG1);
+  const Xbyak::Reg64 temp = GetHostReg64(RRETURN);
+  const u32 src_offset = src_reg * PGXP::CPU_REG_SIZE;
+  const u32 dest_offset = dest_reg * PGXP::CPU_REG_SIZE;
+  Xbyak::Label valid;
+
+  EmitLoadGlobalAddress(RARG1, PGXP::GetCPURegisterPointer(0));
+  if (src_value.IsConstant())
+    m_emit->cmp(m_emit->dword[regs + src_offset + PGXP::CPU_REG_VALUE_OFFSET], Truncate32(src_value.constant_value));
+  else
+    m_emit->cmp(m_emit->dword[regs + src_offset + PGXP::CPU_REG_VALUE_OFFSET], GetHostReg32(src_value));
+  m_emit->je(valid);
+  m_emit->and_(m_emit->dword[regs + src_offset + PGXP::CPU_REG_FLAGS_OFFSET], ~PGXP::CPU_REG_VALID_MASK);
+  m_emit->L(valid);
+
+  if (dest_reg != src_reg)
+  {
+    m_emit->mov(temp, m_emit->qword[regs + src_offset]);
+    m_emit->mov(m_emit->qword[regs + dest_offset], temp);
+    m_emit->mov(temp, m_emit->qword[regs + src_offset + 8]);
+    m_emit->mov(m_emit->qword[regs + dest_offset + 8], temp);
+    m_emit->mov(temp.cvt32(), m_emit->dword[regs + src_offset + 16]);
+    m_emit->mov(m_emit->dword[regs + dest_offset + 16], temp.cvt32());
+  }
+
+  return true;
+}
+
+bool CodeGenerator::EmitInlinePGXPLoadUpper(u32 dest_reg, u32 imm)
+{
+  // dest = {0, imm, 0}, with valid x and y
+  const Xbyak::Reg64 regs = GetHostReg64(RARG1);
+  const float y = static_cast<float>(static_cast<s16>(Truncate16(imm)));
+  u32 y_bits;
+  std::memcpy(&y_bits, &y, sizeof(y_bits));
+
+  EmitLoadGlobalAddress(RARG1, PGXP::GetCPURegisterPointer(dest_reg));
+  m_emit->mov(m_emit->dword[regs + 0], 0);
+  m_emit->mov(m_emit->dword[regs + 4], y_bits);
+  m_emit->mov(m_emit->dword[regs + 8], 0);
+  m_emit->mov(m_emit->dword[regs + PGXP::CPU_REG_FLAGS_OFFSET], PGXP::CPU_REG_VALID_XY);
+  m_emit->mov(m_emit->dword[regs + PGXP::CPU_REG_VALUE_OFFSET], imm << 16);
+  return true;
+}
+
+bool CodeGenerator::EmitInlinePGXPBitwiseImmediate(u32 inst_bits, const Value& src_value)
+{
+  // rt = Validate(rs), with x taken from the low half of the result (ori/andi).
+  const Instruction inst{inst_bits};
+  const u32 imm = inst.i.imm_zext32();
+  const bool is_and = (inst.op == InstructionOp::andi);
+  const bool sets_x = (imm != 0 && (!is_and || imm != 0xFFFF));
+  const u32 flags = (sets_x ? PGXP::CPU_REG_VALID_X : 0u) | (is_and ? PGXP::CPU_REG_VALID_Y : 0u);
+  const Xbyak::Reg64 regs = GetHostReg64(RARG1);
+  const Xbyak::Reg32 value = GetHostReg32(RRETURN);
+  const u32 src_reg = static_cast<u32>(inst.i.rs.GetValue());
+  const u32 dest_reg = static_cast<u32>(inst.i.rt.GetValue());
+  const u32 dest_offset = dest_reg * PGXP::CPU_REG_SIZE;
+
+  EmitInlinePGXPMove(dest_reg, src_reg, src_value);
+  if (src_value.IsConstant())
+  {
+    const u32 src = Truncate32(src_value.constant_value);
+    m_emit->mov(value, is_and ? (src & imm) : (src | imm));
+  }
+  else
+  {
+    m_emit->mov(value, GetHostReg32(src_value));
+    if (is_and)
+      m_emit->and_(value, imm);
+    else
+      m_emit->or_(value, imm);
+  }
+  m_emit->mov(m_emit->dword[regs + dest_offset + PGXP::CPU_REG_VALUE_OFFSET], value);
+
+  if (is_and)
+  {
+    m_emit->mov(m_emit->dword[regs + dest_offset + 4], 0);
+    if (imm == 0)
+      m_emit->mov(m_emit->dword[regs + dest_offset + 0], 0);
+  }
+  if (sets_x)
+  {
+    m_emit->movsx(value, value.cvt16());
+    m_emit->cvtsi2ss(m_emit->xmm0, value);
+    m_emit->movss(m_emit->dword[regs + dest_offset + 0], m_emit->xmm0);
+  }
+  if (flags != 0)
+    m_emit->or_(m_emit->dword[regs + dest_offset + PGXP::CPU_REG_FLAGS_OFFSET], flags);
+
+  return true;
+}
+
+bool CodeGenerator::EmitInlinePGXPAddImmediate(u32 inst_bits, const Value& src_value)
+{
+  // rt = Validate(rs) + imm, carrying between the 16-bit halves of x and y the same way PGXP::CPU_ADDI does.
+  const Instruction inst{inst_bits};
+  const u32 imm = inst.i.imm_sext32();
+  const float imm_high = static_cast<float>(static_cast<s16>(Truncate16(imm >> 16)));
+  const Xbyak::Reg64 regs = GetHostReg64(RARG1);
+  const Xbyak::Reg64 value = GetHostReg64(RRETURN);
+  const Xbyak::Reg64 temp = GetHostReg64(RARG2);
+  const u32 src_reg = static_cast<u32>(inst.i.rs.GetValue());
+  const u32 dest_reg = static_cast<u32>(inst.i.rt.GetValue());
+  const u32 dest_offset = dest_reg * PGXP::CPU_REG_SIZE;
+  const auto x = m_emit->dword[regs + dest_offset + 0];
+  const auto y = m_emit->dword[regs + dest_offset + 4];
+  const auto load_float = [this, &temp](const Xbyak::Xmm& reg, float f) {
+    u32 bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    m_emit->mov(temp.cvt32(), bits);
+    m_emit->movd(reg, temp.cvt32());
+  };
+  const auto load_double = [this, &temp](const Xbyak::Xmm& reg, double d) {
+    u64 bits;
+    std::memcpy(&bits, &d, sizeof(bits));
+    m_emit->mov(temp, bits);
+    m_emit->movq(reg, temp);
+  };
+  const auto float_bits = [](float f) {
+    u32 bits;
+    std::memcpy(&bits, &f, sizeof(bits));
+    return bits;
+  };
+  DebugAssert(imm != 0);
+
+  EmitInlinePGXPMove(dest_reg, src_reg, src_value);
+  if (src_value.IsConstant())
+  {
+    m_emit->mov(value.cvt32(), Truncate32(src_value.constant_value) + imm);
+  }
+  else
+  {
+    m_emit->mov(value.cvt32(), GetHostReg32(src_value));
+    m_emit->add(value.cvt32(), imm);
+  }
+  m_emit->mov(m_emit->dword[regs + dest_offset + PGXP::CPU_REG_VALUE_OFFSET], value.cvt32());
+
+  // x = f16Unsign(x) + (imm & 0xFFFF), NaN takes the negative path
+  Xbyak::Label unsigned_x;
+  m_emit->cvtss2sd(m_emit->xmm0, x);
+  m_emit->xorpd(m_emit->xmm1, m_emit->xmm1);
+  m_emit->comisd(m_emit->xmm0, m_emit->xmm1);
+  m_emit->jae(unsigned_x);
+  load_double(m_emit->xmm1, 65535.0);
+  m_emit->addsd(m_emit->xmm0, m_emit->xmm1);
+  load_double(m_emit->xmm1, 1.0);
+  m_emit->addsd(m_emit->xmm0, m_emit->xmm1);
+  m_emit->L(unsigned_x);
+  m_emit->cvtsd2ss(m_emit->xmm0, m_emit->xmm0);
+  load_float(m_emit->xmm1, static_cast<float>(Truncate16(imm)));
+  m_emit->addss(m_emit->xmm0, m_emit->xmm1);
+
+  // carry into y when x leaves [0, 65535]
+  Xbyak::Label carry_done, carry_up;
+  m_emit->mov(value.cvt32(), float_bits(imm_high + 0.0f));
+  load_float(m_emit->xmm1, 65535.0f);
+  m_emit->ucomiss(m_emit->xmm0, m_emit->xmm1);
+  m_emit->ja(carry_up);
+  m_emit->xorps(m_emit->xmm1, m_emit->xmm1);
+  m_emit->ucomiss(m_emit->xmm1, m_emit->xmm0);
+  m_emit->jbe(carry_done);
+  m_emit->mov(value.cvt32(), float_bits(imm_high - 1.0f));
+  m_emit->jmp(carry_done);
+  m_emit->L(carry_up);
+  m_emit->mov(value.cvt32(), float_bits(imm_high + 1.0f));
+  m_emit->L(carry_done);
+
+  // x = f16Sign(x)
+  m_emit->cvtss2sd(m_emit->xmm0, m_emit->xmm0);
+  load_double(m_emit->xmm1, 65536.0);
+  m_emit->mulsd(m_emit->xmm0, m_emit->xmm1);
+  m_emit->cvttsd2si(temp, m_emit->xmm0);
+  m_emit->cvtsi2sd(m_emit->xmm0, temp.cvt32());
+  m_emit->divsd(m_emit->xmm0, m_emit->xmm1);
+  m_emit->cvtsd2ss(m_emit->xmm0, m_emit->xmm0);
+  m_emit->movss(x, m_emit->xmm0);
+
+  // y += imm_high + carry, then wrap to [-32768, 32767]
+  m_emit->movss(m_emit->xmm0, y);
+  m_emit->movd(m_emit->xmm1, value.cvt32());
+  m_emit->addss(m_emit->xmm0, m_emit->xmm1);
+
+  Xbyak::Label wrap_done, wrap_down;
+  m_emit->xor_(value.cvt32(), value.cvt32());
+  load_float(m_emit->xmm1, 32767.0f);
+  m_emit->ucomiss(m_emit->xmm0, m_emit->xmm1);
+  m_emit->ja(wrap_down);
+  load_float(m_emit->xmm1, -32768.0f);
+  m_emit->ucomiss(m_emit->xmm1, m_emit->xmm0);
+  m_emit->jbe(wrap_done);
+  m_emit->mov(value.cvt32(), float_bits(65536.0f));
+  m_emit->jmp(wrap_done);
+  m_emit->L(wrap_down);
+  m_emit->mov(value.cvt32(), float_bits(-65536.0f));
+  m_emit->L(wrap_done);
+  m_emit->movd(m_emit->xmm1, value.cvt32());
+  m_emit->addss(m_emit->xmm0, m_emit->xmm1);
+  m_emit->movss(y, m_emit->xmm0);
+
+  return true;
+}
+
+bool CodeGenerator::EmitInlinePGXPLoadWord(u32 inst_bits, const Value& address, const Value& value)
+{
+  // rt = Validate(Mem[address]). Only RAM with existing shadow memory is handled here, the rest goes to PGXP.
+  DebugAssert(value.IsInHostRegister() && value.GetHostRegister() != RRETURN && value.GetHostRegister() != RARG1 &&
+              value.GetHostRegister() != RARG2 && value.GetHostRegister() != RARG3);
+  const Instruction inst{inst_bits};
+  const Xbyak::Reg64 addr = GetHostReg64(RRETURN);
+  const Xbyak::Reg64 temp = GetHostReg64(RARG1);
+  const Xbyak::Reg64 entry = GetHostReg64(RARG2);
+  const Xbyak::Reg64 regs = GetHostReg64(RARG3);
+  Xbyak::Label valid, unallocated, slow, done;
+
+  if (address.IsConstant())
+    m_emit->mov(addr.cvt32(), Truncate32(address.constant_value));
+  else
+    m_emit->mov(addr.cvt32(), GetHostReg32(address));
+  EmitPGXPMemoryLookup(m_emit, addr, temp, entry, slow, unallocated);
+
+  m_emit->cmp(m_emit->dword[entry + PGXP::MEM_VALUE_OFFSET], GetHostReg32(value));
+  m_emit->je(valid);
+  m_emit->and_(m_emit->dword[entry + PGXP::MEM_Z_AND_FLAGS_OFFSET], ~static_cast<u32>(PGXP::MEM_FLAGS_BITS));
+  m_emit->L(valid);
+
+  // unpack flags from bits 0-3 to bits 0/8/16/24
+  EmitLoadGlobalAddress(RARG3, PGXP::GetCPURegisterPointer(static_cast<u32>(inst.i.rt.GetValue())));
+  m_emit->mov(temp, m_emit->qword[entry]);
+  m_emit->mov(m_emit->qword[regs], temp);
+  m_emit->mov(temp.cvt32(), m_emit->dword[entry + PGXP::MEM_Z_AND_FLAGS_OFFSET]);
+  m_emit->mov(addr.cvt32(), temp.cvt32());
+  m_emit->and_(temp.cvt32(), ~static_cast<u32>(PGXP::MEM_FLAGS_BITS));
+  m_emit->mov(m_emit->dword[regs + 8], temp.cvt32());
+  m_emit->and_(addr.cvt32(), PGXP::MEM_FLAGS_BITS);
+  m_emit->imul(addr.cvt32(), addr.cvt32(), 0x00204081);
+  m_emit->and_(addr.cvt32(), PGXP::CPU_REG_VALID_MASK);
+  m_emit->mov(m_emit->dword[regs + PGXP::CPU_REG_FLAGS_OFFSET], addr.cvt32());
+  m_emit->mov(temp.cvt32(), m_emit->dword[entry + PGXP::MEM_VALUE_OFFSET]);
+  m_emit->mov(m_emit->dword[regs + PGXP::CPU_REG_VALUE_OFFSET], temp.cvt32());
+  m_emit->jmp(done, Xbyak::CodeGenerator::T_NEAR);
+
+  // nothing stored here yet, so the value is invalid
+  m_emit->L(unallocated);
+  EmitLoadGlobalAddress(RARG3, PGXP::GetCPURegisterPointer(static_cast<u32>(inst.i.rt.GetValue())));
+  m_emit->xor_(temp.cvt32(), temp.cvt32());
+  m_emit->mov(m_emit->qword[regs], temp);
+  m_emit->mov(m_emit->qword[regs + 8], temp);
+  m_emit->mov(m_emit->dword[regs + 16], temp.cvt32());
+  m_emit->jmp(done, Xbyak::CodeGenerator::T_NEAR);
+
+  m_emit->L(slow);
+  EmitFunctionCall(nullptr, &PGXP::CPU_LW, Value::FromConstantU32(inst_bits), value, address);
+  m_emit->L(done);
+  return true;
+}
+
+bool CodeGenerator::EmitInlinePGXPStoreWord(u32 inst_bits, const Value& address, const Value& value)
+{
+  // Mem[address] = Validate(rt). Stores which need a new shadow page go to PGXP.
+  DebugAssert(value.IsConstant() ||
+              (value.GetHostRegister() != RRETURN && value.GetHostRegister() != RARG1 &&
+               value.GetHostRegister() != RARG2 && value.GetHostRegister() != RARG3));
+  const Instruction inst{inst_bits};
+  const Xbyak::Reg64 addr = GetHostReg64(RRETURN);
+  const Xbyak::Reg64 temp = GetHostReg64(RARG1);
+  const Xbyak::Reg64 entry = GetHostReg64(RARG2);
+  const Xbyak::Reg64 regs = GetHostReg64(RARG3);
+  Xbyak::Label valid, unallocated, slow, done;
+
+  EmitLoadGlobalAddress(RARG3, PGXP::GetCPURegisterPointer(static_cast<u32>(inst.i.rt.GetValue())));
+  if (value.IsConstant())
+    m_emit->cmp(m_emit->dword[regs + PGXP::CPU_REG_VALUE_OFFSET], Truncate32(value.constant_value));
+  else
+    m_emit->cmp(m_emit->dword[regs + PGXP::CPU_REG_VALUE_OFFSET], GetHostReg32(value));
+  m_emit->je(valid);
+  m_emit->and_(m_emit->dword[regs + PGXP::CPU_REG_FLAGS_OFFSET], ~PGXP::CPU_REG_VALID_MASK);
+  m_emit->L(valid);
+
+  if (address.IsConstant())
+    m_emit->mov(addr.cvt32(), Truncate32(address.constant_value));
+  else
+    m_emit->mov(addr.cvt32(), GetHostReg32(address));
+  EmitPGXPMemoryLookup(m_emit, addr, temp, entry, slow, unallocated);
+
+  // pack flags from bits 0/8/16/24 into the low bits of z
+  m_emit->mov(temp, m_emit->qword[regs]);
+  m_emit->mov(m_emit->qword[entry], temp);
+  m_emit->mov(temp.cvt32(), m_emit->dword[regs + PGXP::CPU_REG_FLAGS_OFFSET]);
+  m_emit->and_(temp.cvt32(), PGXP::CPU_REG_VALID_MASK);
+  m_emit->imul(temp.cvt32(), temp.cvt32(), 0x00204081);
+  m_emit->shr(temp.cvt32(), 21);
+  m_emit->and_(temp.cvt32(), PGXP::MEM_FLAGS_BITS);
+  m_emit->mov(addr.cvt32(), m_emit->dword[regs + 8]);
+  m_emit->and_(addr.cvt32(), ~static_cast<u32>(PGXP::MEM_FLAGS_BITS));
+  m_emit->or_(addr.cvt32(), temp.cvt32());
+  m_emit->mov(m_emit->dword[entry + PGXP::MEM_Z_AND_FLAGS_OFFSET], addr.cvt32());
+  m_emit->mov(temp.cvt32(), m_emit->dword[regs + PGXP::CPU_REG_VALUE_OFFSET]);
+  m_emit->mov(m_emit->dword[entry + PGXP::MEM_VALUE_OFFSET], temp.cvt32());
+  m_emit->jmp(done, Xbyak::CodeGenerator::T_NEAR);
+
+  // invalid values don't need a page allocated
+  m_emit->L(unallocated);
+  m_emit->test(m_emit->dword[regs + PGXP::CPU_REG_FLAGS_OFFSET], PGXP::CPU_REG_VALID_MASK);
+  m_emit->jz(done, Xbyak::CodeGenerator::T_NEAR);
+
+  m_emit->L(slow);
+  EmitFunctionCall(nullptr, &PGXP::CPU_SW, Value::FromConstantU32(inst_bits), value, address);
+  m_emit->L(done);
+  return true;
+}
+
 void CodeGenerator::EmitBranch(const void* address, bool allow_scratch)
 {
   const s64 jump_distance =
@@ -3078,6 +3953,7 @@ CodeCache::DispatcherFunction CodeGenerator::CompileDispatcher()
   m_emit->mov(m_emit->rcx, m_emit->qword[m_emit->rbx + m_emit->rcx * 8]);
 
   // call(rcx[pc * 2]) (fast_map[pc >> 2])
+  m_register_cache.EmitLoadAllPinnedGuestRegisters();
   m_emit->call(m_emit->qword[m_emit->rcx + m_emit->rax * 2]);
 
   m_emit->jmp(main_loop);
@@ -3100,6 +3976,16 @@ CodeCache::DispatcherFunction CodeGenerator::CompileDispatcher()
   m_register_cache.PopCalleeSavedRegisters(true);
   m_emit->ret();
 
+  // blocks can't return directly when their branch is backpatched, because the pinned registers are still live
+  s_pinned_register_return = nullptr;
+  if (m_register_cache.HasPinnedGuestRegisters())
+  {
+    m_emit->align(16);
+    s_pinned_register_return = m_emit->getCurr();
+    m_register_cache.EmitStoreAllPinnedGuestRegisters();
+    m_emit->ret();
+  }
+
   CodeBlock::HostCodePointer ptr;
   u32 code_size;
   FinalizeBlock(&ptr, &code_size);
@@ -3114,6 +4000,7 @@ CodeCache::SingleBlockDispatcherFunction CodeGenerator::CompileSingleBlockDispat
 
   EmitLoadGlobalAddress(Xbyak::Operand::RBP, &g_state);
 
+  m_register_cache.EmitLoadAllPinnedGuestRegisters();
   m_emit->call(GetHostReg64(RARG1));
 
   RestoreStackAfterCall(stack_adjust);
@@ -102,6 +102,7 @@ void Value::Undiscard()
 RegisterCache::RegisterCache(CodeGenerator& code_generator) : m_code_generator(code_generator)
 {
   m_state.guest_reg_order.fill(Reg::count);
+  m_pinned_host_regs.fill(HostReg_Invalid);
 }
 
 RegisterCache::~RegisterCache()
@@ -464,6 +465,7 @@ void RegisterCache::PushState()
   save_state.callee_saved_order_count = m_state.callee_saved_order_count;
   save_state.guest_reg_order_count = m_state.guest_reg_order_count;
   save_state.allocator_inhibit_count = m_state.allocator_inhibit_count;
+  save_state.pinned_write_mask = m_state.pinned_write_mask;
   save_state.load_delay_register = m_state.load_delay_register;
   save_state.load_delay_value.regcache = m_state.load_delay_value.regcache;
   save_state.load_delay_value.host_reg = m_state.load_delay_value.host_reg;
@@ -507,6 +509,28 @@ Value RegisterCache::ReadGuestRegister(Reg guest_reg, bool cache /* = true */, b
   }
 
   Value& cache_value = m_state.guest_reg_state[static_cast<u8>(guest_reg)];
+  if (IsGuestRegisterPinned(guest_reg))
+  {
+    const HostReg pinned_host_reg = GetPinnedHostRegister(guest_reg);
+    if (!cache_value.IsValid())
+    {
+      m_code_generator.EmitLoadGuestRegister(pinned_host_reg, guest_reg);
+      cache_value.SetHostReg(this, pinned_host_reg, RegSize_32);
+      Log_DebugPrintf("Reloading pinned guest register %s to host register %s", GetRegName(guest_reg),
+                      m_code_generator.GetHostRegName(pinned_host_reg, RegSize_32));
+    }
+
+    // the pinned register can't move, so hand out a copy if the caller wants to own it
+    if ((forced_host_reg != HostReg_Invalid && forced_host_reg != pinned_host_reg) || !cache)
+    {
+      Value temp = AllocateScratch(RegSize_32, forced_host_reg);
+      m_code_generator.EmitCopyValue(temp.host_reg, cache_value);
+      return temp;
+    }
+
+    return cache_value;
+  }
+
   if (cache_value.IsValid())
   {
     if (cache_value.IsInHostRegister())
@@ -639,6 +663,21 @@ Value RegisterCache::WriteGuestRegister(Reg guest_reg, Value&& value)
   }
 
   Value& cache_value = m_state.guest_reg_state[static_cast<u8>(guest_reg)];
+  if (IsGuestRegisterPinned(guest_reg))
+  {
+    const HostReg pinned_host_reg = GetPinnedHostRegister(guest_reg);
+    if (!value.IsInHostRegister() || value.host_reg != pinned_host_reg)
+      m_code_generator.EmitCopyValue(pinned_host_reg, value);
+
+    Log_DebugPrintf("Updating pinned guest register %s (in host register %s)", GetRegName(guest_reg),
+                    m_code_generator.GetHostRegName(pinned_host_reg, RegSize_32));
+
+    cache_value.SetHostReg(this, pinned_host_reg, RegSize_32);
+    cache_value.SetDirty();
+    m_state.pinned_write_mask |= (UINT64_C(1) << static_cast<u8>(guest_reg));
+    return Value::FromHostReg(this, pinned_host_reg, RegSize_32);
+  }
+
   if (cache_value.IsInHostRegister() && value.IsInHostRegister() && cache_value.host_reg == value.host_reg)
   {
     // updating the register value.
@@ -814,7 +853,8 @@ void RegisterCache::InvalidateGuestRegister(Reg guest_reg)
   if (!cache_value.IsValid())
     return;
 
-  if (cache_value.IsInHostRegister())
+  // pinned registers keep their host register, and are reloaded on the next read
+  if (cache_value.IsInHostRegister() && !IsGuestRegisterPinned(guest_reg))
   {
     FreeHostReg(cache_value.host_reg);
     ClearRegisterFromOrder(guest_reg);
@@ -840,6 +880,15 @@ void RegisterCache::FlushAllGuestRegisters(bool invalidate, bool clear_dirty)
     FlushGuestRegister(static_cast<Reg>(reg), invalidate, clear_dirty);
 }
 
+void RegisterCache::FlushAllUnpinnedGuestRegisters(bool invalidate, bool clear_dirty)
+{
+  for (u8 reg = 0; reg < static_cast<u8>(Reg::count); reg++)
+  {
+    if (!IsGuestRegisterPinned(static_cast<Reg>(reg)))
+      FlushGuestRegister(static_cast<Reg>(reg), invalidate, clear_dirty);
+  }
+}
+
 void RegisterCache::FlushCallerSavedGuestRegisters(bool invalidate, bool clear_dirty)
 {
   for (u8 reg = 0; reg < static_cast<u8>(Reg::count); reg++)
@@ -855,6 +904,78 @@ void RegisterCache::FlushCallerSavedGuestRegisters(bool invalidate, bool clear_d
   }
 }
 
+void RegisterCache::PinGuestRegister(Reg guest_reg, HostReg host_reg)
+{
+  DebugAssert(guest_reg != Reg::zero && guest_reg < Reg::count && !IsGuestRegisterPinned(guest_reg));
+  DebugAssert(static_cast<u8>(guest_reg) < 64);
+  DebugAssert(host_reg != m_cpu_ptr_host_register && !IsHostRegInUse(host_reg));
+
+  m_pinned_host_regs[static_cast<u8>(guest_reg)] = host_reg;
+  m_pinned_guest_reg_count++;
+
+  // keep the allocator away from it, the callee-saved flag is left so the dispatcher preserves it
+  m_state.host_reg_state[host_reg] &= ~HostRegState::Usable;
+}
+
+void RegisterCache::AssumePinnedGuestRegistersAreLoaded()
+{
+  for (u8 reg = 0; reg < static_cast<u8>(Reg::count); reg++)
+  {
+    if (!IsGuestRegisterPinned(static_cast<Reg>(reg)))
+      continue;
+
+    // we don't know whether the last block wrote it back, so it has to be treated as dirty
+    Value& cache_value = m_state.guest_reg_state[reg];
+    cache_value.SetHostReg(this, m_pinned_host_regs[reg], RegSize_32);
+    cache_value.SetDirty();
+  }
+
+  m_state.pinned_write_mask = 0;
+}
+
+void RegisterCache::LoadPinnedGuestRegisters()
+{
+  for (u8 reg = 0; reg < static_cast<u8>(Reg::count); reg++)
+  {
+    if (!IsGuestRegisterPinned(static_cast<Reg>(reg)) || m_state.guest_reg_state[reg].IsValid())
+      continue;
+
+    Log_DebugPrintf("Reloading pinned guest register %s for block exit", GetRegName(static_cast<Reg>(reg)));
+    m_code_generator.EmitLoadGuestRegister(m_pinned_host_regs[reg], static_cast<Reg>(reg));
+    m_state.guest_reg_state[reg].SetHostReg(this, m_pinned_host_regs[reg], RegSize_32);
+  }
+}
+
+void RegisterCache::StorePinnedGuestRegisters()
+{
+  for (u8 reg = 0; reg < static_cast<u8>(Reg::count); reg++)
+  {
+    if (IsGuestRegisterPinned(static_cast<Reg>(reg)))
+      FlushGuestRegister(static_cast<Reg>(reg), false, false);
+  }
+}
+
+void RegisterCache::EmitLoadAllPinnedGuestRegisters()
+{
+  for (u8 reg = 0; reg < static_cast<u8>(Reg::count); reg++)
+  {
+    if (IsGuestRegisterPinned(static_cast<Reg>(reg)))
+      m_code_generator.EmitLoadGuestRegister(m_pinned_host_regs[reg], static_cast<Reg>(reg));
+  }
+}
+
+void RegisterCache::EmitStoreAllPinnedGuestRegisters()
+{
+  for (u8 reg = 0; reg < static_cast<u8>(Reg::count); reg++)
+  {
+    if (IsGuestRegisterPinned(static_cast<Reg>(reg)))
+    {
+      m_code_generator.EmitStoreGuestRegister(static_cast<Reg>(reg),
+                                              Value::FromHostReg(this, m_pinned_host_regs[reg], RegSize_32));
+    }
+  }
+}
+
 bool RegisterCache::EvictOneGuestRegister()
 {
   if (m_state.guest_reg_order_count == 0)
@@ -337,8 +337,44 @@ public:
   void FlushGuestRegister(Reg guest_reg, bool invalidate, bool clear_dirty);
   void InvalidateGuestRegister(Reg guest_reg);
 
+  //////////////////////////////////////////////////////////////////////////
+  // Pinned Guest Registers
+  //////////////////////////////////////////////////////////////////////////
+
+  /// Binds a guest register to a host register for all blocks, so it is carried across block links instead of being
+  /// written back. The host register is no longer available for allocation.
+  void PinGuestRegister(Reg guest_reg, HostReg host_reg);
+
+  bool HasPinnedGuestRegisters() const { return m_pinned_guest_reg_count > 0; }
+  bool IsGuestRegisterPinned(Reg guest_reg) const
+  {
+    return m_pinned_host_regs[static_cast<u8>(guest_reg)] != HostReg_Invalid;
+  }
+  HostReg GetPinnedHostRegister(Reg guest_reg) const { return m_pinned_host_regs[static_cast<u8>(guest_reg)]; }
+
+  /// Returns true if the pinned guest register still holds the value it had when the block was entered.
+  bool IsPinnedGuestRegisterUnmodified(Reg guest_reg) const
+  {
+    return IsGuestRegisterPinned(guest_reg) && m_state.guest_reg_state[static_cast<u8>(guest_reg)].IsValid() &&
+           (m_state.pinned_write_mask & (UINT64_C(1) << static_cast<u8>(guest_reg))) == 0;
+  }
+
+  /// Call at block entry. Pinned guest registers are live in their host registers, and CPU state may be stale.
+  void AssumePinnedGuestRegistersAreLoaded();
+
+  /// Reloads any pinned guest registers which were invalidated, e.g. by a fallback. Call before linking to a block.
+  void LoadPinnedGuestRegisters();
+
+  /// Writes pinned guest registers back to the CPU state. Call before returning to the dispatcher.
+  void StorePinnedGuestRegisters();
+
+  /// Emits loads or stores of all pinned registers, for use outside of blocks, i.e. in the dispatcher.
+  void EmitLoadAllPinnedGuestRegisters();
+  void EmitStoreAllPinnedGuestRegisters();
+
   void InvalidateAllNonDirtyGuestRegisters();
   void FlushAllGuestRegisters(bool invalidate, bool clear_dirty);
+  void FlushAllUnpinnedGuestRegisters(bool invalidate, bool clear_dirty);
   void FlushCallerSavedGuestRegisters(bool invalidate, bool clear_dirty);
   bool EvictOneGuestRegister();
 
@@ -357,6 +393,9 @@ private:
 
   HostReg m_cpu_ptr_host_register = {};
 
+  std::array<HostReg, static_cast<u8>(Reg::count)> m_pinned_host_regs;
+  u32 m_pinned_guest_reg_count = 0;
+
   struct RegAllocState
   {
     std::array<HostRegState, HostReg_Count> host_reg_state{};
@@ -369,6 +408,9 @@ private:
     u32 guest_reg_order_count = 0;
     u32 allocator_inhibit_count = 0;
 
+    // pinned guest registers written since the start of the block
+    u64 pinned_write_mask = 0;
+
     Reg load_delay_register = Reg::count;
     Value load_delay_value{};
 
@@ -77,6 +77,12 @@ constexpr RegSize HostPointerSize = RegSize_64;
 constexpr u32 MAX_NEAR_HOST_BYTES_PER_INSTRUCTION = 64;
 constexpr u32 MAX_FAR_HOST_BYTES_PER_INSTRUCTION = 128;
 
+// GTE commands emitted inline are much larger, RTPT is around 3.6KB.
+constexpr u32 MAX_NEAR_HOST_BYTES_PER_INLINE_GTE_INSTRUCTION = 4096;
+
+// With PGXP CPU mode, shadow register updates are emitted inline too, addiu being the largest.
+constexpr u32 MAX_NEAR_HOST_BYTES_PER_PGXP_INSTRUCTION = 384;
+
 // Alignment of code stoarge.
 constexpr u32 CODE_STORAGE_ALIGNMENT = 4096;
 
@@ -105,6 +111,12 @@ constexpr RegSize HostPointerSize = RegSize_32;
 constexpr u32 MAX_NEAR_HOST_BYTES_PER_INSTRUCTION = 64;
 constexpr u32 MAX_FAR_HOST_BYTES_PER_INSTRUCTION = 128;
 
+// GTE commands aren't emitted inline on this backend.
+constexpr u32 MAX_NEAR_HOST_BYTES_PER_INLINE_GTE_INSTRUCTION = MAX_NEAR_HOST_BYTES_PER_INSTRUCTION;
+
+// PGXP updates are calls on this backend.
+constexpr u32 MAX_NEAR_HOST_BYTES_PER_PGXP_INSTRUCTION = MAX_NEAR_HOST_BYTES_PER_INSTRUCTION;
+
 // Alignment of code stoarge.
 constexpr u32 CODE_STORAGE_ALIGNMENT = 4096;
 
@@ -124,6 +136,12 @@ constexpr RegSize HostPointerSize = RegSize_64;
 constexpr u32 MAX_NEAR_HOST_BYTES_PER_INSTRUCTION = 64;
 constexpr u32 MAX_FAR_HOST_BYTES_PER_INSTRUCTION = 128;
 
+// GTE commands aren't emitted inline on this backend.
+constexpr u32 MAX_NEAR_HOST_BYTES_PER_INLINE_GTE_INSTRUCTION = MAX_NEAR_HOST_BYTES_PER_INSTRUCTION;
+
+// PGXP updates are calls on this backend.
+constexpr u32 MAX_NEAR_HOST_BYTES_PER_PGXP_INSTRUCTION = MAX_NEAR_HOST_BYTES_PER_INSTRUCTION;
+
 // Alignment of code stoarge.
 constexpr u32 CODE_STORAGE_ALIGNMENT = 4096;
 
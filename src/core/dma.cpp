@@ -2,6 +2,7 @@
 #include "bus.h"
 #include "cdrom.h"
 #include "common/log.h"
+#include "common/scope_guard.h"
 #include "common/state_wrapper.h"
 #include "common/string_util.h"
 #include "cpu_code_cache.h"
@@ -250,7 +251,7 @@ bool DMA::CanTransferChannel(Channel channel, bool ignore_halt) const
     return false;
 
   const ChannelState& cs = m_state[static_cast<u32>(channel)];
-  if (!cs.channel_control.enable_busy)
+  if (!cs.channel_control.enable_busy || cs.transfer_in_progress)
     return false;
 
   if (cs.channel_control.sync_mode != SyncMode::Manual && (IsTransferHalted() && !ignore_halt))
@@ -307,6 +308,11 @@ bool DMA::TransferChannel(Channel channel)
   ChannelState& cs = m_state[static_cast<u32>(channel)];
   const u32 mask = GetAddressMask();
 
+  // base_address is only written back at the end, so a nested transfer would send the same words again
+  DebugAssert(!cs.transfer_in_progress);
+  cs.transfer_in_progress = true;
+  Common::ScopeGuard transfer_guard([&cs]() { cs.transfer_in_progress = false; });
+
   const bool copy_to_device = cs.channel_control.copy_to_device;
 
   // start/trigger bit is cleared on beginning of transfer
@@ -343,13 +349,18 @@ bool DMA::TransferChannel(Channel channel)
       Log_DebugPrintf("DMA%u: Copying linked list starting at 0x%08X to device", static_cast<u32>(channel),
                       current_address & mask);
 
+      // Most nodes in an ordering table are empty. Those don't touch the device, so their time is only added to the
+      // CPU before the next packet is sent, and the walk over them is just a chain of header reads.
+      // TODO: Execute packets straight from RAM when the GPU FIFO is empty and the GPU is idle, instead of copying
+      // every word into the FIFO first. The GP0 handlers and PGXP source addresses currently only read from the FIFO.
       u8* ram_pointer = Bus::g_ram;
       TickCount remaining_ticks = GetTransferSliceTicks();
+      TickCount walk_ticks = 0;
       while (cs.request && remaining_ticks > 0)
       {
         u32 header;
         std::memcpy(&header, &ram_pointer[current_address & mask], sizeof(header));
-        CPU::AddPendingTicks(10);
+        walk_ticks += 10;
         remaining_ticks -= 10;
 
         const u32 word_count = header >> 24;
@@ -358,7 +369,8 @@ bool DMA::TransferChannel(Channel channel)
                         word_count * UINT32_C(4), word_count, next_address);
         if (word_count > 0)
         {
-          CPU::AddPendingTicks(5);
+          CPU::AddPendingTicks(walk_ticks + 5);
+          walk_ticks = 0;
           remaining_ticks -= 5;
 
           const TickCount block_ticks =
@@ -372,6 +384,8 @@ bool DMA::TransferChannel(Channel channel)
           break;
       }
 
+      CPU::AddPendingTicks(walk_ticks);
+
       cs.base_address = current_address;
 
       if (current_address & UINT32_C(0x800000))
@@ -524,14 +538,7 @@ TickCount DMA::TransferMemoryToDevice(Channel channel, u32 address, u32 incremen
     {
       if (g_gpu->BeginDMAWrite())
       {
-        u8* ram_pointer = Bus::g_ram;
-        for (u32 i = 0; i < word_count; i++)
-        {
-          u32 value;
-          std::memcpy(&value, &ram_pointer[address], sizeof(u32));
-          g_gpu->DMAWrite(address, value);
-          address = (address + increment) & mask;
-        }
+        g_gpu->DMAWrite(Bus::g_ram, address, increment, mask, word_count);
         g_gpu->EndDMAWrite();
       }
     }
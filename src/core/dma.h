@@ -126,6 +126,10 @@ private:
     } channel_control = {};
 
     bool request = false;
+
+    // Set while TransferChannel() runs. Devices can change their request from inside the transfer, e.g. the GPU
+    // executing commands to drain its FIFO, and the running transfer picks that up instead of starting another.
+    bool transfer_in_progress = false;
   };
 
   std::array<ChannelState, NUM_CHANNELS> m_state;
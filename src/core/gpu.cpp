@@ -13,6 +13,7 @@
 #include "system.h"
 #include "timers.h"
 #include <cmath>
+#include <limits>
 #ifdef WITH_IMGUI
 #include "imgui.h"
 #endif
@@ -405,6 +406,48 @@ void GPU::DMARead(u32* words, u32 word_count)
     words[i] = ReadGPUREAD();
 }
 
+void GPU::DMAWrite(const u8* ram, u32 address, u32 increment, u32 address_mask, u32 word_count)
+{
+  // Words go straight into the FIFO storage, with the source address in the upper half for PGXP.
+  while (word_count > 0)
+  {
+    const u32 count = std::min(word_count, m_fifo.GetContiguousSpace());
+    if (count == 0)
+    {
+      // The storage only fills up when a single transfer is larger than it, e.g. a manual mode VRAM upload. The DMA
+      // can't be stalled partway through, so the GPU consumes what it can regardless of how far it has run ahead.
+      const u32 fifo_size = m_fifo.GetSize();
+      if (!m_syncing)
+      {
+        const TickCount max_run_ahead = m_max_run_ahead;
+        m_max_run_ahead = std::numeric_limits<TickCount>::max();
+        ExecuteCommands();
+        m_max_run_ahead = max_run_ahead;
+      }
+
+      if (m_fifo.GetSize() < fifo_size)
+        continue;
+
+      // Only possible while VRAM is being read back, or from within a command. Overwriting queued words would
+      // corrupt the command stream, so the rest of the transfer is discarded.
+      Log_ErrorPrintf("GPU FIFO is full and can't be drained, discarding %u DMA words", word_count);
+      break;
+    }
+
+    u64* dest = m_fifo.GetWritePointer();
+    for (u32 i = 0; i < count; i++)
+    {
+      u32 value;
+      std::memcpy(&value, &ram[address], sizeof(value));
+      dest[i] = (ZeroExtend64(address) << 32) | ZeroExtend64(value);
+      address = (address + increment) & address_mask;
+    }
+
+    m_fifo.AdvanceTail(count);
+    word_count -= count;
+  }
+}
+
 void GPU::EndDMAWrite()
 {
   m_fifo_pushed = true;
@@ -97,10 +97,7 @@ public:
   void DMARead(u32* words, u32 word_count);
 
   ALWAYS_INLINE bool BeginDMAWrite() const { return (m_GPUSTAT.dma_direction == DMADirection::CPUtoGP0); }
-  ALWAYS_INLINE void DMAWrite(u32 address, u32 value)
-  {
-    m_fifo.Push((ZeroExtend64(address) << 32) | ZeroExtend64(value));
-  }
+  void DMAWrite(const u8* ram, u32 address, u32 increment, u32 address_mask, u32 word_count);
   void EndDMAWrite();
 
   /// Returns true if no data is being sent from VRAM to the DAC or that no portion of VRAM would be visible on screen.
@@ -192,7 +192,11 @@ void GPUBackend::StopGPUThread()
 void GPUBackend::Sync(bool allow_sleep)
 {
   if (!m_use_gpu_thread)
+  {
+    // the backend may still be drawing on its own threads
+    FlushRender();
     return;
+  }
 
   GPUBackendSyncCommand* cmd =
     static_cast<GPUBackendSyncCommand*>(AllocateCommand(GPUBackendCommandType::Sync, sizeof(GPUBackendSyncCommand)));
@@ -252,6 +256,7 @@ void GPUBackend::RunGPULoop()
         case GPUBackendCommandType::Sync:
         {
           DebugAssert(read_ptr == write_ptr);
+          FlushRender();
           m_sync_event.Signal();
           allow_sleep = static_cast<const GPUBackendSyncCommand*>(cmd)->allow_sleep;
         }
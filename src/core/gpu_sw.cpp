@@ -4,6 +4,7 @@
 #include "common/log.h"
 #include "common/make_array.h"
 #include "common/platform.h"
+#include "common/state_wrapper.h"
 #include "host_display.h"
 #include "system.h"
 #include <algorithm>
@@ -77,6 +78,10 @@ bool GPU_SW::Initialize(HostDisplay* host_display)
 
 bool GPU_SW::DoState(StateWrapper& sw, HostDisplayTexture** host_texture, bool update_display)
 {
+  // VRAM is loaded directly, so the backend doesn't know it changed
+  if (sw.IsReading())
+    InvalidateDisplay();
+
   // ignore the host texture for software mode, since we want to save vram here
   return GPU::DoState(sw, nullptr, update_display);
 }
@@ -86,6 +91,7 @@ void GPU_SW::Reset(bool clear_vram)
   GPU::Reset(clear_vram);
 
   m_backend.Reset(clear_vram);
+  InvalidateDisplay();
 }
 
 void GPU_SW::UpdateSettings()
@@ -208,22 +214,246 @@ ALWAYS_INLINE void CopyOutRow16<HostDisplayPixelFormat::RGB565, u16>(const u16*
     *(dst_ptr++) = VRAM16ToOutput<HostDisplayPixelFormat::RGB565, u16>(*(src_ptr++));
 }
 
+#if defined(CPU_X64)
+ALWAYS_INLINE static __m128i VRAMConvert5To8x8(__m128i value)
+{
+  return _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(value, _mm_set1_epi16(527)), _mm_set1_epi16(23)), 6);
+}
+#elif defined(CPU_AARCH64)
+ALWAYS_INLINE static uint16x8_t VRAMConvert5To8x8(uint16x8_t value)
+{
+  return vshrq_n_u16(vmlaq_u16(vdupq_n_u16(23), value, vdupq_n_u16(527)), 6);
+}
+#endif
+
 template<>
 ALWAYS_INLINE void CopyOutRow16<HostDisplayPixelFormat::RGBA8, u32>(const u16* src_ptr, u32* dst_ptr, u32 width)
 {
-  for (u32 col = 0; col < width; col++)
+  u32 col = 0;
+
+#if defined(CPU_X64)
+  const u32 aligned_width = Common::AlignDownPow2(width, 8);
+  const __m128i single_mask = _mm_set1_epi16(0x1F);
+  for (; col < aligned_width; col += 8)
+  {
+    const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_ptr));
+    src_ptr += 8;
+    const __m128i r = VRAMConvert5To8x8(_mm_and_si128(value, single_mask));
+    const __m128i g = VRAMConvert5To8x8(_mm_and_si128(_mm_srli_epi16(value, 5), single_mask));
+    const __m128i b = VRAMConvert5To8x8(_mm_and_si128(_mm_srli_epi16(value, 10), single_mask));
+    const __m128i a =
+      _mm_and_si128(_mm_srai_epi16(value, 15), _mm_set1_epi16(static_cast<s16>(static_cast<u16>(0xFF00))));
+    const __m128i rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+    const __m128i ba = _mm_or_si128(b, a);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_ptr), _mm_unpacklo_epi16(rg, ba));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_ptr + 4), _mm_unpackhi_epi16(rg, ba));
+    dst_ptr += 8;
+  }
+#elif defined(CPU_AARCH64)
+  const u32 aligned_width = Common::AlignDownPow2(width, 8);
+  const uint16x8_t single_mask = vdupq_n_u16(0x1F);
+  for (; col < aligned_width; col += 8)
+  {
+    const uint16x8_t value = vld1q_u16(src_ptr);
+    src_ptr += 8;
+    uint8x8x4_t rgba;
+    rgba.val[0] = vmovn_u16(VRAMConvert5To8x8(vandq_u16(value, single_mask)));
+    rgba.val[1] = vmovn_u16(VRAMConvert5To8x8(vandq_u16(vshrq_n_u16(value, 5), single_mask)));
+    rgba.val[2] = vmovn_u16(VRAMConvert5To8x8(vandq_u16(vshrq_n_u16(value, 10), single_mask)));
+    rgba.val[3] = vmovn_u16(vreinterpretq_u16_s16(vshrq_n_s16(vreinterpretq_s16_u16(value), 15)));
+    vst4_u8(reinterpret_cast<u8*>(dst_ptr), rgba);
+    dst_ptr += 8;
+  }
+#endif
+
+  for (; col < width; col++)
     *(dst_ptr++) = VRAM16ToOutput<HostDisplayPixelFormat::RGBA8, u32>(*(src_ptr++));
 }
 
 template<>
 ALWAYS_INLINE void CopyOutRow16<HostDisplayPixelFormat::BGRA8, u32>(const u16* src_ptr, u32* dst_ptr, u32 width)
 {
-  for (u32 col = 0; col < width; col++)
+  u32 col = 0;
+
+#if defined(CPU_X64)
+  const u32 aligned_width = Common::AlignDownPow2(width, 8);
+  const __m128i single_mask = _mm_set1_epi16(0x1F);
+  for (; col < aligned_width; col += 8)
+  {
+    const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_ptr));
+    src_ptr += 8;
+    const __m128i r = VRAMConvert5To8x8(_mm_and_si128(value, single_mask));
+    const __m128i g = VRAMConvert5To8x8(_mm_and_si128(_mm_srli_epi16(value, 5), single_mask));
+    const __m128i b = VRAMConvert5To8x8(_mm_and_si128(_mm_srli_epi16(value, 10), single_mask));
+    const __m128i bg = _mm_or_si128(b, _mm_slli_epi16(g, 8));
+    const __m128i ra = _mm_or_si128(r, _mm_set1_epi16(static_cast<s16>(static_cast<u16>(0xFF00))));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_ptr), _mm_unpacklo_epi16(bg, ra));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_ptr + 4), _mm_unpackhi_epi16(bg, ra));
+    dst_ptr += 8;
+  }
+#elif defined(CPU_AARCH64)
+  const u32 aligned_width = Common::AlignDownPow2(width, 8);
+  const uint16x8_t single_mask = vdupq_n_u16(0x1F);
+  for (; col < aligned_width; col += 8)
+  {
+    const uint16x8_t value = vld1q_u16(src_ptr);
+    src_ptr += 8;
+    uint8x8x4_t bgra;
+    bgra.val[0] = vmovn_u16(VRAMConvert5To8x8(vandq_u16(vshrq_n_u16(value, 10), single_mask)));
+    bgra.val[1] = vmovn_u16(VRAMConvert5To8x8(vandq_u16(vshrq_n_u16(value, 5), single_mask)));
+    bgra.val[2] = vmovn_u16(VRAMConvert5To8x8(vandq_u16(value, single_mask)));
+    bgra.val[3] = vdup_n_u8(0xFF);
+    vst4_u8(reinterpret_cast<u8*>(dst_ptr), bgra);
+    dst_ptr += 8;
+  }
+#endif
+
+  for (; col < width; col++)
     *(dst_ptr++) = VRAM16ToOutput<HostDisplayPixelFormat::BGRA8, u32>(*(src_ptr++));
 }
 
+#if defined(CPU_X64)
+// Expands four packed 24-bit pixels to 32-bit lanes, the top byte of each lane is garbage. Reads 16 bytes.
+ALWAYS_INLINE static __m128i Load24BitPixelsx4(const u8* src_ptr)
+{
+  const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_ptr));
+  const __m128i p01 = _mm_unpacklo_epi32(value, _mm_srli_si128(value, 3));
+  const __m128i p23 = _mm_unpacklo_epi32(_mm_srli_si128(value, 6), _mm_srli_si128(value, 9));
+  return _mm_unpacklo_epi64(p01, p23);
+}
+
+// Packs the low 16 bits of each 32-bit lane.
+ALWAYS_INLINE static __m128i Pack32To16(__m128i low, __m128i high)
+{
+  return _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(low, 16), 16), _mm_srai_epi32(_mm_slli_epi32(high, 16), 16));
+}
+#endif
+
+template<HostDisplayPixelFormat out_format, typename out_type>
+static void CopyOutRow24(const u8* src_ptr, out_type* dst_ptr, u32 width)
+{
+  u32 col = 0;
+
+#if defined(CPU_X64)
+  // The second load in each group reads 4 bytes past the eighth pixel, so stop early enough to stay in the row.
+  const u32 aligned_width = (width >= 2) ? Common::AlignDownPow2(width - 2, 8) : 0;
+  for (; col < aligned_width; col += 8)
+  {
+    const __m128i low = Load24BitPixelsx4(src_ptr);
+    const __m128i high = Load24BitPixelsx4(src_ptr + 12);
+    src_ptr += 24;
+
+    if constexpr (out_format == HostDisplayPixelFormat::RGBA8)
+    {
+      const __m128i alpha = _mm_set1_epi32(static_cast<s32>(0xFF000000u));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_ptr), _mm_or_si128(low, alpha));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_ptr + 4), _mm_or_si128(high, alpha));
+    }
+    else if constexpr (out_format == HostDisplayPixelFormat::BGRA8)
+    {
+      const auto swizzle = [](__m128i value) {
+        const __m128i byte_mask = _mm_set1_epi32(0xFF);
+        const __m128i g = _mm_and_si128(value, _mm_set1_epi32(0xFF00));
+        const __m128i r = _mm_slli_epi32(_mm_and_si128(value, byte_mask), 16);
+        const __m128i b = _mm_and_si128(_mm_srli_epi32(value, 16), byte_mask);
+        return _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, _mm_set1_epi32(static_cast<s32>(0xFF000000u))));
+      };
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_ptr), swizzle(low));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_ptr + 4), swizzle(high));
+    }
+    else if constexpr (out_format == HostDisplayPixelFormat::RGB565)
+    {
+      const auto convert = [](__m128i value) {
+        return _mm_or_si128(_mm_or_si128(_mm_slli_epi32(_mm_and_si128(value, _mm_set1_epi32(0xF8)), 8),
+                                         _mm_and_si128(_mm_srli_epi32(value, 5), _mm_set1_epi32(0x7E0))),
+                            _mm_and_si128(_mm_srli_epi32(value, 19), _mm_set1_epi32(0x1F)));
+      };
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_ptr), Pack32To16(convert(low), convert(high)));
+    }
+    else if constexpr (out_format == HostDisplayPixelFormat::RGBA5551)
+    {
+      const auto convert = [](__m128i value) {
+        return _mm_or_si128(_mm_or_si128(_mm_slli_epi32(_mm_and_si128(value, _mm_set1_epi32(0xF8)), 7),
+                                         _mm_and_si128(_mm_srli_epi32(value, 6), _mm_set1_epi32(0x3E0))),
+                            _mm_and_si128(_mm_srli_epi32(value, 19), _mm_set1_epi32(0x1F)));
+      };
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst_ptr), Pack32To16(convert(low), convert(high)));
+    }
+
+    dst_ptr += 8;
+  }
+#elif defined(CPU_AARCH64)
+  const u32 aligned_width = Common::AlignDownPow2(width, 8);
+  for (; col < aligned_width; col += 8)
+  {
+    const uint8x8x3_t rgb = vld3_u8(src_ptr);
+    src_ptr += 24;
+
+    if constexpr (out_format == HostDisplayPixelFormat::RGBA8)
+    {
+      const uint8x8x4_t rgba = {{rgb.val[0], rgb.val[1], rgb.val[2], vdup_n_u8(0xFF)}};
+      vst4_u8(reinterpret_cast<u8*>(dst_ptr), rgba);
+    }
+    else if constexpr (out_format == HostDisplayPixelFormat::BGRA8)
+    {
+      const uint8x8x4_t bgra = {{rgb.val[2], rgb.val[1], rgb.val[0], vdup_n_u8(0xFF)}};
+      vst4_u8(reinterpret_cast<u8*>(dst_ptr), bgra);
+    }
+    else if constexpr (out_format == HostDisplayPixelFormat::RGB565)
+    {
+      const uint16x8_t r = vshlq_n_u16(vmovl_u8(vshr_n_u8(rgb.val[0], 3)), 11);
+      const uint16x8_t g = vshlq_n_u16(vmovl_u8(vshr_n_u8(rgb.val[1], 2)), 5);
+      const uint16x8_t b = vmovl_u8(vshr_n_u8(rgb.val[2], 3));
+      vst1q_u16(dst_ptr, vorrq_u16(vorrq_u16(r, g), b));
+    }
+    else if constexpr (out_format == HostDisplayPixelFormat::RGBA5551)
+    {
+      const uint16x8_t r = vshlq_n_u16(vmovl_u8(vshr_n_u8(rgb.val[0], 3)), 10);
+      const uint16x8_t g = vshlq_n_u16(vmovl_u8(vshr_n_u8(rgb.val[1], 3)), 5);
+      const uint16x8_t b = vmovl_u8(vshr_n_u8(rgb.val[2], 3));
+      vst1q_u16(dst_ptr, vorrq_u16(vorrq_u16(r, g), b));
+    }
+
+    dst_ptr += 8;
+  }
+#endif
+
+  for (; col < width; col++)
+  {
+    if constexpr (out_format == HostDisplayPixelFormat::RGBA8)
+    {
+      u8* dst_byte_ptr = reinterpret_cast<u8*>(dst_ptr++);
+      *(dst_byte_ptr++) = src_ptr[0];
+      *(dst_byte_ptr++) = src_ptr[1];
+      *(dst_byte_ptr++) = src_ptr[2];
+      *(dst_byte_ptr++) = 0xFF;
+    }
+    else if constexpr (out_format == HostDisplayPixelFormat::BGRA8)
+    {
+      u8* dst_byte_ptr = reinterpret_cast<u8*>(dst_ptr++);
+      *(dst_byte_ptr++) = src_ptr[2];
+      *(dst_byte_ptr++) = src_ptr[1];
+      *(dst_byte_ptr++) = src_ptr[0];
+      *(dst_byte_ptr++) = 0xFF;
+    }
+    else if constexpr (out_format == HostDisplayPixelFormat::RGB565)
+    {
+      *(dst_ptr++) = ((static_cast<u16>(src_ptr[0]) >> 3) << 11) | ((static_cast<u16>(src_ptr[1]) >> 2) << 5) |
+                     (static_cast<u16>(src_ptr[2]) >> 3);
+    }
+    else if constexpr (out_format == HostDisplayPixelFormat::RGBA5551)
+    {
+      *(dst_ptr++) = ((static_cast<u16>(src_ptr[0]) >> 3) << 10) | ((static_cast<u16>(src_ptr[1]) >> 3) << 5) |
+                     (static_cast<u16>(src_ptr[2]) >> 3);
+    }
+
+    src_ptr += 3;
+  }
+}
+
 template<HostDisplayPixelFormat display_format>
-void GPU_SW::CopyOut15Bit(u32 src_x, u32 src_y, u32 width, u32 height, u32 field, bool interlaced, bool interleaved)
+bool GPU_SW::CopyOut15Bit(u32 src_x, u32 src_y, u32 width, u32 height, u32 field, bool interlaced, bool interleaved,
+                          const VRAMRowMask* rows)
 {
   u8* dst_ptr;
   u32 dst_stride;
@@ -231,12 +461,13 @@ void GPU_SW::CopyOut15Bit(u32 src_x, u32 src_y, u32 width, u32 height, u32 field
   using OutputPixelType = std::conditional_t<
     display_format == HostDisplayPixelFormat::RGBA8 || display_format == HostDisplayPixelFormat::BGRA8, u32, u16>;
 
-  if (!interlaced)
+  const bool use_staging_buffer = interlaced || rows;
+  if (!use_staging_buffer)
   {
     if (!m_host_display->BeginSetDisplayPixels(display_format, width, height, reinterpret_cast<void**>(&dst_ptr),
                                                &dst_stride))
     {
-      return;
+      return false;
     }
   }
   else
@@ -252,72 +483,79 @@ void GPU_SW::CopyOut15Bit(u32 src_x, u32 src_y, u32 width, u32 height, u32 field
   // Fast path when not wrapping around.
   if ((src_x + width) <= VRAM_WIDTH && (src_y + height) <= VRAM_HEIGHT)
   {
-    const u32 rows = height >> interlaced_shift;
+    const u32 num_rows = height >> interlaced_shift;
     dst_stride <<= interlaced_shift;
 
     const u16* src_ptr = &m_vram_ptr[src_y * VRAM_WIDTH + src_x];
     const u32 src_step = VRAM_WIDTH << interleaved_shift;
-    for (u32 row = 0; row < rows; row++)
+    for (u32 row = 0; row < num_rows; row++)
     {
-      CopyOutRow16<display_format>(src_ptr, reinterpret_cast<OutputPixelType*>(dst_ptr), width);
+      if (!rows || rows->test(src_y + (row << interleaved_shift)))
+        CopyOutRow16<display_format>(src_ptr, reinterpret_cast<OutputPixelType*>(dst_ptr), width);
+
       src_ptr += src_step;
       dst_ptr += dst_stride;
     }
   }
   else
   {
-    const u32 rows = height >> interlaced_shift;
+    const u32 num_rows = height >> interlaced_shift;
     dst_stride <<= interlaced_shift;
 
     const u32 end_x = src_x + width;
-    for (u32 row = 0; row < rows; row++)
+    for (u32 row = 0; row < num_rows; row++)
     {
-      const u16* src_row_ptr = &m_vram_ptr[(src_y % VRAM_HEIGHT) * VRAM_WIDTH];
-      OutputPixelType* dst_row_ptr = reinterpret_cast<OutputPixelType*>(dst_ptr);
+      if (!rows || rows->test(src_y % VRAM_HEIGHT))
+      {
+        const u16* src_row_ptr = &m_vram_ptr[(src_y % VRAM_HEIGHT) * VRAM_WIDTH];
+        OutputPixelType* dst_row_ptr = reinterpret_cast<OutputPixelType*>(dst_ptr);
 
-      for (u32 col = src_x; col < end_x; col++)
-        *(dst_row_ptr++) = VRAM16ToOutput<display_format, OutputPixelType>(src_row_ptr[col % VRAM_WIDTH]);
+        for (u32 col = src_x; col < end_x; col++)
+          *(dst_row_ptr++) = VRAM16ToOutput<display_format, OutputPixelType>(src_row_ptr[col % VRAM_WIDTH]);
+      }
 
       src_y += (1 << interleaved_shift);
       dst_ptr += dst_stride;
     }
   }
 
-  if (!interlaced)
+  if (!use_staging_buffer)
   {
     m_host_display->EndSetDisplayPixels();
+    return true;
   }
   else
   {
-    m_host_display->SetDisplayPixels(display_format, width, height, m_display_texture_buffer.data(), output_stride);
+    return m_host_display->SetDisplayPixels(display_format, width, height, m_display_texture_buffer.data(),
+                                            output_stride);
   }
 }
 
-void GPU_SW::CopyOut15Bit(HostDisplayPixelFormat display_format, u32 src_x, u32 src_y, u32 width, u32 height, u32 field,
-                          bool interlaced, bool interleaved)
+bool GPU_SW::CopyOut15Bit(HostDisplayPixelFormat display_format, u32 src_x, u32 src_y, u32 width, u32 height, u32 field,
+                          bool interlaced, bool interleaved, const VRAMRowMask* rows)
 {
   switch (display_format)
   {
     case HostDisplayPixelFormat::RGBA5551:
-      CopyOut15Bit<HostDisplayPixelFormat::RGBA5551>(src_x, src_y, width, height, field, interlaced, interleaved);
-      break;
+      return CopyOut15Bit<HostDisplayPixelFormat::RGBA5551>(src_x, src_y, width, height, field, interlaced,
+                                                            interleaved, rows);
     case HostDisplayPixelFormat::RGB565:
-      CopyOut15Bit<HostDisplayPixelFormat::RGB565>(src_x, src_y, width, height, field, interlaced, interleaved);
-      break;
+      return CopyOut15Bit<HostDisplayPixelFormat::RGB565>(src_x, src_y, width, height, field, interlaced, interleaved,
+                                                          rows);
     case HostDisplayPixelFormat::RGBA8:
-      CopyOut15Bit<HostDisplayPixelFormat::RGBA8>(src_x, src_y, width, height, field, interlaced, interleaved);
-      break;
+      return CopyOut15Bit<HostDisplayPixelFormat::RGBA8>(src_x, src_y, width, height, field, interlaced, interleaved,
+                                                         rows);
     case HostDisplayPixelFormat::BGRA8:
-      CopyOut15Bit<HostDisplayPixelFormat::BGRA8>(src_x, src_y, width, height, field, interlaced, interleaved);
-      break;
+      return CopyOut15Bit<HostDisplayPixelFormat::BGRA8>(src_x, src_y, width, height, field, interlaced, interleaved,
+                                                         rows);
     default:
-      break;
+      return false;
   }
 }
 
 template<HostDisplayPixelFormat display_format>
-void GPU_SW::CopyOut24Bit(u32 src_x, u32 src_y, u32 skip_x, u32 width, u32 height, u32 field, bool interlaced,
-                          bool interleaved)
+bool GPU_SW::CopyOut24Bit(u32 src_x, u32 src_y, u32 skip_x, u32 width, u32 height, u32 field, bool interlaced,
+                          bool interleaved, const VRAMRowMask* rows)
 {
   u8* dst_ptr;
   u32 dst_stride;
@@ -325,12 +563,13 @@ void GPU_SW::CopyOut24Bit(u32 src_x, u32 src_y, u32 skip_x, u32 width, u32 heigh
   using OutputPixelType = std::conditional_t<
     display_format == HostDisplayPixelFormat::RGBA8 || display_format == HostDisplayPixelFormat::BGRA8, u32, u16>;
 
-  if (!interlaced)
+  const bool use_staging_buffer = interlaced || rows;
+  if (!use_staging_buffer)
   {
     if (!m_host_display->BeginSetDisplayPixels(display_format, width, height, reinterpret_cast<void**>(&dst_ptr),
                                                &dst_stride))
     {
-      return;
+      return false;
     }
   }
   else
@@ -342,62 +581,17 @@ void GPU_SW::CopyOut24Bit(u32 src_x, u32 src_y, u32 skip_x, u32 width, u32 heigh
   const u32 output_stride = dst_stride;
   const u8 interlaced_shift = BoolToUInt8(interlaced);
   const u8 interleaved_shift = BoolToUInt8(interleaved);
-  const u32 rows = height >> interlaced_shift;
+  const u32 num_rows = height >> interlaced_shift;
   dst_stride <<= interlaced_shift;
 
-  if ((src_x + width) <= VRAM_WIDTH && (src_y + (rows << interleaved_shift)) <= VRAM_HEIGHT)
+  if ((src_x + width) <= VRAM_WIDTH && (src_y + (num_rows << interleaved_shift)) <= VRAM_HEIGHT)
   {
     const u8* src_ptr = reinterpret_cast<const u8*>(&m_vram_ptr[src_y * VRAM_WIDTH + src_x]) + (skip_x * 3);
     const u32 src_stride = (VRAM_WIDTH << interleaved_shift) * sizeof(u16);
-    for (u32 row = 0; row < rows; row++)
+    for (u32 row = 0; row < num_rows; row++)
     {
-      if constexpr (display_format == HostDisplayPixelFormat::RGBA8)
-      {
-        const u8* src_row_ptr = src_ptr;
-        u8* dst_row_ptr = reinterpret_cast<u8*>(dst_ptr);
-        for (u32 col = 0; col < width; col++)
-        {
-          *(dst_row_ptr++) = *(src_row_ptr++);
-          *(dst_row_ptr++) = *(src_row_ptr++);
-          *(dst_row_ptr++) = *(src_row_ptr++);
-          *(dst_row_ptr++) = 0xFF;
-        }
-      }
-      else if constexpr (display_format == HostDisplayPixelFormat::BGRA8)
-      {
-        const u8* src_row_ptr = src_ptr;
-        u8* dst_row_ptr = reinterpret_cast<u8*>(dst_ptr);
-        for (u32 col = 0; col < width; col++)
-        {
-          *(dst_row_ptr++) = src_row_ptr[2];
-          *(dst_row_ptr++) = src_row_ptr[1];
-          *(dst_row_ptr++) = src_row_ptr[0];
-          *(dst_row_ptr++) = 0xFF;
-          src_row_ptr += 3;
-        }
-      }
-      else if constexpr (display_format == HostDisplayPixelFormat::RGB565)
-      {
-        const u8* src_row_ptr = src_ptr;
-        u16* dst_row_ptr = reinterpret_cast<u16*>(dst_ptr);
-        for (u32 col = 0; col < width; col++)
-        {
-          *(dst_row_ptr++) = ((static_cast<u16>(src_row_ptr[0]) >> 3) << 11) |
-                             ((static_cast<u16>(src_row_ptr[1]) >> 2) << 5) | (static_cast<u16>(src_row_ptr[2]) >> 3);
-          src_row_ptr += 3;
-        }
-      }
-      else if constexpr (display_format == HostDisplayPixelFormat::RGBA5551)
-      {
-        const u8* src_row_ptr = src_ptr;
-        u16* dst_row_ptr = reinterpret_cast<u16*>(dst_ptr);
-        for (u32 col = 0; col < width; col++)
-        {
-          *(dst_row_ptr++) = ((static_cast<u16>(src_row_ptr[0]) >> 3) << 10) |
-                             ((static_cast<u16>(src_row_ptr[1]) >> 3) << 5) | (static_cast<u16>(src_row_ptr[2]) >> 3);
-          src_row_ptr += 3;
-        }
-      }
+      if (!rows || rows->test(src_y + (row << interleaved_shift)))
+        CopyOutRow24<display_format>(src_ptr, reinterpret_cast<OutputPixelType*>(dst_ptr), width);
 
       src_ptr += src_stride;
       dst_ptr += dst_stride;
@@ -405,8 +599,15 @@ void GPU_SW::CopyOut24Bit(u32 src_x, u32 src_y, u32 skip_x, u32 width, u32 heigh
   }
   else
   {
-    for (u32 row = 0; row < rows; row++)
+    for (u32 row = 0; row < num_rows; row++)
     {
+      if (rows && !rows->test(src_y % VRAM_HEIGHT))
+      {
+        src_y += (1 << interleaved_shift);
+        dst_ptr += dst_stride;
+        continue;
+      }
+
       const u16* src_row_ptr = &m_vram_ptr[(src_y % VRAM_HEIGHT) * VRAM_WIDTH];
       OutputPixelType* dst_row_ptr = reinterpret_cast<OutputPixelType*>(dst_ptr);
 
@@ -441,42 +642,123 @@ void GPU_SW::CopyOut24Bit(u32 src_x, u32 src_y, u32 skip_x, u32 width, u32 heigh
     }
   }
 
-  if (!interlaced)
+  if (!use_staging_buffer)
   {
     m_host_display->EndSetDisplayPixels();
+    return true;
   }
   else
   {
-    m_host_display->SetDisplayPixels(display_format, width, height, m_display_texture_buffer.data(), output_stride);
+    return m_host_display->SetDisplayPixels(display_format, width, height, m_display_texture_buffer.data(),
+                                            output_stride);
   }
 }
 
-void GPU_SW::CopyOut24Bit(HostDisplayPixelFormat display_format, u32 src_x, u32 src_y, u32 skip_x, u32 width,
-                          u32 height, u32 field, bool interlaced, bool interleaved)
+bool GPU_SW::CopyOut24Bit(HostDisplayPixelFormat display_format, u32 src_x, u32 src_y, u32 skip_x, u32 width,
+                          u32 height, u32 field, bool interlaced, bool interleaved, const VRAMRowMask* rows)
 {
   switch (display_format)
   {
     case HostDisplayPixelFormat::RGBA5551:
-      CopyOut24Bit<HostDisplayPixelFormat::RGBA5551>(src_x, src_y, skip_x, width, height, field, interlaced,
-                                                     interleaved);
-      break;
+      return CopyOut24Bit<HostDisplayPixelFormat::RGBA5551>(src_x, src_y, skip_x, width, height, field, interlaced,
+                                                            interleaved, rows);
     case HostDisplayPixelFormat::RGB565:
-      CopyOut24Bit<HostDisplayPixelFormat::RGB565>(src_x, src_y, skip_x, width, height, field, interlaced, interleaved);
-      break;
+      return CopyOut24Bit<HostDisplayPixelFormat::RGB565>(src_x, src_y, skip_x, width, height, field, interlaced,
+                                                          interleaved, rows);
     case HostDisplayPixelFormat::RGBA8:
-      CopyOut24Bit<HostDisplayPixelFormat::RGBA8>(src_x, src_y, skip_x, width, height, field, interlaced, interleaved);
-      break;
+      return CopyOut24Bit<HostDisplayPixelFormat::RGBA8>(src_x, src_y, skip_x, width, height, field, interlaced,
+                                                         interleaved, rows);
     case HostDisplayPixelFormat::BGRA8:
-      CopyOut24Bit<HostDisplayPixelFormat::BGRA8>(src_x, src_y, skip_x, width, height, field, interlaced, interleaved);
-      break;
+      return CopyOut24Bit<HostDisplayPixelFormat::BGRA8>(src_x, src_y, skip_x, width, height, field, interlaced,
+                                                         interleaved, rows);
     default:
-      break;
+      return false;
+  }
+}
+
+bool GPU_SW::DisplayCopyOut::operator==(const DisplayCopyOut& rhs) const
+{
+  return (format == rhs.format && src_x == rhs.src_x && src_y == rhs.src_y && skip_x == rhs.skip_x &&
+          width == rhs.width && height == rhs.height && color_depth_24 == rhs.color_depth_24 &&
+          interlaced == rhs.interlaced && interleaved == rhs.interleaved);
+}
+
+bool GPU_SW::DisplayCopyOut::operator!=(const DisplayCopyOut& rhs) const
+{
+  return !operator==(rhs);
+}
+
+void GPU_SW::CopyOutDisplay(const DisplayCopyOut& copy_out, u32 field)
+{
+  // The fields share the staging buffer, so converting one with a different layout can overwrite the lines of the
+  // other. Progressive output uses the whole buffer, so the second field has to be converted again afterwards.
+  DisplayField& df = m_display_fields[copy_out.interlaced ? field : 0];
+  const bool same_copy_out = (df.copy_out == copy_out);
+  if (!copy_out.interlaced || !same_copy_out)
+    m_display_fields[copy_out.interlaced ? (field ^ 1) : 1].staging_valid = false;
+
+  // 24-bit pixels are read in pairs of halfwords, starting from the beginning of the line.
+  const u32 vram_width =
+    copy_out.color_depth_24 ? ((((copy_out.skip_x + copy_out.width - 1) * 3) / 2) + 2) : copy_out.width;
+  const u16 columns = GPU_SW_Backend::GetDirtyVRAMColumnMask(copy_out.src_x, vram_width);
+  const u32 num_rows = copy_out.interlaced ? (copy_out.height >> 1) : copy_out.height;
+  const u32 row_step = copy_out.interleaved ? 2 : 1;
+
+  // The non-wrapping 24-bit path runs off the end of the line into the next one, instead of wrapping around.
+  const bool spills_to_next_row = copy_out.color_depth_24 && (copy_out.src_x + vram_width) > VRAM_WIDTH;
+
+  VRAMRowMask rows;
+  u32 num_dirty_rows = 0;
+  for (u32 row = 0; row < num_rows; row++)
+  {
+    const u32 vram_row = (copy_out.src_y + row * row_step) % VRAM_HEIGHT;
+    const u16 dirty_columns =
+      df.dirty_rows[vram_row] | (spills_to_next_row ? df.dirty_rows[(vram_row + 1) % VRAM_HEIGHT] : 0);
+    if (dirty_columns & columns)
+    {
+      rows.set(vram_row);
+      num_dirty_rows++;
+    }
   }
+  df.dirty_rows.fill(0);
+
+  // Interlaced output is always uploaded from the staging buffer, so it needs this field to be in there as well.
+  if (same_copy_out && num_dirty_rows == 0 && m_display_texture_valid && (!copy_out.interlaced || df.staging_valid) &&
+      m_host_display->GetDisplayTextureHandle())
+  {
+    return;
+  }
+
+  // Partial updates go through the staging buffer, since the display texture is discarded when it's written to.
+  // Frames where every row changed are written straight to the texture instead, to avoid the extra copy.
+  const bool use_staging_buffer =
+    copy_out.interlaced ||
+    (same_copy_out && num_dirty_rows < num_rows && copy_out.width <= GPU_MAX_DISPLAY_WIDTH);
+  if (use_staging_buffer && (!same_copy_out || !df.staging_valid))
+    rows.set();
+
+  const VRAMRowMask* const rows_ptr = use_staging_buffer ? &rows : nullptr;
+  m_display_texture_valid =
+    copy_out.color_depth_24 ?
+      CopyOut24Bit(copy_out.format, copy_out.src_x, copy_out.src_y, copy_out.skip_x, copy_out.width, copy_out.height,
+                   field, copy_out.interlaced, copy_out.interleaved, rows_ptr) :
+      CopyOut15Bit(copy_out.format, copy_out.src_x, copy_out.src_y, copy_out.width, copy_out.height, field,
+                   copy_out.interlaced, copy_out.interleaved, rows_ptr);
+  df.copy_out = copy_out;
+  df.staging_valid = use_staging_buffer;
+}
+
+void GPU_SW::InvalidateDisplay()
+{
+  for (DisplayField& df : m_display_fields)
+    df.staging_valid = false;
+  m_display_texture_valid = false;
 }
 
 void GPU_SW::ClearDisplay()
 {
   std::memset(m_display_texture_buffer.data(), 0, m_display_texture_buffer.size());
+  InvalidateDisplay();
 }
 
 void GPU_SW::UpdateDisplay()
@@ -484,6 +766,15 @@ void GPU_SW::UpdateDisplay()
   // fill display texture
   m_backend.Sync(true);
 
+  // Collect VRAM writes since the last update, so rows which haven't changed don't have to be converted again.
+  const GPU_SW_Backend::DirtyVRAMRows& dirty_rows = m_backend.GetDirtyVRAMRows();
+  for (DisplayField& df : m_display_fields)
+  {
+    for (u32 row = 0; row < VRAM_HEIGHT; row++)
+      df.dirty_rows[row] |= dirty_rows[row];
+  }
+  m_backend.ClearDirtyVRAMRows();
+
   if (!g_settings.debugging.show_vram)
   {
     m_host_display->SetDisplayParameters(m_crtc_state.display_width, m_crtc_state.display_height,
@@ -494,46 +785,40 @@ void GPU_SW::UpdateDisplay()
     if (IsDisplayDisabled())
     {
       m_host_display->ClearDisplayTexture();
+      m_display_texture_valid = false;
       return;
     }
 
     const u32 vram_offset_y = m_crtc_state.display_vram_top;
-    const u32 display_width = m_crtc_state.display_vram_width;
-    const u32 display_height = m_crtc_state.display_vram_height;
-
-    if (IsInterlacedDisplayEnabled())
+    const bool interlaced = IsInterlacedDisplayEnabled();
+    const u32 field = interlaced ? GetInterlacedDisplayField() : 0;
+
+    DisplayCopyOut copy_out;
+    copy_out.src_y = vram_offset_y + field;
+    copy_out.width = m_crtc_state.display_vram_width;
+    copy_out.height = m_crtc_state.display_vram_height;
+    copy_out.color_depth_24 = m_GPUSTAT.display_area_color_depth_24;
+    copy_out.interlaced = interlaced;
+    copy_out.interleaved = interlaced && m_GPUSTAT.vertical_resolution;
+    if (copy_out.color_depth_24)
     {
-      const u32 field = GetInterlacedDisplayField();
-      if (m_GPUSTAT.display_area_color_depth_24)
-      {
-        CopyOut24Bit(m_24bit_display_format, m_crtc_state.regs.X, vram_offset_y + field,
-                     m_crtc_state.display_vram_left - m_crtc_state.regs.X, display_width, display_height, field, true,
-                     m_GPUSTAT.vertical_resolution);
-      }
-      else
-      {
-        CopyOut15Bit(m_16bit_display_format, m_crtc_state.display_vram_left, vram_offset_y + field, display_width,
-                     display_height, field, true, m_GPUSTAT.vertical_resolution);
-      }
+      copy_out.format = m_24bit_display_format;
+      copy_out.src_x = m_crtc_state.regs.X;
+      copy_out.skip_x = m_crtc_state.display_vram_left - m_crtc_state.regs.X;
     }
     else
     {
-      if (m_GPUSTAT.display_area_color_depth_24)
-      {
-        CopyOut24Bit(m_24bit_display_format, m_crtc_state.regs.X, vram_offset_y,
-                     m_crtc_state.display_vram_left - m_crtc_state.regs.X, display_width, display_height, 0, false,
-                     false);
-      }
-      else
-      {
-        CopyOut15Bit(m_16bit_display_format, m_crtc_state.display_vram_left, vram_offset_y, display_width,
-                     display_height, 0, false, false);
-      }
+      copy_out.format = m_16bit_display_format;
+      copy_out.src_x = m_crtc_state.display_vram_left;
+      copy_out.skip_x = 0;
     }
+
+    CopyOutDisplay(copy_out, field);
   }
   else
   {
-    CopyOut15Bit(m_16bit_display_format, 0, 0, VRAM_WIDTH, VRAM_HEIGHT, 0, false, false);
+    const DisplayCopyOut copy_out = {m_16bit_display_format, 0, 0, 0, VRAM_WIDTH, VRAM_HEIGHT, false, false, false};
+    CopyOutDisplay(copy_out, 0);
     m_host_display->SetDisplayParameters(VRAM_WIDTH, VRAM_HEIGHT, 0, 0, VRAM_WIDTH, VRAM_HEIGHT,
                                          static_cast<float>(VRAM_WIDTH) / static_cast<float>(VRAM_HEIGHT));
   }
@@ -4,6 +4,7 @@
 #include "gpu_sw_backend.h"
 #include "host_display.h"
 #include <array>
+#include <bitset>
 #include <memory>
 #include <vector>
 
@@ -23,21 +24,58 @@ public:
   void UpdateSettings() override;
 
 protected:
+  /// Source of the display image in VRAM, and how it's converted.
+  struct DisplayCopyOut
+  {
+    HostDisplayPixelFormat format;
+    u32 src_x;
+    u32 src_y;
+    u32 skip_x;
+    u32 width;
+    u32 height;
+    bool color_depth_24;
+    bool interlaced;
+    bool interleaved;
+
+    bool operator==(const DisplayCopyOut& rhs) const;
+    bool operator!=(const DisplayCopyOut& rhs) const;
+  };
+
+  /// Each interlaced field is converted into the staging buffer separately, progressive scan only uses the first.
+  struct DisplayField
+  {
+    DisplayCopyOut copy_out;
+    GPU_SW_Backend::DirtyVRAMRows dirty_rows; // VRAM written since the field was last converted
+    bool staging_valid;                       // staging buffer has the field converted with copy_out
+  };
+
+  using VRAMRowMask = std::bitset<VRAM_HEIGHT>;
+
   void ReadVRAM(u32 x, u32 y, u32 width, u32 height) override;
   void FillVRAM(u32 x, u32 y, u32 width, u32 height, u32 color) override;
   void UpdateVRAM(u32 x, u32 y, u32 width, u32 height, const void* data, bool set_mask, bool check_mask) override;
   void CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 width, u32 height) override;
 
+  // When rows is set, only those VRAM rows are converted, into the staging buffer. Interlaced output always goes
+  // through the staging buffer, otherwise the pixels are written directly to the display texture when rows is null.
   template<HostDisplayPixelFormat display_format>
-  void CopyOut15Bit(u32 src_x, u32 src_y, u32 width, u32 height, u32 field, bool interlaced, bool interleaved);
-  void CopyOut15Bit(HostDisplayPixelFormat display_format, u32 src_x, u32 src_y, u32 width, u32 height, u32 field,
-                    bool interlaced, bool interleaved);
+  bool CopyOut15Bit(u32 src_x, u32 src_y, u32 width, u32 height, u32 field, bool interlaced, bool interleaved,
+                    const VRAMRowMask* rows);
+  bool CopyOut15Bit(HostDisplayPixelFormat display_format, u32 src_x, u32 src_y, u32 width, u32 height, u32 field,
+                    bool interlaced, bool interleaved, const VRAMRowMask* rows);
 
   template<HostDisplayPixelFormat display_format>
-  void CopyOut24Bit(u32 src_x, u32 src_y, u32 skip_x, u32 width, u32 height, u32 field, bool interlaced,
-                    bool interleaved);
-  void CopyOut24Bit(HostDisplayPixelFormat display_format, u32 src_x, u32 src_y, u32 skip_x, u32 width, u32 height,
-                    u32 field, bool interlaced, bool interleaved);
+  bool CopyOut24Bit(u32 src_x, u32 src_y, u32 skip_x, u32 width, u32 height, u32 field, bool interlaced,
+                    bool interleaved, const VRAMRowMask* rows);
+  bool CopyOut24Bit(HostDisplayPixelFormat display_format, u32 src_x, u32 src_y, u32 skip_x, u32 width, u32 height,
+                    u32 field, bool interlaced, bool interleaved, const VRAMRowMask* rows);
+
+  /// Converts the rows of the display which have changed since the field was last converted, and uploads the result.
+  /// Nothing is uploaded if the display texture is already up to date.
+  void CopyOutDisplay(const DisplayCopyOut& copy_out, u32 field);
+
+  /// Forces the next display update to convert everything.
+  void InvalidateDisplay();
 
   void ClearDisplay() override;
   void UpdateDisplay() override;
@@ -51,5 +89,8 @@ protected:
   HostDisplayPixelFormat m_16bit_display_format = HostDisplayPixelFormat::RGB565;
   HostDisplayPixelFormat m_24bit_display_format = HostDisplayPixelFormat::RGBA8;
 
+  std::array<DisplayField, 2> m_display_fields = {};
+  bool m_display_texture_valid = false; // display texture has the last converted image
+
   GPU_SW_Backend m_backend;
 };
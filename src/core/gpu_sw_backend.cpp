@@ -1,10 +1,26 @@
 #include "gpu_sw_backend.h"
+#include "common/align.h"
 #include "common/assert.h"
 #include "common/log.h"
+#include "common/platform.h"
+#include "common/timer.h"
 #include "gpu_sw_backend.h"
 #include "host_display.h"
+#include "settings.h"
 #include "system.h"
 #include <algorithm>
+#include <cstring>
+
+#if defined(CPU_X64)
+#include <emmintrin.h>
+#elif defined(CPU_AARCH64)
+#ifdef _MSC_VER
+#include <arm64_neon.h>
+#else
+#include <arm_neon.h>
+#endif
+#endif
+
 Log_SetChannel(GPU_SW_Backend);
 
 GPU_SW_Backend::GPU_SW_Backend() : GPUBackend()
@@ -13,11 +29,34 @@ GPU_SW_Backend::GPU_SW_Backend() : GPUBackend()
   m_vram_ptr = m_vram.data();
 }
 
-GPU_SW_Backend::~GPU_SW_Backend() = default;
+GPU_SW_Backend::~GPU_SW_Backend()
+{
+  StopBandThreads();
+}
 
 bool GPU_SW_Backend::Initialize(bool force_thread)
 {
-  return GPUBackend::Initialize(force_thread);
+  if (!GPUBackend::Initialize(force_thread))
+    return false;
+
+  m_texture_cache = std::make_unique<TextureCacheEntry[]>(TEXTURE_CACHE_SIZE);
+  InvalidateTextureCache();
+  m_dirty_vram_rows.fill(0xFFFF);
+
+  StartBandThreads(g_settings.gpu_sw_render_threads);
+  return true;
+}
+
+void GPU_SW_Backend::UpdateSettings()
+{
+  GPUBackend::UpdateSettings();
+
+  const u32 new_num_band_threads = std::min<u32>(g_settings.gpu_sw_render_threads, MAX_BAND_THREADS);
+  if (m_num_band_threads != ((new_num_band_threads > 1) ? new_num_band_threads : 0))
+  {
+    StopBandThreads();
+    StartBandThreads(new_num_band_threads);
+  }
 }
 
 void GPU_SW_Backend::Reset(bool clear_vram)
@@ -26,9 +65,132 @@ void GPU_SW_Backend::Reset(bool clear_vram)
 
   if (clear_vram)
     m_vram.fill(0);
+
+  InvalidateTextureCache();
+  m_dirty_vram_rows.fill(0xFFFF);
+}
+
+void GPU_SW_Backend::Shutdown()
+{
+  // the GPU thread has to be stopped first, it's the one queueing to the bands
+  GPUBackend::Shutdown();
+  StopBandThreads();
 }
 
 void GPU_SW_Backend::DrawPolygon(const GPUBackendDrawPolygonCommand* cmd)
+{
+  s32 min_x = cmd->vertices[0].x, max_x = cmd->vertices[0].x;
+  s32 min_y = cmd->vertices[0].y, max_y = cmd->vertices[0].y;
+  for (u32 i = 1; i < cmd->num_vertices; i++)
+  {
+    min_x = std::min(min_x, cmd->vertices[i].x);
+    max_x = std::max(max_x, cmd->vertices[i].x);
+    min_y = std::min(min_y, cmd->vertices[i].y);
+    max_y = std::max(max_y, cmd->vertices[i].y);
+  }
+
+  const u32 num_pixels = MarkDrawingAreaDirty(min_x, min_y, max_x, max_y);
+
+  const TextureCacheEntry* texture = nullptr;
+  if (cmd->rc.texture_enable)
+  {
+    u32 min_u = cmd->vertices[0].u, max_u = cmd->vertices[0].u;
+    u32 min_v = cmd->vertices[0].v, max_v = cmd->vertices[0].v;
+    for (u32 i = 1; i < cmd->num_vertices; i++)
+    {
+      min_u = std::min<u32>(min_u, cmd->vertices[i].u);
+      max_u = std::max<u32>(max_u, cmd->vertices[i].u);
+      min_v = std::min<u32>(min_v, cmd->vertices[i].v);
+      max_v = std::max<u32>(max_v, cmd->vertices[i].v);
+    }
+
+    texture = GetTextureCacheEntry(cmd, min_u, max_u, min_v, max_v, num_pixels);
+  }
+
+  if (m_num_band_threads > 0 && QueueBandCommand(cmd, min_y, max_y, cmd->rc.texture_enable, texture))
+    return;
+
+  RasterizePolygon(cmd, m_drawing_area, texture);
+}
+
+void GPU_SW_Backend::DrawRectangle(const GPUBackendDrawRectangleCommand* cmd)
+{
+  const u32 num_pixels = MarkDrawingAreaDirty(cmd->x, cmd->y, cmd->x + static_cast<s32>(ZeroExtend32(cmd->width)) - 1,
+                                              cmd->y + static_cast<s32>(ZeroExtend32(cmd->height)) - 1);
+
+  const TextureCacheEntry* texture = nullptr;
+  if (cmd->rc.texture_enable)
+  {
+    // texture coordinates wrap around within the page
+    const auto [u, v] = UnpackTexcoord(cmd->texcoord);
+    const u32 max_u = ZeroExtend32(u) + std::max<u32>(cmd->width, 1) - 1;
+    const u32 max_v = ZeroExtend32(v) + std::max<u32>(cmd->height, 1) - 1;
+    texture = GetTextureCacheEntry(cmd, (max_u > 0xFF) ? 0 : u, std::min<u32>(max_u, 0xFF), (max_v > 0xFF) ? 0 : v,
+                                   std::min<u32>(max_v, 0xFF), num_pixels);
+  }
+
+  if (m_num_band_threads > 0 && QueueBandCommand(cmd, cmd->y, cmd->y + static_cast<s32>(ZeroExtend32(cmd->height)) - 1,
+                                                 cmd->rc.texture_enable, texture))
+  {
+    return;
+  }
+
+  RasterizeRectangle(cmd, m_drawing_area, texture);
+}
+
+void GPU_SW_Backend::DrawLine(const GPUBackendDrawLineCommand* cmd)
+{
+  s32 min_x = cmd->vertices[0].x, max_x = cmd->vertices[0].x;
+  s32 min_y = cmd->vertices[0].y, max_y = cmd->vertices[0].y;
+  for (u32 i = 1; i < cmd->num_vertices; i++)
+  {
+    min_x = std::min(min_x, cmd->vertices[i].x);
+    max_x = std::max(max_x, cmd->vertices[i].x);
+    min_y = std::min(min_y, cmd->vertices[i].y);
+    max_y = std::max(max_y, cmd->vertices[i].y);
+  }
+
+  MarkDrawingAreaDirty(min_x, min_y, max_x, max_y);
+
+  if (m_num_band_threads > 0 && QueueBandCommand(cmd, min_y, max_y, false, nullptr))
+    return;
+
+  RasterizeLine(cmd, m_drawing_area);
+}
+
+void GPU_SW_Backend::MarkVRAMDirty(u32 x, u32 y, u32 width, u32 height)
+{
+  const u16 columns = GetDirtyVRAMColumnMask(x, width);
+  for (u32 row = 0; row < std::min<u32>(height, VRAM_HEIGHT); row++)
+    m_dirty_vram_rows[(y + row) % VRAM_HEIGHT] |= columns;
+}
+
+u32 GPU_SW_Backend::MarkDrawingAreaDirty(s32 left, s32 top, s32 right, s32 bottom)
+{
+  // Vertices outside the 11-bit range wrap around, the primitive could end up anywhere in the drawing area.
+  if (left < -1024 || top < -1024 || right >= 1024 || bottom >= 1024)
+  {
+    left = static_cast<s32>(m_drawing_area.left);
+    top = static_cast<s32>(m_drawing_area.top);
+    right = static_cast<s32>(m_drawing_area.right);
+    bottom = static_cast<s32>(m_drawing_area.bottom);
+  }
+
+  left = std::max(left, static_cast<s32>(m_drawing_area.left));
+  top = std::max(top, static_cast<s32>(m_drawing_area.top));
+  right = std::min(right, static_cast<s32>(m_drawing_area.right));
+  bottom = std::min(bottom, static_cast<s32>(m_drawing_area.bottom));
+  if (left > right || top > bottom)
+    return 0;
+
+  const u32 width = static_cast<u32>(right - left + 1);
+  const u32 height = static_cast<u32>(bottom - top + 1);
+  MarkVRAMDirty(static_cast<u32>(left), static_cast<u32>(top), width, height);
+  return width * height;
+}
+
+void GPU_SW_Backend::RasterizePolygon(const GPUBackendDrawPolygonCommand* cmd, const Common::Rectangle<u32>& area,
+                                      const TextureCacheEntry* texture)
 {
   const GPURenderCommand rc{cmd->rc.bits};
   const bool dithering_enable = rc.IsDitheringEnabled() && cmd->draw_mode.dither_enable;
@@ -36,28 +198,29 @@ void GPU_SW_Backend::DrawPolygon(const GPUBackendDrawPolygonCommand* cmd)
   const DrawTriangleFunction DrawFunction = GetDrawTriangleFunction(
     rc.shading_enable, rc.texture_enable, rc.raw_texture_enable, rc.transparency_enable, dithering_enable);
 
-  (this->*DrawFunction)(cmd, &cmd->vertices[0], &cmd->vertices[1], &cmd->vertices[2]);
+  (this->*DrawFunction)(cmd, area, texture, &cmd->vertices[0], &cmd->vertices[1], &cmd->vertices[2]);
   if (rc.quad_polygon)
-    (this->*DrawFunction)(cmd, &cmd->vertices[2], &cmd->vertices[1], &cmd->vertices[3]);
+    (this->*DrawFunction)(cmd, area, texture, &cmd->vertices[2], &cmd->vertices[1], &cmd->vertices[3]);
 }
 
-void GPU_SW_Backend::DrawRectangle(const GPUBackendDrawRectangleCommand* cmd)
+void GPU_SW_Backend::RasterizeRectangle(const GPUBackendDrawRectangleCommand* cmd, const Common::Rectangle<u32>& area,
+                                        const TextureCacheEntry* texture)
 {
   const GPURenderCommand rc{cmd->rc.bits};
 
   const DrawRectangleFunction DrawFunction =
     GetDrawRectangleFunction(rc.texture_enable, rc.raw_texture_enable, rc.transparency_enable);
 
-  (this->*DrawFunction)(cmd);
+  (this->*DrawFunction)(cmd, area, texture);
 }
 
-void GPU_SW_Backend::DrawLine(const GPUBackendDrawLineCommand* cmd)
+void GPU_SW_Backend::RasterizeLine(const GPUBackendDrawLineCommand* cmd, const Common::Rectangle<u32>& area)
 {
   const DrawLineFunction DrawFunction =
     GetDrawLineFunction(cmd->rc.shading_enable, cmd->rc.transparency_enable, cmd->IsDitheringEnabled());
 
   for (u16 i = 1; i < cmd->num_vertices; i++)
-    (this->*DrawFunction)(cmd, &cmd->vertices[i - 1], &cmd->vertices[i]);
+    (this->*DrawFunction)(cmd, area, &cmd->vertices[i - 1], &cmd->vertices[i]);
 }
 
 constexpr GPU_SW_Backend::DitherLUT GPU_SW_Backend::ComputeDitherLUT()
@@ -79,8 +242,75 @@ constexpr GPU_SW_Backend::DitherLUT GPU_SW_Backend::ComputeDitherLUT()
 
 static constexpr GPU_SW_Backend::DitherLUT s_dither_lut = GPU_SW_Backend::ComputeDitherLUT();
 
+static ALWAYS_INLINE_RELEASE u16 FetchTexel(const u16* vram, const GPUBackendDrawCommand* cmd, u8 texcoord_x,
+                                            u8 texcoord_y)
+{
+  switch (cmd->draw_mode.texture_mode)
+  {
+    case GPUTextureMode::Palette4Bit:
+    {
+      const u16 palette_value =
+        vram[VRAM_WIDTH * ((cmd->draw_mode.GetTexturePageBaseY() + ZeroExtend32(texcoord_y)) % VRAM_HEIGHT) +
+             ((cmd->draw_mode.GetTexturePageBaseX() + ZeroExtend32(texcoord_x / 4)) % VRAM_WIDTH)];
+      const u16 palette_index = (palette_value >> ((texcoord_x % 4) * 4)) & 0x0Fu;
+      return vram[VRAM_WIDTH * cmd->palette.GetYBase() +
+                  ((cmd->palette.GetXBase() + ZeroExtend32(palette_index)) % VRAM_WIDTH)];
+    }
+
+    case GPUTextureMode::Palette8Bit:
+    {
+      const u16 palette_value =
+        vram[VRAM_WIDTH * ((cmd->draw_mode.GetTexturePageBaseY() + ZeroExtend32(texcoord_y)) % VRAM_HEIGHT) +
+             ((cmd->draw_mode.GetTexturePageBaseX() + ZeroExtend32(texcoord_x / 2)) % VRAM_WIDTH)];
+      const u16 palette_index = (palette_value >> ((texcoord_x % 2) * 8)) & 0xFFu;
+      return vram[VRAM_WIDTH * cmd->palette.GetYBase() +
+                  ((cmd->palette.GetXBase() + ZeroExtend32(palette_index)) % VRAM_WIDTH)];
+    }
+
+    default:
+    {
+      return vram[VRAM_WIDTH * ((cmd->draw_mode.GetTexturePageBaseY() + ZeroExtend32(texcoord_y)) % VRAM_HEIGHT) +
+                  ((cmd->draw_mode.GetTexturePageBaseX() + ZeroExtend32(texcoord_x)) % VRAM_WIDTH)];
+    }
+  }
+}
+
+static ALWAYS_INLINE_RELEASE u16 FetchCachedTexel(const u16* vram, const GPUBackendDrawCommand* cmd,
+                                                  const GPU_SW_Backend::TextureCacheEntry* texture, u8 texcoord_x,
+                                                  u8 texcoord_y)
+{
+  const u32 block = GPU_SW_Backend::TextureCacheEntry::GetBlockIndex(texcoord_x, texcoord_y);
+  if (texture->IsBlockValid(block))
+    return texture->texels[ZeroExtend32(texcoord_y) * TEXTURE_PAGE_WIDTH + ZeroExtend32(texcoord_x)];
+
+  return FetchTexel(vram, cmd, texcoord_x, texcoord_y);
+}
+
+static Common::Rectangle<u32> GetPaletteRectangle(const GPUBackendDrawCommand* cmd)
+{
+  const u32 palette_width = (cmd->draw_mode.texture_mode == GPUTextureMode::Palette4Bit) ? 16 : 256;
+  return Common::Rectangle<u32>::FromExtents(cmd->palette.GetXBase(), cmd->palette.GetYBase(), palette_width, 1);
+}
+
+static bool TextureRectangleIntersects(const Common::Rectangle<u32>& texture_rect, const Common::Rectangle<u32>& rect)
+{
+  // texture coordinates wrap around at the right edge of VRAM
+  return texture_rect.Intersects(rect) ||
+         (texture_rect.right > VRAM_WIDTH &&
+          Common::Rectangle<u32>(0, texture_rect.top, texture_rect.right - VRAM_WIDTH, texture_rect.bottom)
+            .Intersects(rect));
+}
+
+/// Returns true if the texture page or palette used by the primitive overlaps the rectangle (exclusive).
+static bool IsTextureInRectangle(const GPUBackendDrawCommand* cmd, const Common::Rectangle<u32>& rect)
+{
+  return TextureRectangleIntersects(cmd->draw_mode.GetTexturePageRectangle(), rect) ||
+         (cmd->draw_mode.IsUsingPalette() && TextureRectangleIntersects(GetPaletteRectangle(cmd), rect));
+}
+
 template<bool texture_enable, bool raw_texture_enable, bool transparency_enable, bool dithering_enable>
-void ALWAYS_INLINE_RELEASE GPU_SW_Backend::ShadePixel(const GPUBackendDrawCommand* cmd, u32 x, u32 y, u8 color_r,
+void ALWAYS_INLINE_RELEASE GPU_SW_Backend::ShadePixel(const GPUBackendDrawCommand* cmd,
+                                                      const TextureCacheEntry* texture, u32 x, u32 y, u8 color_r,
                                                       u8 color_g, u8 color_b, u8 texcoord_x, u8 texcoord_y)
 {
   VRAMPixel color;
@@ -91,38 +321,8 @@ void ALWAYS_INLINE_RELEASE GPU_SW_Backend::ShadePixel(const GPUBackendDrawComman
     texcoord_y = (texcoord_y & cmd->window.and_y) | cmd->window.or_y;
 
     VRAMPixel texture_color;
-    switch (cmd->draw_mode.texture_mode)
-    {
-      case GPUTextureMode::Palette4Bit:
-      {
-        const u16 palette_value =
-          GetPixel((cmd->draw_mode.GetTexturePageBaseX() + ZeroExtend32(texcoord_x / 4)) % VRAM_WIDTH,
-                   (cmd->draw_mode.GetTexturePageBaseY() + ZeroExtend32(texcoord_y)) % VRAM_HEIGHT);
-        const u16 palette_index = (palette_value >> ((texcoord_x % 4) * 4)) & 0x0Fu;
-
-        texture_color.bits =
-          GetPixel((cmd->palette.GetXBase() + ZeroExtend32(palette_index)) % VRAM_WIDTH, cmd->palette.GetYBase());
-      }
-      break;
-
-      case GPUTextureMode::Palette8Bit:
-      {
-        const u16 palette_value =
-          GetPixel((cmd->draw_mode.GetTexturePageBaseX() + ZeroExtend32(texcoord_x / 2)) % VRAM_WIDTH,
-                   (cmd->draw_mode.GetTexturePageBaseY() + ZeroExtend32(texcoord_y)) % VRAM_HEIGHT);
-        const u16 palette_index = (palette_value >> ((texcoord_x % 2) * 8)) & 0xFFu;
-        texture_color.bits =
-          GetPixel((cmd->palette.GetXBase() + ZeroExtend32(palette_index)) % VRAM_WIDTH, cmd->palette.GetYBase());
-      }
-      break;
-
-      default:
-      {
-        texture_color.bits = GetPixel((cmd->draw_mode.GetTexturePageBaseX() + ZeroExtend32(texcoord_x)) % VRAM_WIDTH,
-                                      (cmd->draw_mode.GetTexturePageBaseY() + ZeroExtend32(texcoord_y)) % VRAM_HEIGHT);
-      }
-      break;
-    }
+    texture_color.bits = texture ? FetchCachedTexel(m_vram.data(), cmd, texture, texcoord_x, texcoord_y) :
+                                   FetchTexel(m_vram.data(), cmd, texcoord_x, texcoord_y);
 
     if (texture_color.bits == 0)
       return;
@@ -219,8 +419,401 @@ void ALWAYS_INLINE_RELEASE GPU_SW_Backend::ShadePixel(const GPUBackendDrawComman
   SetPixel(static_cast<u32>(x), static_cast<u32>(y), color.bits | cmd->params.GetMaskOR());
 }
 
+//////////////////////////////////////////////////////////////////////////
+// Vectorized shading, mirrors ShadePixel() for groups of 8 pixels
+//////////////////////////////////////////////////////////////////////////
+
+#if defined(CPU_X64) || defined(CPU_AARCH64)
+#define SW_VECTOR_SHADING 1
+
+static constexpr u32 VECTOR_PIXELS = 8;
+
+#if defined(CPU_X64)
+
+using VecU16 = __m128i;
+using VecU32 = __m128i;
+
+static ALWAYS_INLINE VecU16 U16Set(u16 value)
+{
+  return _mm_set1_epi16(static_cast<s16>(value));
+}
+static ALWAYS_INLINE VecU16 U16Load(const u16* ptr)
+{
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+}
+static ALWAYS_INLINE void U16Store(u16* ptr, VecU16 value)
+{
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(ptr), value);
+}
+static ALWAYS_INLINE VecU16 U16And(VecU16 a, VecU16 b)
+{
+  return _mm_and_si128(a, b);
+}
+static ALWAYS_INLINE VecU16 U16AndNot(VecU16 a, VecU16 b)
+{
+  return _mm_andnot_si128(a, b);
+}
+static ALWAYS_INLINE VecU16 U16Or(VecU16 a, VecU16 b)
+{
+  return _mm_or_si128(a, b);
+}
+static ALWAYS_INLINE VecU16 U16Add(VecU16 a, VecU16 b)
+{
+  return _mm_add_epi16(a, b);
+}
+static ALWAYS_INLINE VecU16 U16Mul(VecU16 a, VecU16 b)
+{
+  return _mm_mullo_epi16(a, b);
+}
+template<int shift>
+static ALWAYS_INLINE VecU16 U16ShiftLeft(VecU16 a)
+{
+  return _mm_slli_epi16(a, shift);
+}
+template<int shift>
+static ALWAYS_INLINE VecU16 U16ShiftRight(VecU16 a)
+{
+  return _mm_srli_epi16(a, shift);
+}
+static ALWAYS_INLINE VecU16 U16Equal(VecU16 a, VecU16 b)
+{
+  return _mm_cmpeq_epi16(a, b);
+}
+static ALWAYS_INLINE VecU16 U16Select(VecU16 mask, VecU16 a, VecU16 b)
+{
+  return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+static ALWAYS_INLINE VecU16 U16Dither(VecU16 value, VecU16 offset)
+{
+  return _mm_min_epi16(_mm_max_epi16(_mm_srai_epi16(_mm_add_epi16(value, offset), 3), _mm_setzero_si128()),
+                       _mm_set1_epi16(31));
+}
+
+static ALWAYS_INLINE VecU32 U32Set(u32 value)
+{
+  return _mm_set1_epi32(static_cast<s32>(value));
+}
+static ALWAYS_INLINE VecU32 U32Load(const u32* ptr)
+{
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+}
+static ALWAYS_INLINE VecU32 U32Add(VecU32 a, VecU32 b)
+{
+  return _mm_add_epi32(a, b);
+}
+static ALWAYS_INLINE VecU32 U32Sub(VecU32 a, VecU32 b)
+{
+  return _mm_sub_epi32(a, b);
+}
+static ALWAYS_INLINE VecU32 U32And(VecU32 a, VecU32 b)
+{
+  return _mm_and_si128(a, b);
+}
+static ALWAYS_INLINE VecU32 U32Or(VecU32 a, VecU32 b)
+{
+  return _mm_or_si128(a, b);
+}
+static ALWAYS_INLINE VecU32 U32Xor(VecU32 a, VecU32 b)
+{
+  return _mm_xor_si128(a, b);
+}
+template<int shift>
+static ALWAYS_INLINE VecU32 U32ShiftRight(VecU32 a)
+{
+  return _mm_srli_epi32(a, shift);
+}
+static ALWAYS_INLINE VecU32 U16ToU32Low(VecU16 a)
+{
+  return _mm_unpacklo_epi16(a, _mm_setzero_si128());
+}
+static ALWAYS_INLINE VecU32 U16ToU32High(VecU16 a)
+{
+  return _mm_unpackhi_epi16(a, _mm_setzero_si128());
+}
+static ALWAYS_INLINE VecU16 U32ToU16(VecU32 low, VecU32 high)
+{
+  // SSE2 only has a saturating pack, so sign extend the low halves first
+  return _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(low, 16), 16), _mm_srai_epi32(_mm_slli_epi32(high, 16), 16));
+}
+
+#elif defined(CPU_AARCH64)
+
+using VecU16 = uint16x8_t;
+using VecU32 = uint32x4_t;
+
+static ALWAYS_INLINE VecU16 U16Set(u16 value)
+{
+  return vdupq_n_u16(value);
+}
+static ALWAYS_INLINE VecU16 U16Load(const u16* ptr)
+{
+  return vld1q_u16(ptr);
+}
+static ALWAYS_INLINE void U16Store(u16* ptr, VecU16 value)
+{
+  vst1q_u16(ptr, value);
+}
+static ALWAYS_INLINE VecU16 U16And(VecU16 a, VecU16 b)
+{
+  return vandq_u16(a, b);
+}
+static ALWAYS_INLINE VecU16 U16AndNot(VecU16 a, VecU16 b)
+{
+  return vbicq_u16(b, a);
+}
+static ALWAYS_INLINE VecU16 U16Or(VecU16 a, VecU16 b)
+{
+  return vorrq_u16(a, b);
+}
+static ALWAYS_INLINE VecU16 U16Add(VecU16 a, VecU16 b)
+{
+  return vaddq_u16(a, b);
+}
+static ALWAYS_INLINE VecU16 U16Mul(VecU16 a, VecU16 b)
+{
+  return vmulq_u16(a, b);
+}
+template<int shift>
+static ALWAYS_INLINE VecU16 U16ShiftLeft(VecU16 a)
+{
+  return vshlq_n_u16(a, shift);
+}
+template<int shift>
+static ALWAYS_INLINE VecU16 U16ShiftRight(VecU16 a)
+{
+  return vshrq_n_u16(a, shift);
+}
+static ALWAYS_INLINE VecU16 U16Equal(VecU16 a, VecU16 b)
+{
+  return vceqq_u16(a, b);
+}
+static ALWAYS_INLINE VecU16 U16Select(VecU16 mask, VecU16 a, VecU16 b)
+{
+  return vbslq_u16(mask, a, b);
+}
+static ALWAYS_INLINE VecU16 U16Dither(VecU16 value, VecU16 offset)
+{
+  const int16x8_t dithered = vshrq_n_s16(vaddq_s16(vreinterpretq_s16_u16(value), vreinterpretq_s16_u16(offset)), 3);
+  return vreinterpretq_u16_s16(vminq_s16(vmaxq_s16(dithered, vdupq_n_s16(0)), vdupq_n_s16(31)));
+}
+
+static ALWAYS_INLINE VecU32 U32Set(u32 value)
+{
+  return vdupq_n_u32(value);
+}
+static ALWAYS_INLINE VecU32 U32Load(const u32* ptr)
+{
+  return vld1q_u32(ptr);
+}
+static ALWAYS_INLINE VecU32 U32Add(VecU32 a, VecU32 b)
+{
+  return vaddq_u32(a, b);
+}
+static ALWAYS_INLINE VecU32 U32Sub(VecU32 a, VecU32 b)
+{
+  return vsubq_u32(a, b);
+}
+static ALWAYS_INLINE VecU32 U32And(VecU32 a, VecU32 b)
+{
+  return vandq_u32(a, b);
+}
+static ALWAYS_INLINE VecU32 U32Or(VecU32 a, VecU32 b)
+{
+  return vorrq_u32(a, b);
+}
+static ALWAYS_INLINE VecU32 U32Xor(VecU32 a, VecU32 b)
+{
+  return veorq_u32(a, b);
+}
+template<int shift>
+static ALWAYS_INLINE VecU32 U32ShiftRight(VecU32 a)
+{
+  return vshrq_n_u32(a, shift);
+}
+static ALWAYS_INLINE VecU32 U16ToU32Low(VecU16 a)
+{
+  return vmovl_u16(vget_low_u16(a));
+}
+static ALWAYS_INLINE VecU32 U16ToU32High(VecU16 a)
+{
+  return vmovl_u16(vget_high_u16(a));
+}
+static ALWAYS_INLINE VecU16 U32ToU16(VecU32 low, VecU32 high)
+{
+  return vcombine_u16(vmovn_u32(low), vmovn_u32(high));
+}
+
+#endif
+
+static ALWAYS_INLINE VecU16 U16LaneIndices()
+{
+  alignas(16) static constexpr u16 indices[VECTOR_PIXELS] = {0, 1, 2, 3, 4, 5, 6, 7};
+  return U16Load(indices);
+}
+
+static ALWAYS_INLINE VecU32 U32Ramp(u32 value, u32 step)
+{
+  alignas(16) const u32 values[4] = {value, value + step, value + step * 2, value + step * 3};
+  return U32Load(values);
+}
+
+template<bool dithering_enable>
+static ALWAYS_INLINE VecU16 GetDitherOffsets(u32 x, u32 y)
+{
+  // Groups always start at a multiple of 8 pixels from the first, so the offsets are the same for the whole span.
+  if constexpr (!dithering_enable)
+    return U16Set(0);
+
+  alignas(16) u16 offsets[VECTOR_PIXELS];
+  for (u32 i = 0; i < VECTOR_PIXELS; i++)
+    offsets[i] = static_cast<u16>(DITHER_MATRIX[y & 3u][(x + i) & 3u]);
+  return U16Load(offsets);
+}
+
+/// Blends one pixel per 32-bit lane, so the intermediate carries are the same as ShadePixel().
+template<GPUTransparencyMode transparency_mode>
+static ALWAYS_INLINE VecU32 BlendPixelsU32(VecU32 fg_bits, VecU32 bg_bits)
+{
+  if constexpr (transparency_mode == GPUTransparencyMode::HalfBackgroundPlusHalfForeground)
+  {
+    bg_bits = U32Or(bg_bits, U32Set(0x8000u));
+    return U32ShiftRight<1>(U32Sub(U32Add(fg_bits, bg_bits), U32And(U32Xor(fg_bits, bg_bits), U32Set(0x0421u))));
+  }
+  else if constexpr (transparency_mode == GPUTransparencyMode::BackgroundMinusForeground)
+  {
+    bg_bits = U32Or(bg_bits, U32Set(0x8000u));
+    fg_bits = U32And(fg_bits, U32Set(0x7FFFu));
+
+    const VecU32 diff = U32Add(U32Sub(bg_bits, fg_bits), U32Set(0x108420u));
+    const VecU32 borrow =
+      U32And(U32Sub(diff, U32And(U32Xor(bg_bits, fg_bits), U32Set(0x108420u))), U32Set(0x108420u));
+
+    return U32And(U32Sub(diff, borrow), U32Sub(borrow, U32ShiftRight<5>(borrow)));
+  }
+  else
+  {
+    bg_bits = U32And(bg_bits, U32Set(0x7FFFu));
+    if constexpr (transparency_mode == GPUTransparencyMode::BackgroundPlusQuarterForeground)
+      fg_bits = U32Or(U32And(U32ShiftRight<2>(fg_bits), U32Set(0x1CE7u)), U32Set(0x8000u));
+
+    const VecU32 sum = U32Add(fg_bits, bg_bits);
+    const VecU32 carry = U32And(U32Sub(sum, U32And(U32Xor(fg_bits, bg_bits), U32Set(0x8421u))), U32Set(0x8420u));
+
+    return U32Or(U32Sub(sum, carry), U32Sub(carry, U32ShiftRight<5>(carry)));
+  }
+}
+
+template<GPUTransparencyMode transparency_mode>
+static ALWAYS_INLINE VecU16 BlendPixels(VecU16 fg_bits, VecU16 bg_bits)
+{
+  return U32ToU16(BlendPixelsU32<transparency_mode>(U16ToU32Low(fg_bits), U16ToU32Low(bg_bits)),
+                  BlendPixelsU32<transparency_mode>(U16ToU32High(fg_bits), U16ToU32High(bg_bits)));
+}
+
+/// Shades VECTOR_PIXELS pixels starting at (x, y). The texture must not overlap the pixels being written, since all
+/// texels are fetched before any pixel is stored.
+template<bool texture_enable, bool raw_texture_enable, bool transparency_enable, bool dithering_enable>
+static ALWAYS_INLINE_RELEASE void ShadePixels(u16* vram, const GPUBackendDrawCommand* cmd,
+                                              const GPU_SW_Backend::TextureCacheEntry* texture, u32 x, u32 y,
+                                              VecU16 color_r, VecU16 color_g, VecU16 color_b, VecU16 texcoord_x,
+                                              VecU16 texcoord_y, VecU16 dither_offsets)
+{
+  const VecU16 zero = U16Set(0);
+  VecU16 color;
+  VecU16 transparent_texels;
+  if constexpr (texture_enable)
+  {
+    // Apply texture window
+    texcoord_x = U16Or(U16And(texcoord_x, U16Set(cmd->window.and_x)), U16Set(cmd->window.or_x));
+    texcoord_y = U16Or(U16And(texcoord_y, U16Set(cmd->window.and_y)), U16Set(cmd->window.or_y));
+
+    // There's no gather in the baseline instruction sets, and the lookups depend on the texture mode anyway.
+    alignas(16) u16 texcoords_x[VECTOR_PIXELS];
+    alignas(16) u16 texcoords_y[VECTOR_PIXELS];
+    alignas(16) u16 texels[VECTOR_PIXELS];
+    U16Store(texcoords_x, texcoord_x);
+    U16Store(texcoords_y, texcoord_y);
+    if (texture)
+    {
+      for (u32 i = 0; i < VECTOR_PIXELS; i++)
+      {
+        texels[i] =
+          FetchCachedTexel(vram, cmd, texture, static_cast<u8>(texcoords_x[i]), static_cast<u8>(texcoords_y[i]));
+      }
+    }
+    else
+    {
+      for (u32 i = 0; i < VECTOR_PIXELS; i++)
+        texels[i] = FetchTexel(vram, cmd, static_cast<u8>(texcoords_x[i]), static_cast<u8>(texcoords_y[i]));
+    }
+
+    const VecU16 texture_color = U16Load(texels);
+    transparent_texels = U16Equal(texture_color, zero);
+
+    if constexpr (raw_texture_enable)
+    {
+      color = texture_color;
+    }
+    else
+    {
+      const VecU16 component_mask = U16Set(0x1F);
+      const VecU16 r = U16And(texture_color, component_mask);
+      const VecU16 g = U16And(U16ShiftRight<5>(texture_color), component_mask);
+      const VecU16 b = U16And(U16ShiftRight<10>(texture_color), component_mask);
+      color = U16Or(U16Or(U16Dither(U16ShiftRight<4>(U16Mul(r, color_r)), dither_offsets),
+                          U16ShiftLeft<5>(U16Dither(U16ShiftRight<4>(U16Mul(g, color_g)), dither_offsets))),
+                    U16Or(U16ShiftLeft<10>(U16Dither(U16ShiftRight<4>(U16Mul(b, color_b)), dither_offsets)),
+                          U16And(texture_color, U16Set(0x8000u))));
+    }
+  }
+  else
+  {
+    // Non-textured transparent polygons don't set bit 15, but are treated as transparent.
+    color = U16Or(U16Or(U16Dither(color_r, dither_offsets), U16ShiftLeft<5>(U16Dither(color_g, dither_offsets))),
+                  U16Or(U16ShiftLeft<10>(U16Dither(color_b, dither_offsets)),
+                        U16Set(transparency_enable ? 0x8000u : 0u)));
+  }
+
+  u16* const pixels = &vram[VRAM_WIDTH * y + x];
+  const VecU16 bg_color = U16Load(pixels);
+  if constexpr (transparency_enable)
+  {
+    VecU16 blended;
+    switch (cmd->draw_mode.transparency_mode)
+    {
+      case GPUTransparencyMode::HalfBackgroundPlusHalfForeground:
+        blended = BlendPixels<GPUTransparencyMode::HalfBackgroundPlusHalfForeground>(color, bg_color);
+        break;
+      case GPUTransparencyMode::BackgroundPlusForeground:
+        blended = BlendPixels<GPUTransparencyMode::BackgroundPlusForeground>(color, bg_color);
+        break;
+      case GPUTransparencyMode::BackgroundMinusForeground:
+        blended = BlendPixels<GPUTransparencyMode::BackgroundMinusForeground>(color, bg_color);
+        break;
+      case GPUTransparencyMode::BackgroundPlusQuarterForeground:
+      default:
+        blended = BlendPixels<GPUTransparencyMode::BackgroundPlusQuarterForeground>(color, bg_color);
+        break;
+    }
+
+    if constexpr (texture_enable)
+      color = U16Select(U16Equal(U16And(color, U16Set(0x8000u)), zero), color, blended);
+    else
+      color = U16And(blended, U16Set(0x7FFFu));
+  }
+
+  VecU16 write_mask = U16Equal(U16And(bg_color, U16Set(cmd->params.GetMaskAND())), zero);
+  if constexpr (texture_enable)
+    write_mask = U16AndNot(transparent_texels, write_mask);
+
+  U16Store(pixels, U16Select(write_mask, U16Or(color, U16Set(cmd->params.GetMaskOR())), bg_color));
+}
+
+#endif
+
 template<bool texture_enable, bool raw_texture_enable, bool transparency_enable>
-void GPU_SW_Backend::DrawRectangle(const GPUBackendDrawRectangleCommand* cmd)
+void GPU_SW_Backend::DrawRectangle(const GPUBackendDrawRectangleCommand* cmd, const Common::Rectangle<u32>& area,
+                                   const TextureCacheEntry* texture)
 {
   const s32 origin_x = cmd->x;
   const s32 origin_y = cmd->y;
@@ -230,7 +823,7 @@ void GPU_SW_Backend::DrawRectangle(const GPUBackendDrawRectangleCommand* cmd)
   for (u32 offset_y = 0; offset_y < cmd->height; offset_y++)
   {
     const s32 y = origin_y + static_cast<s32>(offset_y);
-    if (y < static_cast<s32>(m_drawing_area.top) || y > static_cast<s32>(m_drawing_area.bottom) ||
+    if (y < static_cast<s32>(area.top) || y > static_cast<s32>(area.bottom) ||
         (cmd->params.interlaced_rendering && cmd->params.active_line_lsb == (Truncate8(static_cast<u32>(y)) & 1u)))
     {
       continue;
@@ -238,16 +831,46 @@ void GPU_SW_Backend::DrawRectangle(const GPUBackendDrawRectangleCommand* cmd)
 
     const u8 texcoord_y = Truncate8(ZeroExtend32(origin_texcoord_y) + offset_y);
 
-    for (u32 offset_x = 0; offset_x < cmd->width; offset_x++)
+    u32 offset_x = 0;
+
+#ifdef SW_VECTOR_SHADING
+    const s32 start_x = std::max(origin_x, static_cast<s32>(area.left));
+    const s32 end_x = std::min(origin_x + static_cast<s32>(cmd->width), static_cast<s32>(area.right) + 1);
+    if ((end_x - start_x) >= static_cast<s32>(VECTOR_PIXELS) &&
+        (!texture_enable ||
+         !IsTextureInRectangle(cmd, Common::Rectangle<u32>(static_cast<u32>(start_x), static_cast<u32>(y),
+                                                           static_cast<u32>(end_x), static_cast<u32>(y) + 1))))
+    {
+      const VecU16 color_r = U16Set(r);
+      const VecU16 color_g = U16Set(g);
+      const VecU16 color_b = U16Set(b);
+      const VecU16 texcoords_y = U16Set(texcoord_y);
+      const VecU16 lane_indices = U16LaneIndices();
+
+      s32 x = start_x;
+      for (; (x + static_cast<s32>(VECTOR_PIXELS)) <= end_x; x += VECTOR_PIXELS)
+      {
+        const VecU16 texcoords_x =
+          U16And(U16Add(U16Set(static_cast<u16>(origin_texcoord_x + (x - origin_x))), lane_indices), U16Set(0xFF));
+        ShadePixels<texture_enable, raw_texture_enable, transparency_enable, false>(
+          m_vram.data(), cmd, texture, static_cast<u32>(x), static_cast<u32>(y), color_r, color_g, color_b,
+          texcoords_x, texcoords_y, U16Set(0));
+      }
+
+      offset_x = static_cast<u32>(x - origin_x);
+    }
+#endif
+
+    for (; offset_x < cmd->width; offset_x++)
     {
       const s32 x = origin_x + static_cast<s32>(offset_x);
-      if (x < static_cast<s32>(m_drawing_area.left) || x > static_cast<s32>(m_drawing_area.right))
+      if (x < static_cast<s32>(area.left) || x > static_cast<s32>(area.right))
         continue;
 
       const u8 texcoord_x = Truncate8(ZeroExtend32(origin_texcoord_x) + offset_x);
 
       ShadePixel<texture_enable, raw_texture_enable, transparency_enable, false>(
-        cmd, static_cast<u32>(x), static_cast<u32>(y), r, g, b, texcoord_x, texcoord_y);
+        cmd, texture, static_cast<u32>(x), static_cast<u32>(y), r, g, b, texcoord_x, texcoord_y);
     }
   }
 }
@@ -358,9 +981,39 @@ void ALWAYS_INLINE_RELEASE GPU_SW_Backend::AddIDeltas_DY(i_group& ig, const i_de
   }
 }
 
+#ifdef SW_VECTOR_SHADING
+
+/// Interpolated attribute for a group of pixels along a span.
+struct VectorAttribute
+{
+  VecU32 low;
+  VecU32 high;
+  VecU32 step;
+
+  ALWAYS_INLINE VectorAttribute(u32 value, u32 delta)
+    : low(U32Ramp(value, delta)), high(U32Ramp(value + delta * 4, delta)), step(U32Set(delta * VECTOR_PIXELS))
+  {
+  }
+
+  ALWAYS_INLINE VecU16 GetValues() const
+  {
+    return U32ToU16(U32ShiftRight<COORD_FBS + COORD_POST_PADDING>(low),
+                    U32ShiftRight<COORD_FBS + COORD_POST_PADDING>(high));
+  }
+
+  ALWAYS_INLINE void Step()
+  {
+    low = U32Add(low, step);
+    high = U32Add(high, step);
+  }
+};
+
+#endif
+
 template<bool shading_enable, bool texture_enable, bool raw_texture_enable, bool transparency_enable,
          bool dithering_enable>
-void GPU_SW_Backend::DrawSpan(const GPUBackendDrawPolygonCommand* cmd, s32 y, s32 x_start, s32 x_bound, i_group ig,
+void GPU_SW_Backend::DrawSpan(const GPUBackendDrawPolygonCommand* cmd, const Common::Rectangle<u32>& area,
+                              const TextureCacheEntry* texture, s32 y, s32 x_start, s32 x_bound, i_group ig,
                               const i_deltas& idl)
 {
   if (cmd->params.interlaced_rendering && cmd->params.active_line_lsb == (Truncate8(static_cast<u32>(y)) & 1u))
@@ -370,16 +1023,16 @@ void GPU_SW_Backend::DrawSpan(const GPUBackendDrawPolygonCommand* cmd, s32 y, s3
   s32 w = x_bound - x_start;
   s32 x = TruncateGPUVertexPosition(x_start);
 
-  if (x < static_cast<s32>(m_drawing_area.left))
+  if (x < static_cast<s32>(area.left))
   {
-    s32 delta = static_cast<s32>(m_drawing_area.left) - x;
+    s32 delta = static_cast<s32>(area.left) - x;
     x_ig_adjust += delta;
     x += delta;
     w -= delta;
   }
 
-  if ((x + w) > (static_cast<s32>(m_drawing_area.right) + 1))
-    w = static_cast<s32>(m_drawing_area.right) + 1 - x;
+  if ((x + w) > (static_cast<s32>(area.right) + 1))
+    w = static_cast<s32>(area.right) + 1 - x;
 
   if (w <= 0)
     return;
@@ -387,6 +1040,43 @@ void GPU_SW_Backend::DrawSpan(const GPUBackendDrawPolygonCommand* cmd, s32 y, s3
   AddIDeltas_DX<shading_enable, texture_enable>(ig, idl, x_ig_adjust);
   AddIDeltas_DY<shading_enable, texture_enable>(ig, idl, y);
 
+#ifdef SW_VECTOR_SHADING
+  // Spans which sample from the pixels they write have to be drawn a pixel at a time, to see their own output.
+  if (w >= static_cast<s32>(VECTOR_PIXELS) &&
+      (!texture_enable ||
+       !IsTextureInRectangle(cmd, Common::Rectangle<u32>(static_cast<u32>(x), static_cast<u32>(y),
+                                                         static_cast<u32>(x + w), static_cast<u32>(y) + 1))))
+  {
+    VectorAttribute r(ig.r, shading_enable ? idl.dr_dx : 0);
+    VectorAttribute g(ig.g, shading_enable ? idl.dg_dx : 0);
+    VectorAttribute b(ig.b, shading_enable ? idl.db_dx : 0);
+    VectorAttribute u(texture_enable ? ig.u : 0, texture_enable ? idl.du_dx : 0);
+    VectorAttribute v(texture_enable ? ig.v : 0, texture_enable ? idl.dv_dx : 0);
+    const VecU16 dither_offsets = GetDitherOffsets<dithering_enable>(static_cast<u32>(x), static_cast<u32>(y));
+
+    const s32 start_x = x;
+    do
+    {
+      ShadePixels<texture_enable, raw_texture_enable, transparency_enable, dithering_enable>(
+        m_vram.data(), cmd, texture, static_cast<u32>(x), static_cast<u32>(y), r.GetValues(), g.GetValues(),
+        b.GetValues(), u.GetValues(), v.GetValues(), dither_offsets);
+
+      r.Step();
+      g.Step();
+      b.Step();
+      u.Step();
+      v.Step();
+      x += VECTOR_PIXELS;
+      w -= VECTOR_PIXELS;
+    } while (w >= static_cast<s32>(VECTOR_PIXELS));
+
+    if (w == 0)
+      return;
+
+    AddIDeltas_DX<shading_enable, texture_enable>(ig, idl, static_cast<u32>(x - start_x));
+  }
+#endif
+
   do
   {
     const u32 r = ig.r >> (COORD_FBS + COORD_POST_PADDING);
@@ -396,7 +1086,7 @@ void GPU_SW_Backend::DrawSpan(const GPUBackendDrawPolygonCommand* cmd, s32 y, s3
     const u32 v = ig.v >> (COORD_FBS + COORD_POST_PADDING);
 
     ShadePixel<texture_enable, raw_texture_enable, transparency_enable, dithering_enable>(
-      cmd, static_cast<u32>(x), static_cast<u32>(y), Truncate8(r), Truncate8(g), Truncate8(b), Truncate8(u),
+      cmd, texture, static_cast<u32>(x), static_cast<u32>(y), Truncate8(r), Truncate8(g), Truncate8(b), Truncate8(u),
       Truncate8(v));
 
     x++;
@@ -406,8 +1096,8 @@ void GPU_SW_Backend::DrawSpan(const GPUBackendDrawPolygonCommand* cmd, s32 y, s3
 
 template<bool shading_enable, bool texture_enable, bool raw_texture_enable, bool transparency_enable,
          bool dithering_enable>
-void GPU_SW_Backend::DrawTriangle(const GPUBackendDrawPolygonCommand* cmd,
-                                  const GPUBackendDrawPolygonCommand::Vertex* v0,
+void GPU_SW_Backend::DrawTriangle(const GPUBackendDrawPolygonCommand* cmd, const Common::Rectangle<u32>& area,
+                                  const TextureCacheEntry* texture, const GPUBackendDrawPolygonCommand::Vertex* v0,
                                   const GPUBackendDrawPolygonCommand::Vertex* v1,
                                   const GPUBackendDrawPolygonCommand::Vertex* v2)
 {
@@ -564,14 +1254,14 @@ void GPU_SW_Backend::DrawTriangle(const GPUBackendDrawPolygonCommand* cmd,
 
         s32 y = TruncateGPUVertexPosition(yi);
 
-        if (y < static_cast<s32>(m_drawing_area.top))
+        if (y < static_cast<s32>(area.top))
           break;
 
-        if (y > static_cast<s32>(m_drawing_area.bottom))
+        if (y > static_cast<s32>(area.bottom))
           continue;
 
         DrawSpan<shading_enable, texture_enable, raw_texture_enable, transparency_enable, dithering_enable>(
-          cmd, yi, GetPolyXFP_Int(lc), GetPolyXFP_Int(rc), ig, idl);
+          cmd, area, texture, yi, GetPolyXFP_Int(lc), GetPolyXFP_Int(rc), ig, idl);
       }
     }
     else
@@ -580,14 +1270,14 @@ void GPU_SW_Backend::DrawTriangle(const GPUBackendDrawPolygonCommand* cmd,
       {
         s32 y = TruncateGPUVertexPosition(yi);
 
-        if (y > static_cast<s32>(m_drawing_area.bottom))
+        if (y > static_cast<s32>(area.bottom))
           break;
 
-        if (y >= static_cast<s32>(m_drawing_area.top))
+        if (y >= static_cast<s32>(area.top))
         {
 
           DrawSpan<shading_enable, texture_enable, raw_texture_enable, transparency_enable, dithering_enable>(
-            cmd, yi, GetPolyXFP_Int(lc), GetPolyXFP_Int(rc), ig, idl);
+            cmd, area, texture, yi, GetPolyXFP_Int(lc), GetPolyXFP_Int(rc), ig, idl);
         }
 
         yi++;
@@ -632,8 +1322,8 @@ static ALWAYS_INLINE_RELEASE s64 LineDivide(s64 delta, s32 dk)
 }
 
 template<bool shading_enable, bool transparency_enable, bool dithering_enable>
-void GPU_SW_Backend::DrawLine(const GPUBackendDrawLineCommand* cmd, const GPUBackendDrawLineCommand::Vertex* p0,
-                              const GPUBackendDrawLineCommand::Vertex* p1)
+void GPU_SW_Backend::DrawLine(const GPUBackendDrawLineCommand* cmd, const Common::Rectangle<u32>& area,
+                              const GPUBackendDrawLineCommand::Vertex* p0, const GPUBackendDrawLineCommand::Vertex* p1)
 {
   const s32 i_dx = std::abs(p1->x - p0->x);
   const s32 i_dy = std::abs(p1->y - p0->y);
@@ -693,15 +1383,15 @@ void GPU_SW_Backend::DrawLine(const GPUBackendDrawLineCommand* cmd, const GPUBac
     const s32 y = (cur_point.y >> Line_XY_FractBits) & 2047;
 
     if ((!cmd->params.interlaced_rendering || cmd->params.active_line_lsb != (Truncate8(static_cast<u32>(y)) & 1u)) &&
-        x >= static_cast<s32>(m_drawing_area.left) && x <= static_cast<s32>(m_drawing_area.right) &&
-        y >= static_cast<s32>(m_drawing_area.top) && y <= static_cast<s32>(m_drawing_area.bottom))
+        x >= static_cast<s32>(area.left) && x <= static_cast<s32>(area.right) &&
+        y >= static_cast<s32>(area.top) && y <= static_cast<s32>(area.bottom))
     {
       const u8 r = shading_enable ? static_cast<u8>(cur_point.r >> Line_RGB_FractBits) : p0->r;
       const u8 g = shading_enable ? static_cast<u8>(cur_point.g >> Line_RGB_FractBits) : p0->g;
       const u8 b = shading_enable ? static_cast<u8>(cur_point.b >> Line_RGB_FractBits) : p0->b;
 
-      ShadePixel<false, false, transparency_enable, dithering_enable>(cmd, static_cast<u32>(x), static_cast<u32>(y), r,
-                                                                      g, b, 0, 0);
+      ShadePixel<false, false, transparency_enable, dithering_enable>(cmd, nullptr, static_cast<u32>(x),
+                                                                      static_cast<u32>(y), r, g, b, 0, 0);
     }
 
     cur_point.x += step.dx_dk;
@@ -718,6 +1408,9 @@ void GPU_SW_Backend::DrawLine(const GPUBackendDrawLineCommand* cmd, const GPUBac
 
 void GPU_SW_Backend::FillVRAM(u32 x, u32 y, u32 width, u32 height, u32 color, GPUBackendCommandParameters params)
 {
+  InvalidateTextureCache(x, y, width, height);
+  MarkVRAMDirty(x, y, width, height);
+
   const u16 color16 = VRAMRGBA8888ToRGBA5551(color);
   if ((x + width) <= VRAM_WIDTH && !params.interlaced_rendering)
   {
@@ -763,6 +1456,9 @@ void GPU_SW_Backend::FillVRAM(u32 x, u32 y, u32 width, u32 height, u32 color, GP
 void GPU_SW_Backend::UpdateVRAM(u32 x, u32 y, u32 width, u32 height, const void* data,
                                 GPUBackendCommandParameters params)
 {
+  InvalidateTextureCache(x, y, width, height);
+  MarkVRAMDirty(x, y, width, height);
+
   // Fast path when the copy is not oversized.
   if ((x + width) <= VRAM_WIDTH && (y + height) <= VRAM_HEIGHT && !params.IsMaskingEnabled())
   {
@@ -799,6 +1495,9 @@ void GPU_SW_Backend::UpdateVRAM(u32 x, u32 y, u32 width, u32 height, const void*
 void GPU_SW_Backend::CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 width, u32 height,
                               GPUBackendCommandParameters params)
 {
+  InvalidateTextureCache(dst_x, dst_y, width, height);
+  MarkVRAMDirty(dst_x, dst_y, width, height);
+
   // Break up oversized copies. This behavior has not been verified on console.
   if ((src_x + width) > VRAM_WIDTH || (dst_x + width) > VRAM_WIDTH)
   {
@@ -870,9 +1569,398 @@ void GPU_SW_Backend::CopyVRAM(u32 src_x, u32 src_y, u32 dst_x, u32 dst_y, u32 wi
   }
 }
 
-void GPU_SW_Backend::FlushRender() {}
+void GPU_SW_Backend::FlushRender()
+{
+  WaitForBandThreads();
+}
+
+void GPU_SW_Backend::DrawingAreaChanged()
+{
+  // Cached textures never overlap the drawing area, so drawing doesn't have to check the cache.
+  if (m_drawing_area.left <= m_drawing_area.right && m_drawing_area.top <= m_drawing_area.bottom)
+  {
+    InvalidateTextureCache(m_drawing_area.left, m_drawing_area.top, m_drawing_area.GetWidth() + 1,
+                           m_drawing_area.GetHeight() + 1);
+  }
+}
+
+void GPU_SW_Backend::StartBandThreads(u32 count)
+{
+  // a single band would just be a slower GPU thread
+  count = std::min<u32>(count, MAX_BAND_THREADS);
+  if (count < 2)
+    return;
+
+  m_band_command_buffer.resize(BAND_COMMAND_BUFFER_SIZE);
+  m_band_write_ptr.store(0);
+  m_band_wake_ptr = 0;
+  m_band_threads_done.store(false);
+  m_band_threads_idle_wait.store(false);
+
+  m_band_threads = std::make_unique<BandThread[]>(count);
+  m_num_band_threads = count;
+  for (u32 i = 0; i < count; i++)
+    m_band_threads[i].thread = std::thread(&GPU_SW_Backend::BandThreadMain, this, i);
+
+  Log_InfoPrintf("Drawing with %u band threads.", count);
+}
+
+void GPU_SW_Backend::StopBandThreads()
+{
+  if (m_num_band_threads == 0)
+    return;
+
+  {
+    std::unique_lock<std::mutex> lock(m_band_mutex);
+    m_band_threads_done.store(true);
+    m_band_wake_cv.notify_all();
+  }
+
+  for (u32 i = 0; i < m_num_band_threads; i++)
+    m_band_threads[i].thread.join();
+
+  m_band_threads.reset();
+  m_num_band_threads = 0;
+  m_band_command_buffer = {};
+}
+
+void GPU_SW_Backend::BandThreadMain(u32 index)
+{
+  static constexpr double SPIN_TIME_NS = 100 * 1000;
+
+  BandThread& bt = m_band_threads[index];
+  const u32 band_bit = 1u << index;
+  u32 read_ptr = bt.read_ptr.load();
+  Common::Timer::Value last_command_time = Common::Timer::GetValue();
+
+  for (;;)
+  {
+    const u32 write_ptr = m_band_write_ptr.load();
+    if (read_ptr == write_ptr)
+    {
+      if (Common::Timer::ConvertValueToNanoseconds(Common::Timer::GetValue() - last_command_time) < SPIN_TIME_NS)
+        continue;
+
+      std::unique_lock<std::mutex> lock(m_band_mutex);
+      m_band_threads_sleeping.fetch_add(1);
+      m_band_wake_cv.wait(lock, [this, read_ptr]() {
+        return m_band_threads_done.load() || m_band_write_ptr.load() != read_ptr;
+      });
+      m_band_threads_sleeping.fetch_sub(1);
+
+      if (m_band_threads_done.load())
+        break;
+
+      last_command_time = Common::Timer::GetValue();
+      continue;
+    }
+
+    // the drawing area can't change while there are primitives queued
+    const Common::Rectangle<u32> area = GetBandDrawingArea(index);
+    while (read_ptr != write_ptr)
+    {
+      const BandCommandHeader* header =
+        reinterpret_cast<const BandCommandHeader*>(&m_band_command_buffer[read_ptr % BAND_COMMAND_BUFFER_SIZE]);
+      read_ptr += header->size;
+      if (!(header->band_mask & band_bit))
+        continue;
+
+      const GPUBackendCommand* cmd = reinterpret_cast<const GPUBackendCommand*>(header + 1);
+      switch (cmd->type)
+      {
+        case GPUBackendCommandType::DrawPolygon:
+          RasterizePolygon(static_cast<const GPUBackendDrawPolygonCommand*>(cmd), area, header->texture);
+          break;
+
+        case GPUBackendCommandType::DrawRectangle:
+          RasterizeRectangle(static_cast<const GPUBackendDrawRectangleCommand*>(cmd), area, header->texture);
+          break;
+
+        case GPUBackendCommandType::DrawLine:
+          RasterizeLine(static_cast<const GPUBackendDrawLineCommand*>(cmd), area);
+          break;
+
+        default:
+          UnreachableCode();
+          break;
+      }
+    }
+
+    bt.read_ptr.store(read_ptr);
+    last_command_time = Common::Timer::GetValue();
+
+    if (m_band_threads_idle_wait.load())
+    {
+      std::unique_lock<std::mutex> lock(m_band_mutex);
+      m_band_idle_cv.notify_one();
+    }
+  }
+}
+
+Common::Rectangle<u32> GPU_SW_Backend::GetBandDrawingArea(u32 index) const
+{
+  // bands are split evenly, so with few rows some of them can be empty (top > bottom)
+  const u32 height =
+    (m_drawing_area.bottom >= m_drawing_area.top) ? (m_drawing_area.bottom - m_drawing_area.top + 1) : 0;
+  Common::Rectangle<u32> area = m_drawing_area;
+  area.top = m_drawing_area.top + (height * index) / m_num_band_threads;
+  area.bottom = m_drawing_area.top + (height * (index + 1)) / m_num_band_threads - 1;
+  return area;
+}
+
+bool GPU_SW_Backend::IsTextureInDrawingArea(const GPUBackendDrawCommand* cmd) const
+{
+  return IsTextureInRectangle(cmd, Common::Rectangle<u32>(m_drawing_area.left, m_drawing_area.top,
+                                                          m_drawing_area.right + 1, m_drawing_area.bottom + 1));
+}
+
+bool GPU_SW_Backend::QueueBandCommand(const GPUBackendDrawCommand* cmd, s32 min_y, s32 max_y, bool textured,
+                                      const TextureCacheEntry* texture)
+{
+  if (textured && IsTextureInDrawingArea(cmd))
+  {
+    // Feedback, texels could be drawn by another band which hasn't got to them yet.
+    WaitForBandThreads();
+    return false;
+  }
+
+  // Vertices outside the 11-bit range wrap around, the primitive could end up anywhere in the drawing area.
+  const bool all_bands = (min_y < -1024 || max_y >= 1024);
+  u32 band_mask = 0;
+  for (u32 i = 0; i < m_num_band_threads; i++)
+  {
+    const Common::Rectangle<u32> area = GetBandDrawingArea(i);
+    const s32 band_top = static_cast<s32>(area.top);
+    const s32 band_bottom = static_cast<s32>(area.bottom);
+    if (band_top <= band_bottom && (all_bands || (max_y >= band_top && min_y <= band_bottom)))
+      band_mask |= 1u << i;
+  }
+
+  // nothing would be drawn
+  if (band_mask == 0)
+    return true;
+
+  const u32 size = Common::AlignUpPow2(static_cast<u32>(sizeof(BandCommandHeader)) + cmd->size, 8);
+  u32 write_ptr = m_band_write_ptr.load();
+  const u32 offset = write_ptr % BAND_COMMAND_BUFFER_SIZE;
+  const u32 padding = ((offset + size) > BAND_COMMAND_BUFFER_SIZE) ? (BAND_COMMAND_BUFFER_SIZE - offset) : 0;
+
+  // It's simpler to let all bands catch up than to track the space freed by each of them, and this is rare.
+  u32 used_size = 0;
+  for (u32 i = 0; i < m_num_band_threads; i++)
+    used_size = std::max<u32>(used_size, write_ptr - m_band_threads[i].read_ptr.load());
+  if ((used_size + padding + size) > BAND_COMMAND_BUFFER_SIZE)
+    WaitForBandThreads();
+
+  if (padding > 0)
+  {
+    BandCommandHeader* header = reinterpret_cast<BandCommandHeader*>(&m_band_command_buffer[offset]);
+    header->size = padding;
+    header->band_mask = 0;
+    header->texture = nullptr;
+    write_ptr += padding;
+  }
+
+  BandCommandHeader* header =
+    reinterpret_cast<BandCommandHeader*>(&m_band_command_buffer[write_ptr % BAND_COMMAND_BUFFER_SIZE]);
+  header->size = size;
+  header->band_mask = band_mask;
+  header->texture = texture;
+  std::memcpy(header + 1, cmd, cmd->size);
+  write_ptr += size;
+  m_band_write_ptr.store(write_ptr);
+
+  if ((write_ptr - m_band_wake_ptr) >= BAND_THRESHOLD_TO_WAKE)
+    WakeBandThreads();
+
+  return true;
+}
+
+bool GPU_SW_Backend::AreBandThreadsIdle() const
+{
+  const u32 write_ptr = m_band_write_ptr.load();
+  for (u32 i = 0; i < m_num_band_threads; i++)
+  {
+    if (m_band_threads[i].read_ptr.load() != write_ptr)
+      return false;
+  }
+
+  return true;
+}
+
+void GPU_SW_Backend::WakeBandThreads()
+{
+  m_band_wake_ptr = m_band_write_ptr.load();
+  if (m_band_threads_sleeping.load() == 0)
+    return;
+
+  std::unique_lock<std::mutex> lock(m_band_mutex);
+  m_band_wake_cv.notify_all();
+}
+
+void GPU_SW_Backend::WaitForBandThreads()
+{
+  if (m_num_band_threads == 0)
+    return;
+
+  WakeBandThreads();
+  if (!AreBandThreadsIdle())
+  {
+    m_band_threads_idle_wait.store(true);
+    {
+      std::unique_lock<std::mutex> lock(m_band_mutex);
+      m_band_idle_cv.wait(lock, [this]() { return AreBandThreadsIdle(); });
+    }
+    m_band_threads_idle_wait.store(false);
+  }
+
+  m_band_drain_generation++;
+}
+
+const GPU_SW_Backend::TextureCacheEntry* GPU_SW_Backend::GetTextureCacheEntry(const GPUBackendDrawCommand* cmd,
+                                                                           u32 min_u, u32 max_u, u32 min_v, u32 max_v,
+                                                                           u32 num_pixels)
+{
+  if (!cmd->draw_mode.IsUsingPalette() || IsTextureInDrawingArea(cmd))
+    return nullptr;
+
+  const u32 key = (ZeroExtend32(cmd->draw_mode.bits) & (GPUDrawModeReg::TEXTURE_PAGE_MASK | (3u << 7))) |
+                  (ZeroExtend32(cmd->palette.bits) << 16);
+
+  TextureCacheEntry* entry = nullptr;
+  TextureCacheEntry* oldest_entry = &m_texture_cache[0];
+  for (u32 i = 0; i < TEXTURE_CACHE_SIZE; i++)
+  {
+    TextureCacheEntry& it = m_texture_cache[i];
+    if (it.key == key)
+    {
+      entry = &it;
+      break;
+    }
+
+    if (it.last_used < oldest_entry->last_used)
+      oldest_entry = &it;
+  }
+
+  if (!entry)
+  {
+    // Primitives queued since the last drain could still be reading the entry we're replacing. That includes entries
+    // without any valid blocks, they'd pick up the blocks decoded for the new key.
+    entry = oldest_entry;
+    if (entry->drain_generation == m_band_drain_generation)
+      WaitForBandThreads();
+
+    entry->key = key;
+    entry->last_used = ++m_texture_cache_counter;
+    entry->decode_budget = num_pixels;
+    entry->page_rect = cmd->draw_mode.GetTexturePageRectangle();
+    entry->palette_rect = GetPaletteRectangle(cmd);
+    for (std::atomic<u64>& bits : entry->valid_blocks)
+      bits.store(0, std::memory_order_relaxed);
+
+    // Don't decode anything until the texture is used again, decoding textures which are only drawn once is slower
+    // than reading them straight from VRAM.
+    return nullptr;
+  }
+
+  entry->last_used = ++m_texture_cache_counter;
+  entry->drain_generation = m_band_drain_generation;
+  entry->decode_budget = std::min<u32>(entry->decode_budget + num_pixels, TEXTURE_PAGE_WIDTH * TEXTURE_PAGE_HEIGHT);
+
+  // The window is applied before the lookup, so it limits the texels which can be used.
+  if (cmd->window.and_x != 0xFF || cmd->window.or_x != 0)
+  {
+    min_u = cmd->window.or_x;
+    max_u = cmd->window.and_x | cmd->window.or_x;
+  }
+  if (cmd->window.and_y != 0xFF || cmd->window.or_y != 0)
+  {
+    min_v = cmd->window.or_y;
+    max_v = cmd->window.and_y | cmd->window.or_y;
+  }
+
+  // Interpolated coordinates can fall slightly outside this range, but those texels are read from VRAM. Decoding a
+  // texel costs about as much as fetching it while drawing, so only decode one texel for every two pixels drawn with
+  // the page. Otherwise large primitives with pages which are frequently overwritten are slower than with no cache.
+  static constexpr u32 BLOCK_COST = 2u << (TextureCacheEntry::BLOCK_SHIFT * 2);
+  for (u32 block_y = (min_v >> TextureCacheEntry::BLOCK_SHIFT); block_y <= (max_v >> TextureCacheEntry::BLOCK_SHIFT);
+       block_y++)
+  {
+    for (u32 block_x = (min_u >> TextureCacheEntry::BLOCK_SHIFT);
+         block_x <= (max_u >> TextureCacheEntry::BLOCK_SHIFT); block_x++)
+    {
+      const u32 block = block_y * TextureCacheEntry::BLOCKS_PER_ROW + block_x;
+      if (entry->IsBlockValid(block))
+        continue;
+      if (entry->decode_budget < BLOCK_COST)
+        return entry;
+
+      DecodeTextureCacheBlock(entry, cmd, block);
+      entry->decode_budget -= BLOCK_COST;
+    }
+  }
+
+  return entry;
+}
+
+void GPU_SW_Backend::DecodeTextureCacheBlock(TextureCacheEntry* entry, const GPUBackendDrawCommand* cmd, u32 block)
+{
+  static constexpr u32 BLOCK_SIZE = 1u << TextureCacheEntry::BLOCK_SHIFT;
+  const u32 start_x = (block % TextureCacheEntry::BLOCKS_PER_ROW) * BLOCK_SIZE;
+  const u32 start_y = (block / TextureCacheEntry::BLOCKS_PER_ROW) * BLOCK_SIZE;
+  for (u32 y = start_y; y < (start_y + BLOCK_SIZE); y++)
+  {
+    u16* dst_ptr = &entry->texels[y * TEXTURE_PAGE_WIDTH + start_x];
+    for (u32 x = start_x; x < (start_x + BLOCK_SIZE); x++)
+      *(dst_ptr++) = FetchTexel(m_vram.data(), cmd, Truncate8(x), Truncate8(y));
+  }
+
+  // publish the texels to the band threads
+  std::atomic<u64>& bits = entry->valid_blocks[block / 64];
+  bits.store(bits.load(std::memory_order_relaxed) | (u64(1) << (block % 64)), std::memory_order_release);
+}
+
+void GPU_SW_Backend::InvalidateTextureCache(u32 x, u32 y, u32 width, u32 height)
+{
+  const auto invalidate = [this](const Common::Rectangle<u32>& rect) {
+    for (u32 i = 0; i < TEXTURE_CACHE_SIZE; i++)
+    {
+      TextureCacheEntry& entry = m_texture_cache[i];
+      if (entry.key != INVALID_TEXTURE_CACHE_KEY && (TextureRectangleIntersects(entry.page_rect, rect) ||
+                                                     TextureRectangleIntersects(entry.palette_rect, rect)))
+      {
+        entry.decode_budget = 0;
+        for (std::atomic<u64>& bits : entry.valid_blocks)
+          bits.store(0, std::memory_order_relaxed);
+      }
+    }
+  };
+
+  // the area wraps around the edges of VRAM
+  const u32 right = x + width;
+  const u32 bottom = y + height;
+  invalidate(Common::Rectangle<u32>(x, y, std::min<u32>(right, VRAM_WIDTH), std::min<u32>(bottom, VRAM_HEIGHT)));
+  if (right > VRAM_WIDTH)
+    invalidate(Common::Rectangle<u32>(0, y, right - VRAM_WIDTH, std::min<u32>(bottom, VRAM_HEIGHT)));
+  if (bottom > VRAM_HEIGHT)
+    invalidate(Common::Rectangle<u32>(x, 0, std::min<u32>(right, VRAM_WIDTH), bottom - VRAM_HEIGHT));
+  if (right > VRAM_WIDTH && bottom > VRAM_HEIGHT)
+    invalidate(Common::Rectangle<u32>(0, 0, right - VRAM_WIDTH, bottom - VRAM_HEIGHT));
+}
 
-void GPU_SW_Backend::DrawingAreaChanged() {}
+void GPU_SW_Backend::InvalidateTextureCache()
+{
+  m_texture_cache_counter = 0;
+  for (u32 i = 0; i < TEXTURE_CACHE_SIZE; i++)
+  {
+    TextureCacheEntry& entry = m_texture_cache[i];
+    entry.key = INVALID_TEXTURE_CACHE_KEY;
+    entry.last_used = 0;
+    entry.decode_budget = 0;
+    for (std::atomic<u64>& bits : entry.valid_blocks)
+      bits.store(0, std::memory_order_relaxed);
+  }
+}
 
 GPU_SW_Backend::DrawLineFunction GPU_SW_Backend::GetDrawLineFunction(bool shading_enable, bool transparency_enable,
                                                                      bool dithering_enable)
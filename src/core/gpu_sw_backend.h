@@ -11,18 +11,78 @@ public:
   ~GPU_SW_Backend() override;
 
   bool Initialize(bool force_thread) override;
+  void UpdateSettings() override;
   void Reset(bool clear_vram) override;
+  void Shutdown() override;
 
   ALWAYS_INLINE_RELEASE u16 GetPixel(const u32 x, const u32 y) const { return m_vram[VRAM_WIDTH * y + x]; }
   ALWAYS_INLINE_RELEASE const u16* GetPixelPtr(const u32 x, const u32 y) const { return &m_vram[VRAM_WIDTH * y + x]; }
   ALWAYS_INLINE_RELEASE u16* GetPixelPtr(const u32 x, const u32 y) { return &m_vram[VRAM_WIDTH * y + x]; }
   ALWAYS_INLINE_RELEASE void SetPixel(const u32 x, const u32 y, const u16 value) { m_vram[VRAM_WIDTH * y + x] = value; }
 
+  /// Written areas of VRAM are tracked per row, as a mask of the 64 pixel wide columns which have been written.
+  static constexpr u32 DIRTY_VRAM_COLUMN_SHIFT = 6;
+  using DirtyVRAMRows = std::array<u16, VRAM_HEIGHT>;
+
+  /// Returns the areas of VRAM written since the last clear. Only valid while the backend is idle, i.e. after Sync().
+  ALWAYS_INLINE const DirtyVRAMRows& GetDirtyVRAMRows() const { return m_dirty_vram_rows; }
+  ALWAYS_INLINE void ClearDirtyVRAMRows() { m_dirty_vram_rows.fill(0); }
+
+  /// Returns the column mask covering [x, x + width), which can wrap around the right edge of VRAM.
+  static constexpr u16 GetDirtyVRAMColumnMask(u32 x, u32 width)
+  {
+    if (width == 0)
+      return 0;
+    if (width >= VRAM_WIDTH)
+      return 0xFFFF;
+
+    const u32 start = x % VRAM_WIDTH;
+    const u32 end = start + width - 1;
+    const u32 first_column = start >> DIRTY_VRAM_COLUMN_SHIFT;
+    const u32 last_column = (end % VRAM_WIDTH) >> DIRTY_VRAM_COLUMN_SHIFT;
+    if (end < VRAM_WIDTH)
+      return static_cast<u16>((2u << last_column) - (1u << first_column));
+    else if (last_column >= first_column)
+      return 0xFFFF;
+    else
+      return static_cast<u16>(((2u << last_column) - 1u) | (0x10000u - (1u << first_column)));
+  }
+
   // this is actually (31 * 255) >> 4) == 494, but to simplify addressing we use the next power of two (512)
   static constexpr u32 DITHER_LUT_SIZE = 512;
   using DitherLUT = std::array<std::array<std::array<u8, 512>, DITHER_MATRIX_SIZE>, DITHER_MATRIX_SIZE>;
   static constexpr DitherLUT ComputeDitherLUT();
 
+  /// Texture page decoded from 4/8-bit palette indices to 16-bit texels, for one palette. Blocks of 16x16 texels are
+  /// decoded once the page is reused, texels in blocks which haven't been decoded yet are fetched from VRAM instead.
+  struct TextureCacheEntry
+  {
+    static constexpr u32 BLOCK_SHIFT = 4;
+    static constexpr u32 BLOCKS_PER_ROW = TEXTURE_PAGE_WIDTH >> BLOCK_SHIFT;
+    static constexpr u32 NUM_BLOCKS = BLOCKS_PER_ROW * (TEXTURE_PAGE_HEIGHT >> BLOCK_SHIFT);
+
+    u32 key;           // texture page, mode and palette, INVALID_TEXTURE_CACHE_KEY when unused
+    u32 last_used;     // for picking an entry to replace
+    u32 decode_budget; // pixels drawn with the page since it was last invalidated, less the cost of decoded blocks
+    u32 drain_generation; // m_band_drain_generation when last handed out, queued primitives may still reference it
+    Common::Rectangle<u32> page_rect;
+    Common::Rectangle<u32> palette_rect;
+
+    // Only the thread which queues primitives decodes blocks, band threads can read them as soon as they're marked.
+    std::array<std::atomic<u64>, NUM_BLOCKS / 64> valid_blocks;
+    std::array<u16, TEXTURE_PAGE_WIDTH * TEXTURE_PAGE_HEIGHT> texels;
+
+    ALWAYS_INLINE static u32 GetBlockIndex(u32 texcoord_x, u32 texcoord_y)
+    {
+      return (texcoord_y >> BLOCK_SHIFT) * BLOCKS_PER_ROW + (texcoord_x >> BLOCK_SHIFT);
+    }
+
+    ALWAYS_INLINE bool IsBlockValid(u32 block) const
+    {
+      return (valid_blocks[block / 64].load(std::memory_order_acquire) & (u64(1) << (block % 64))) != 0;
+    }
+  };
+
 protected:
   union VRAMPixel
   {
@@ -95,17 +155,95 @@ protected:
   void FlushRender() override;
   void DrawingAreaChanged() override;
 
+  //////////////////////////////////////////////////////////////////////////
+  // Band-parallel rendering
+  //////////////////////////////////////////////////////////////////////////
+  enum : u32
+  {
+    MAX_BAND_THREADS = 32,
+    BAND_COMMAND_BUFFER_SIZE = 4 * 1024 * 1024,
+    BAND_THRESHOLD_TO_WAKE = 1024
+  };
+
+  struct BandCommandHeader
+  {
+    u32 size;      // including the header, padding at the end of the buffer has no bands set
+    u32 band_mask; // bands which the primitive touches
+    const TextureCacheEntry* texture;
+  };
+
+  struct alignas(64) BandThread
+  {
+    std::thread thread;
+    std::atomic<u32> read_ptr{0};
+  };
+
+  void StartBandThreads(u32 count);
+  void StopBandThreads();
+  void BandThreadMain(u32 index);
+
+  /// Returns the part of the drawing area which is owned by the specified band.
+  Common::Rectangle<u32> GetBandDrawingArea(u32 index) const;
+
+  /// Returns true if the primitive samples from the drawing area, so it has to be drawn in order with all bands.
+  bool IsTextureInDrawingArea(const GPUBackendDrawCommand* cmd) const;
+
+  /// Queues the primitive to the bands which overlap the specified rows. Returns false if it must be drawn immediately.
+  bool QueueBandCommand(const GPUBackendDrawCommand* cmd, s32 min_y, s32 max_y, bool textured,
+                        const TextureCacheEntry* texture);
+
+  /// Waits for all bands to finish drawing queued primitives.
+  void WaitForBandThreads();
+  bool AreBandThreadsIdle() const;
+  void WakeBandThreads();
+
+  void RasterizePolygon(const GPUBackendDrawPolygonCommand* cmd, const Common::Rectangle<u32>& area,
+                        const TextureCacheEntry* texture);
+  void RasterizeRectangle(const GPUBackendDrawRectangleCommand* cmd, const Common::Rectangle<u32>& area,
+                          const TextureCacheEntry* texture);
+  void RasterizeLine(const GPUBackendDrawLineCommand* cmd, const Common::Rectangle<u32>& area);
+
+  /// Marks the area as written, wrapping around the edges of VRAM.
+  void MarkVRAMDirty(u32 x, u32 y, u32 width, u32 height);
+
+  /// Marks the part of the rectangle which is inside the drawing area as written, the bounds are inclusive. Returns the
+  /// number of pixels marked.
+  u32 MarkDrawingAreaDirty(s32 left, s32 top, s32 right, s32 bottom);
+
+  //////////////////////////////////////////////////////////////////////////
+  // Decoded texture page cache
+  //////////////////////////////////////////////////////////////////////////
+  enum : u32
+  {
+    TEXTURE_CACHE_SIZE = 16,
+    INVALID_TEXTURE_CACHE_KEY = 0xFFFFFFFFu
+  };
+
+  /// Returns the decoded texture page for the primitive, decoding blocks covering the texture coordinate range as long
+  /// as enough has been drawn with the page to pay for them. Returns null if the primitive isn't using a palette, the
+  /// texture could be drawn to, or this is the first time the page has been used.
+  const TextureCacheEntry* GetTextureCacheEntry(const GPUBackendDrawCommand* cmd, u32 min_u, u32 max_u, u32 min_v,
+                                                u32 max_v, u32 num_pixels);
+  void DecodeTextureCacheBlock(TextureCacheEntry* entry, const GPUBackendDrawCommand* cmd, u32 block);
+
+  /// Drops decoded blocks which depend on the specified area of VRAM. The area can wrap around.
+  void InvalidateTextureCache(u32 x, u32 y, u32 width, u32 height);
+  void InvalidateTextureCache();
+
   //////////////////////////////////////////////////////////////////////////
   // Rasterization
   //////////////////////////////////////////////////////////////////////////
   template<bool texture_enable, bool raw_texture_enable, bool transparency_enable, bool dithering_enable>
-  void ShadePixel(const GPUBackendDrawCommand* cmd, u32 x, u32 y, u8 color_r, u8 color_g, u8 color_b, u8 texcoord_x,
-                  u8 texcoord_y);
+  void ShadePixel(const GPUBackendDrawCommand* cmd, const TextureCacheEntry* texture, u32 x, u32 y, u8 color_r,
+                  u8 color_g, u8 color_b, u8 texcoord_x, u8 texcoord_y);
 
   template<bool texture_enable, bool raw_texture_enable, bool transparency_enable>
-  void DrawRectangle(const GPUBackendDrawRectangleCommand* cmd);
+  void DrawRectangle(const GPUBackendDrawRectangleCommand* cmd, const Common::Rectangle<u32>& area,
+                     const TextureCacheEntry* texture);
 
-  using DrawRectangleFunction = void (GPU_SW_Backend::*)(const GPUBackendDrawRectangleCommand* cmd);
+  using DrawRectangleFunction = void (GPU_SW_Backend::*)(const GPUBackendDrawRectangleCommand* cmd,
+                                                         const Common::Rectangle<u32>& area,
+                                                         const TextureCacheEntry* texture);
   DrawRectangleFunction GetDrawRectangleFunction(bool texture_enable, bool raw_texture_enable,
                                                  bool transparency_enable);
 
@@ -139,15 +277,18 @@ protected:
 
   template<bool shading_enable, bool texture_enable, bool raw_texture_enable, bool transparency_enable,
            bool dithering_enable>
-  void DrawSpan(const GPUBackendDrawPolygonCommand* cmd, s32 y, s32 x_start, s32 x_bound, i_group ig,
-                const i_deltas& idl);
+  void DrawSpan(const GPUBackendDrawPolygonCommand* cmd, const Common::Rectangle<u32>& area,
+                const TextureCacheEntry* texture, s32 y, s32 x_start, s32 x_bound, i_group ig, const i_deltas& idl);
 
   template<bool shading_enable, bool texture_enable, bool raw_texture_enable, bool transparency_enable,
            bool dithering_enable>
-  void DrawTriangle(const GPUBackendDrawPolygonCommand* cmd, const GPUBackendDrawPolygonCommand::Vertex* v0,
+  void DrawTriangle(const GPUBackendDrawPolygonCommand* cmd, const Common::Rectangle<u32>& area,
+                    const TextureCacheEntry* texture, const GPUBackendDrawPolygonCommand::Vertex* v0,
                     const GPUBackendDrawPolygonCommand::Vertex* v1, const GPUBackendDrawPolygonCommand::Vertex* v2);
 
   using DrawTriangleFunction = void (GPU_SW_Backend::*)(const GPUBackendDrawPolygonCommand* cmd,
+                                                        const Common::Rectangle<u32>& area,
+                                                        const TextureCacheEntry* texture,
                                                         const GPUBackendDrawPolygonCommand::Vertex* v0,
                                                         const GPUBackendDrawPolygonCommand::Vertex* v1,
                                                         const GPUBackendDrawPolygonCommand::Vertex* v2);
@@ -155,13 +296,35 @@ protected:
                                                bool transparency_enable, bool dithering_enable);
 
   template<bool shading_enable, bool transparency_enable, bool dithering_enable>
-  void DrawLine(const GPUBackendDrawLineCommand* cmd, const GPUBackendDrawLineCommand::Vertex* p0,
-                const GPUBackendDrawLineCommand::Vertex* p1);
+  void DrawLine(const GPUBackendDrawLineCommand* cmd, const Common::Rectangle<u32>& area,
+                const GPUBackendDrawLineCommand::Vertex* p0, const GPUBackendDrawLineCommand::Vertex* p1);
 
   using DrawLineFunction = void (GPU_SW_Backend::*)(const GPUBackendDrawLineCommand* cmd,
+                                                    const Common::Rectangle<u32>& area,
                                                     const GPUBackendDrawLineCommand::Vertex* p0,
                                                     const GPUBackendDrawLineCommand::Vertex* p1);
   DrawLineFunction GetDrawLineFunction(bool shading_enable, bool transparency_enable, bool dithering_enable);
 
   std::array<u16, VRAM_WIDTH * VRAM_HEIGHT> m_vram;
+
+  std::unique_ptr<TextureCacheEntry[]> m_texture_cache;
+  u32 m_texture_cache_counter = 0;
+
+  DirtyVRAMRows m_dirty_vram_rows = {};
+
+  // Primitives are copied to a buffer which is read by every band thread, each thread draws the part of the primitive
+  // which falls in its band of the drawing area. Anything else waits for the bands to finish, and runs on this thread.
+  std::unique_ptr<BandThread[]> m_band_threads;
+  u32 m_num_band_threads = 0;
+  std::vector<u8> m_band_command_buffer;
+  std::atomic<u32> m_band_write_ptr{0};
+  u32 m_band_wake_ptr = 0;
+  u32 m_band_drain_generation = 0; // incremented each time the band threads have been waited for
+
+  std::mutex m_band_mutex;
+  std::condition_variable m_band_wake_cv;
+  std::condition_variable m_band_idle_cv;
+  std::atomic<u32> m_band_threads_sleeping{0};
+  std::atomic_bool m_band_threads_idle_wait{false};
+  std::atomic_bool m_band_threads_done{false};
 };
@@ -10,6 +10,10 @@ void Reset();
 bool DoState(StateWrapper& sw);
 void UpdateAspectRatio();
 
+// The recompiler only emits RTPS/RTPT inline when the projection isn't scaled for the aspect ratio.
+bool IsProjectionScaled();
+const u8* GetUNRTable();
+
 // control registers are offset by +32
 u32 ReadRegister(u32 index);
 void WriteRegister(u32 index, u32 value);
@@ -513,6 +513,17 @@ void HostInterface::SetDefaultSettings(SettingsInterface& si)
   si.SetBoolValue("CPU", "RecompilerMemoryExceptions", false);
   si.SetBoolValue("CPU", "RecompilerBlockLinking", true);
   si.SetBoolValue("CPU", "ICache", false);
+  si.SetBoolValue("CPU", "RecompilerBlockPrewarm", false);
+  si.SetIntValue("CPU", "RecompilerPromotionThreshold", 0);
+  si.SetBoolValue("CPU", "RecompilerSuperblocks", false);
+  si.SetBoolValue("CPU", "RecompilerOptimizeBlocks", false);
+  si.SetBoolValue("CPU", "RecompilerAsyncCompile", false);
+  si.SetBoolValue("CPU", "RecompilerInlineGTE", false);
+  si.SetBoolValue("CPU", "RecompilerPinnedRegisters", false);
+  si.SetBoolValue("CPU", "RecompilerLazyDowncount", false);
+  si.SetBoolValue("CPU", "RecompilerPerfMap", false);
+  si.SetBoolValue("CPU", "IdleLoopSkipping", false);
+  si.SetBoolValue("CPU", "CachedInterpreterPredecode", false);
   si.SetBoolValue("CPU", "FastmemMode", Settings::GetCPUFastmemModeName(Settings::DEFAULT_CPU_FASTMEM_MODE));
 
   si.SetStringValue("GPU", "Renderer", Settings::GetRendererName(Settings::DEFAULT_GPU_RENDERER));
@@ -522,6 +533,7 @@ void HostInterface::SetDefaultSettings(SettingsInterface& si)
   si.SetBoolValue("GPU", "UseSoftwareRendererForReadbacks", false);
   si.SetBoolValue("GPU", "PerSampleShading", false);
   si.SetBoolValue("GPU", "UseThread", true);
+  si.SetIntValue("GPU", "SoftwareRenderThreads", 0);
   si.SetBoolValue("GPU", "ThreadedPresentation", true);
   si.SetBoolValue("GPU", "TrueColor", false);
   si.SetBoolValue("GPU", "ScaledDithering", true);
@@ -786,7 +798,14 @@ void HostInterface::CheckForSettingsChanges(const Settings& old_settings)
     if (g_settings.cpu_execution_mode == CPUExecutionMode::Recompiler &&
         (g_settings.cpu_recompiler_memory_exceptions != old_settings.cpu_recompiler_memory_exceptions ||
          g_settings.cpu_recompiler_block_linking != old_settings.cpu_recompiler_block_linking ||
-         g_settings.cpu_recompiler_icache != old_settings.cpu_recompiler_icache))
+         g_settings.cpu_recompiler_icache != old_settings.cpu_recompiler_icache ||
+         g_settings.cpu_recompiler_promotion_threshold != old_settings.cpu_recompiler_promotion_threshold ||
+         g_settings.cpu_recompiler_superblocks != old_settings.cpu_recompiler_superblocks ||
+         g_settings.cpu_recompiler_optimize_blocks != old_settings.cpu_recompiler_optimize_blocks ||
+         g_settings.cpu_recompiler_async_compile != old_settings.cpu_recompiler_async_compile ||
+         g_settings.cpu_recompiler_inline_gte != old_settings.cpu_recompiler_inline_gte ||
+         g_settings.cpu_recompiler_pinned_registers != old_settings.cpu_recompiler_pinned_registers ||
+         g_settings.cpu_recompiler_lazy_downcount != old_settings.cpu_recompiler_lazy_downcount))
     {
       AddOSDMessage(TranslateStdString("OSDMessage", "Recompiler options changed, flushing all blocks."), 5.0f);
       CPU::CodeCache::Flush();
@@ -794,6 +813,18 @@ void HostInterface::CheckForSettingsChanges(const Settings& old_settings)
       if (g_settings.cpu_recompiler_icache != old_settings.cpu_recompiler_icache)
         CPU::ClearICache();
     }
+    else if (g_settings.cpu_execution_mode != CPUExecutionMode::Interpreter &&
+             (g_settings.cpu_idle_loop_skipping != old_settings.cpu_idle_loop_skipping ||
+              g_settings.cpu_cached_interpreter_predecode != old_settings.cpu_cached_interpreter_predecode))
+    {
+      // Idle loops are detected and instructions predecoded when blocks are compiled.
+      CPU::CodeCache::Flush();
+    }
+
+#ifdef WITH_RECOMPILER
+    if (old_settings.cpu_recompiler_block_prewarm && !g_settings.cpu_recompiler_block_prewarm)
+      CPU::CodeCache::SavePrewarmList();
+#endif
 
     m_audio_stream->SetOutputVolume(GetAudioOutputVolume());
 
@@ -801,6 +832,7 @@ void HostInterface::CheckForSettingsChanges(const Settings& old_settings)
         g_settings.gpu_multisamples != old_settings.gpu_multisamples ||
         g_settings.gpu_per_sample_shading != old_settings.gpu_per_sample_shading ||
         g_settings.gpu_use_thread != old_settings.gpu_use_thread ||
+        g_settings.gpu_sw_render_threads != old_settings.gpu_sw_render_threads ||
         g_settings.gpu_use_software_renderer_for_readbacks != old_settings.gpu_use_software_renderer_for_readbacks ||
         g_settings.gpu_fifo_size != old_settings.gpu_fifo_size ||
         g_settings.gpu_max_run_ahead != old_settings.gpu_max_run_ahead ||
@@ -833,6 +865,10 @@ void HostInterface::CheckForSettingsChanges(const Settings& old_settings)
           g_settings.display_aspect_ratio_custom_denominator != old_settings.display_aspect_ratio_custom_denominator)))
     {
       GTE::UpdateAspectRatio();
+
+      // Inline RTPS/RTPT is only emitted for unscaled projections.
+      if (g_settings.IsUsingRecompiler() && g_settings.cpu_recompiler_inline_gte)
+        CPU::CodeCache::Flush();
     }
 
     if (g_settings.gpu_pgxp_enable != old_settings.gpu_pgxp_enable ||
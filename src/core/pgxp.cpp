@@ -23,7 +23,9 @@
 #include "common/log.h"
 #include "cpu_core.h"
 #include "settings.h"
+#include <array>
 #include <climits>
+#include <cstddef>
 #include <cmath>
 Log_SetChannel(PGXP);
 
@@ -34,9 +36,17 @@ enum : u32
   VERTEX_CACHE_WIDTH = 0x800 * 2,
   VERTEX_CACHE_HEIGHT = 0x800 * 2,
   VERTEX_CACHE_SIZE = VERTEX_CACHE_WIDTH * VERTEX_CACHE_HEIGHT,
-  PGXP_MEM_SIZE = (Bus::RAM_8MB_SIZE + CPU::DCACHE_SIZE) / 4,
-  PGXP_MEM_SCRATCH_OFFSET = Bus::RAM_8MB_SIZE / 4
+
+  // Shadow memory is allocated in pages on the first write of a value which carries precision data.
+  PGXP_MEM_PAGE_SHIFT = MEM_PAGE_SHIFT,
+  PGXP_MEM_PAGE_SIZE = 1u << PGXP_MEM_PAGE_SHIFT,
+  PGXP_MEM_PAGE_OFFSET_MASK = PGXP_MEM_PAGE_SIZE - 1,
+  PGXP_MEM_PAGE_WORDS = PGXP_MEM_PAGE_SIZE / 4,
+  PGXP_MEM_SCRATCH_PAGE = Bus::RAM_8MB_SIZE / PGXP_MEM_PAGE_SIZE,
+  PGXP_MEM_PAGE_COUNT = PGXP_MEM_SCRATCH_PAGE + 1
 };
+static_assert(static_cast<u32>(CPU::DCACHE_SIZE) <= static_cast<u32>(PGXP_MEM_PAGE_SIZE),
+              "scratchpad fits in one shadow page");
 
 #define NONE 0
 #define ALL 0xFFFFFFFF
@@ -64,6 +74,26 @@ typedef struct PGXP_value_Tag
   unsigned int value;
 } PGXP_value;
 
+// Compact form of PGXP_value used for shadow memory. The component flags only use the low bit of each byte, so they
+// are packed into the low mantissa bits of z, which keeps entries at 16 bytes instead of 20.
+struct PGXP_mem_value
+{
+  float x;
+  float y;
+  u32 z_and_flags;
+  u32 value;
+};
+
+#define MEM_FLAGS_MASK 0xFu
+
+static_assert(sizeof(PGXP_value) == CPU_REG_SIZE && offsetof(PGXP_value, flags) == CPU_REG_FLAGS_OFFSET &&
+                offsetof(PGXP_value, value) == CPU_REG_VALUE_OFFSET,
+              "PGXP register layout matches recompiler constants");
+static_assert(sizeof(PGXP_mem_value) == MEM_VALUE_SIZE &&
+                offsetof(PGXP_mem_value, z_and_flags) == MEM_Z_AND_FLAGS_OFFSET &&
+                offsetof(PGXP_mem_value, value) == MEM_VALUE_OFFSET && MEM_FLAGS_MASK == MEM_FLAGS_BITS,
+              "PGXP memory layout matches recompiler constants");
+
 typedef union
 {
   struct
@@ -96,8 +126,14 @@ static double f16Sign(double in);
 static double f16Unsign(double in);
 static double f16Overflow(double in);
 
-static PGXP_value* GetPtr(u32 addr);
-static PGXP_value* ReadMem(u32 addr);
+static bool HasShadowMemory(u32 addr);
+static PGXP_mem_value* GetPtr(u32 addr, bool allocate);
+static PGXP_mem_value* AllocateMemPage(u32 page);
+static u32 PackMemFlags(u32 flags);
+static u32 UnpackMemFlags(u32 z_and_flags);
+static PGXP_value DecodeMem(const PGXP_mem_value& mem);
+static void EncodeMem(PGXP_mem_value* mem, const PGXP_value& value);
+static void FreeMem();
 
 static const PGXP_value PGXP_value_invalid = {0.f, 0.f, 0.f, {0}, 0};
 static const PGXP_value PGXP_value_zero = {0.f, 0.f, 0.f, {VALID_ALL}, 0};
@@ -111,7 +147,18 @@ static PGXP_value CP0_reg[32];
 static PGXP_value GTE_data_reg[32];
 static PGXP_value GTE_ctrl_reg[32];
 
-static PGXP_value* Mem = nullptr;
+static std::array<PGXP_mem_value*, PGXP_MEM_PAGE_COUNT> s_mem_pages = {};
+static u32 s_mem_pages_allocated = 0;
+
+void* GetCPURegisterPointer(u32 index)
+{
+  return &CPU_reg[index];
+}
+
+void* const* GetMemPageTable()
+{
+  return reinterpret_cast<void* const*>(s_mem_pages.data());
+}
 static PGXP_value* vertexCache = nullptr;
 
 ALWAYS_INLINE_RELEASE void MakeValid(PGXP_value* pV, u32 psxV)
@@ -155,30 +202,120 @@ ALWAYS_INLINE_RELEASE double f16Overflow(double in)
   return out;
 }
 
-ALWAYS_INLINE_RELEASE PGXP_value* GetPtr(u32 addr)
+ALWAYS_INLINE_RELEASE u32 PackMemFlags(u32 flags)
 {
-  if ((addr & CPU::DCACHE_LOCATION_MASK) == CPU::DCACHE_LOCATION)
-    return &Mem[PGXP_MEM_SCRATCH_OFFSET + ((addr & CPU::DCACHE_OFFSET_MASK) >> 2)];
+  return (flags & VALID_0) | ((flags & VALID_1) >> 7) | ((flags & VALID_2) >> 14) | ((flags & VALID_3) >> 21);
+}
 
-  const u32 paddr = (addr & CPU::PHYSICAL_MEMORY_ADDRESS_MASK);
-  if (paddr < Bus::RAM_MIRROR_END)
-    return &Mem[(paddr & Bus::g_ram_mask) >> 2];
-  else
-    return nullptr;
+ALWAYS_INLINE_RELEASE u32 UnpackMemFlags(u32 z_and_flags)
+{
+  return (z_and_flags & 1u) | ((z_and_flags & 2u) << 7) | ((z_and_flags & 4u) << 14) | ((z_and_flags & 8u) << 21);
+}
+
+ALWAYS_INLINE_RELEASE PGXP_value DecodeMem(const PGXP_mem_value& mem)
+{
+  PGXP_value ret;
+  ret.x = mem.x;
+  ret.y = mem.y;
+
+  const u32 z_bits = mem.z_and_flags & ~MEM_FLAGS_MASK;
+  std::memcpy(&ret.z, &z_bits, sizeof(ret.z));
+
+  ret.flags = UnpackMemFlags(mem.z_and_flags);
+  ret.value = mem.value;
+  return ret;
+}
+
+ALWAYS_INLINE_RELEASE void EncodeMem(PGXP_mem_value* mem, const PGXP_value& value)
+{
+  u32 z_bits;
+  std::memcpy(&z_bits, &value.z, sizeof(z_bits));
+
+  mem->x = value.x;
+  mem->y = value.y;
+  mem->z_and_flags = (z_bits & ~MEM_FLAGS_MASK) | PackMemFlags(value.flags);
+  mem->value = value.value;
+}
+
+PGXP_mem_value* AllocateMemPage(u32 page)
+{
+  PGXP_mem_value* ptr = static_cast<PGXP_mem_value*>(std::calloc(PGXP_MEM_PAGE_WORDS, sizeof(PGXP_mem_value)));
+  if (!ptr)
+  {
+    std::fprintf(stderr, "Failed to allocate PGXP memory\n");
+    std::abort();
+  }
+
+  s_mem_pages[page] = ptr;
+  s_mem_pages_allocated++;
+  return ptr;
+}
+
+void FreeMem()
+{
+  if (s_mem_pages_allocated > 0)
+  {
+    Log_DevPrintf("Freeing %u PGXP memory pages (%u KB)", s_mem_pages_allocated,
+                  (s_mem_pages_allocated * PGXP_MEM_PAGE_WORDS * static_cast<u32>(sizeof(PGXP_mem_value))) / 1024u);
+  }
+
+  for (PGXP_mem_value*& page : s_mem_pages)
+  {
+    std::free(page);
+    page = nullptr;
+  }
+  s_mem_pages_allocated = 0;
 }
 
-ALWAYS_INLINE_RELEASE PGXP_value* ReadMem(u32 addr)
+ALWAYS_INLINE_RELEASE bool HasShadowMemory(u32 addr)
 {
-  return GetPtr(addr);
+  return ((addr & CPU::DCACHE_LOCATION_MASK) == CPU::DCACHE_LOCATION ||
+          (addr & CPU::PHYSICAL_MEMORY_ADDRESS_MASK) < Bus::RAM_MIRROR_END);
+}
+
+ALWAYS_INLINE_RELEASE PGXP_mem_value* GetPtr(u32 addr, bool allocate)
+{
+  u32 page, word;
+  if ((addr & CPU::DCACHE_LOCATION_MASK) == CPU::DCACHE_LOCATION)
+  {
+    page = PGXP_MEM_SCRATCH_PAGE;
+    word = (addr & CPU::DCACHE_OFFSET_MASK) >> 2;
+  }
+  else
+  {
+    const u32 paddr = (addr & CPU::PHYSICAL_MEMORY_ADDRESS_MASK);
+    if (paddr >= Bus::RAM_MIRROR_END)
+      return nullptr;
+
+    const u32 offset = paddr & Bus::g_ram_mask;
+    page = offset >> PGXP_MEM_PAGE_SHIFT;
+    word = (offset & PGXP_MEM_PAGE_OFFSET_MASK) >> 2;
+  }
+
+  PGXP_mem_value* page_ptr = s_mem_pages[page];
+  if (!page_ptr)
+  {
+    // Pages which were never written with precision data behave as zeroed entries, which the callers handle.
+    if (!allocate)
+      return nullptr;
+
+    page_ptr = AllocateMemPage(page);
+  }
+
+  return &page_ptr[word];
 }
 
 ALWAYS_INLINE_RELEASE void ValidateAndCopyMem(PGXP_value* dest, u32 addr, u32 value)
 {
-  PGXP_value* pMem = GetPtr(addr);
+  // A zeroed entry decodes to PGXP_value_invalid, so unallocated pages don't need to be told apart here.
+  PGXP_mem_value* pMem = GetPtr(addr, false);
   if (pMem != NULL)
   {
-    Validate(pMem, value);
-    *dest = *pMem;
+    // invalidate all components if the value was changed behind our back
+    if (pMem->value != value)
+      pMem->z_and_flags &= ~MEM_FLAGS_MASK;
+
+    *dest = DecodeMem(*pMem);
     return;
   }
 
@@ -189,8 +326,8 @@ ALWAYS_INLINE_RELEASE static void ValidateAndCopyMem16(PGXP_value* dest, u32 add
 {
   u32 validMask = 0;
   psx_value val, mask;
-  PGXP_value* pMem = GetPtr(addr);
-  if (pMem != NULL)
+  PGXP_mem_value* pMem = GetPtr(addr, false);
+  if (pMem != NULL || HasShadowMemory(addr))
   {
     mask.d = val.d = 0;
     // determine if high or low word
@@ -207,9 +344,11 @@ ALWAYS_INLINE_RELEASE static void ValidateAndCopyMem16(PGXP_value* dest, u32 add
       validMask = VALID_0;
     }
 
-    // validate and copy whole value
-    MaskValidate(pMem, val.d, mask.d, validMask);
-    *dest = *pMem;
+    // validate and copy whole value, unallocated pages read as a zeroed entry
+    *dest = pMem ? DecodeMem(*pMem) : PGXP_value_invalid;
+    MaskValidate(dest, val.d, mask.d, validMask);
+    if (pMem)
+      pMem->z_and_flags = (pMem->z_and_flags & ~MEM_FLAGS_MASK) | PackMemFlags(dest->flags);
 
     // if high word then shift
     if ((addr % 4) == 2)
@@ -230,19 +369,22 @@ ALWAYS_INLINE_RELEASE static void ValidateAndCopyMem16(PGXP_value* dest, u32 add
 
 ALWAYS_INLINE_RELEASE void WriteMem(const PGXP_value* value, u32 addr)
 {
-  PGXP_value* pMem = GetPtr(addr);
+  // don't bother allocating shadow memory for values without any precision data
+  PGXP_mem_value* pMem = GetPtr(addr, (value->flags & VALID_ALL) != 0);
 
   if (pMem)
-    *pMem = *value;
+    EncodeMem(pMem, *value);
 }
 
 ALWAYS_INLINE_RELEASE static void WriteMem16(const PGXP_value* src, u32 addr)
 {
-  PGXP_value* dest = GetPtr(addr);
+  PGXP_mem_value* pMem = GetPtr(addr, (src->compFlags[0] == VALID || src->compFlags[2] == VALID));
   psx_value* pVal = NULL;
 
-  if (dest)
+  if (pMem)
   {
+    PGXP_value dest_value = DecodeMem(*pMem);
+    PGXP_value* dest = &dest_value;
     pVal = (psx_value*)&dest->value;
     // determine if high or low word
     if ((addr % 4) == 2)
@@ -266,6 +408,7 @@ ALWAYS_INLINE_RELEASE static void WriteMem16(const PGXP_value* src, u32 addr)
     }
 
     // dest->valid = dest->valid && src->valid;
+    EncodeMem(pMem, dest_value);
   }
 }
 
@@ -277,15 +420,7 @@ void Initialize()
   std::memset(GTE_data_reg, 0, sizeof(GTE_data_reg));
   std::memset(GTE_ctrl_reg, 0, sizeof(GTE_ctrl_reg));
 
-  if (!Mem)
-  {
-    Mem = static_cast<PGXP_value*>(std::calloc(PGXP_MEM_SIZE, sizeof(PGXP_value)));
-    if (!Mem)
-    {
-      std::fprintf(stderr, "Failed to allocate PGXP memory\n");
-      std::abort();
-    }
-  }
+  FreeMem();
 
   if (g_settings.gpu_pgxp_vertex_cache && !vertexCache)
   {
@@ -309,8 +444,7 @@ void Reset()
   std::memset(GTE_data_reg, 0, sizeof(GTE_data_reg));
   std::memset(GTE_ctrl_reg, 0, sizeof(GTE_ctrl_reg));
 
-  if (Mem)
-    std::memset(Mem, 0, sizeof(PGXP_value) * PGXP_MEM_SIZE);
+  FreeMem();
 
   if (vertexCache)
     std::memset(vertexCache, 0, sizeof(PGXP_value) * VERTEX_CACHE_SIZE);
@@ -323,11 +457,7 @@ void Shutdown()
     std::free(vertexCache);
     vertexCache = nullptr;
   }
-  if (Mem)
-  {
-    std::free(Mem);
-    Mem = nullptr;
-  }
+  FreeMem();
 
   std::memset(GTE_data_reg, 0, sizeof(GTE_data_reg));
   std::memset(GTE_ctrl_reg, 0, sizeof(GTE_ctrl_reg));
@@ -524,18 +654,19 @@ static ALWAYS_INLINE_RELEASE bool IsWithinTolerance(float precise_x, float preci
 
 bool GetPreciseVertex(u32 addr, u32 value, int x, int y, int xOffs, int yOffs, float* out_x, float* out_y, float* out_w)
 {
-  const PGXP_value* vert = ReadMem(addr);
-  if (vert && ((vert->flags & VALID_01) == VALID_01) && (vert->value == value))
+  const PGXP_mem_value* mem = GetPtr(addr, false);
+  if (mem && ((UnpackMemFlags(mem->z_and_flags) & VALID_01) == VALID_01) && (mem->value == value))
   {
     // There is a value here with valid X and Y coordinates
-    *out_x = TruncateVertexPosition(vert->x) + static_cast<float>(xOffs);
-    *out_y = TruncateVertexPosition(vert->y) + static_cast<float>(yOffs);
-    *out_w = vert->z / 32768.0f;
+    const PGXP_value mem_vert = DecodeMem(*mem);
+    *out_x = TruncateVertexPosition(mem_vert.x) + static_cast<float>(xOffs);
+    *out_y = TruncateVertexPosition(mem_vert.y) + static_cast<float>(yOffs);
+    *out_w = mem_vert.z / 32768.0f;
 
     if (IsWithinTolerance(*out_x, *out_y, x, y))
     {
       // check validity of z component
-      return ((vert->flags & VALID_2) == VALID_2);
+      return ((mem_vert.flags & VALID_2) == VALID_2);
     }
   }
 
@@ -545,7 +676,7 @@ bool GetPreciseVertex(u32 addr, u32 value, int x, int y, int xOffs, int yOffs, f
     const short psx_y = (short)(value >> 16);
 
     // Look in cache for valid vertex
-    vert = PGXP_GetCachedVertex(psx_x, psx_y);
+    const PGXP_value* vert = PGXP_GetCachedVertex(psx_x, psx_y);
     if (vert && (vert->flags & VALID_01) == VALID_01)
     {
       *out_x = TruncateVertexPosition(vert->x) + static_cast<float>(xOffs);
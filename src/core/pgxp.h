@@ -101,4 +101,29 @@ void CPU_MTLO(u32 instr, u32 rdVal);
 void CPU_MFC0(u32 instr, u32 rdVal);
 void CPU_MTC0(u32 instr, u32 rdVal, u32 rtVal);
 
+// -- Recompiler access
+// Shadow registers are {float x, y, z; u32 flags; u32 value}, with Hi and Lo after the GPRs. Shadow memory pages hold
+// {float x, y; u32 z_and_flags; u32 value}, where the low bits of z are the component flags of bytes 0-3 of flags.
+enum : u32
+{
+  CPU_REG_HI = 32,
+  CPU_REG_LO = 33,
+  CPU_REG_SIZE = 20,
+  CPU_REG_FLAGS_OFFSET = 12,
+  CPU_REG_VALUE_OFFSET = 16,
+  CPU_REG_VALID_MASK = 0x01010101,
+  CPU_REG_VALID_X = 0x00000001,
+  CPU_REG_VALID_Y = 0x00000100,
+  CPU_REG_VALID_XY = 0x00000101,
+
+  MEM_PAGE_SHIFT = 12,
+  MEM_VALUE_SIZE = 16,
+  MEM_Z_AND_FLAGS_OFFSET = 8,
+  MEM_VALUE_OFFSET = 12,
+  MEM_FLAGS_BITS = 0xF,
+};
+
+void* GetCPURegisterPointer(u32 index);
+void* const* GetMemPageTable();
+
 } // namespace PGXP
\ No newline at end of file
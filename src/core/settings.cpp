@@ -174,6 +174,18 @@ void Settings::Load(SettingsInterface& si)
   cpu_recompiler_memory_exceptions = si.GetBoolValue("CPU", "RecompilerMemoryExceptions", false);
   cpu_recompiler_block_linking = si.GetBoolValue("CPU", "RecompilerBlockLinking", true);
   cpu_recompiler_icache = si.GetBoolValue("CPU", "RecompilerICache", false);
+  cpu_recompiler_block_prewarm = si.GetBoolValue("CPU", "RecompilerBlockPrewarm", false);
+  cpu_recompiler_promotion_threshold =
+    static_cast<u32>(std::max(si.GetIntValue("CPU", "RecompilerPromotionThreshold", 0), 0));
+  cpu_recompiler_superblocks = si.GetBoolValue("CPU", "RecompilerSuperblocks", false);
+  cpu_recompiler_optimize_blocks = si.GetBoolValue("CPU", "RecompilerOptimizeBlocks", false);
+  cpu_recompiler_async_compile = si.GetBoolValue("CPU", "RecompilerAsyncCompile", false);
+  cpu_recompiler_inline_gte = si.GetBoolValue("CPU", "RecompilerInlineGTE", false);
+  cpu_recompiler_pinned_registers = si.GetBoolValue("CPU", "RecompilerPinnedRegisters", false);
+  cpu_recompiler_lazy_downcount = si.GetBoolValue("CPU", "RecompilerLazyDowncount", false);
+  cpu_recompiler_perf_map = si.GetBoolValue("CPU", "RecompilerPerfMap", false);
+  cpu_idle_loop_skipping = si.GetBoolValue("CPU", "IdleLoopSkipping", false);
+  cpu_cached_interpreter_predecode = si.GetBoolValue("CPU", "CachedInterpreterPredecode", false);
   cpu_fastmem_mode = ParseCPUFastmemMode(
                        si.GetStringValue("CPU", "FastmemMode", GetCPUFastmemModeName(DEFAULT_CPU_FASTMEM_MODE)).c_str())
                        .value_or(DEFAULT_CPU_FASTMEM_MODE);
@@ -186,6 +198,7 @@ void Settings::Load(SettingsInterface& si)
   gpu_use_debug_device = si.GetBoolValue("GPU", "UseDebugDevice", false);
   gpu_per_sample_shading = si.GetBoolValue("GPU", "PerSampleShading", false);
   gpu_use_thread = si.GetBoolValue("GPU", "UseThread", true);
+  gpu_sw_render_threads = static_cast<u32>(si.GetIntValue("GPU", "SoftwareRenderThreads", 0));
   gpu_use_software_renderer_for_readbacks = si.GetBoolValue("GPU", "UseSoftwareRendererForReadbacks", false);
   gpu_threaded_presentation = si.GetBoolValue("GPU", "ThreadedPresentation", true);
   gpu_true_color = si.GetBoolValue("GPU", "TrueColor", false);
@@ -368,6 +381,17 @@ void Settings::Save(SettingsInterface& si) const
   si.SetBoolValue("CPU", "RecompilerMemoryExceptions", cpu_recompiler_memory_exceptions);
   si.SetBoolValue("CPU", "RecompilerBlockLinking", cpu_recompiler_block_linking);
   si.SetBoolValue("CPU", "RecompilerICache", cpu_recompiler_icache);
+  si.SetBoolValue("CPU", "RecompilerBlockPrewarm", cpu_recompiler_block_prewarm);
+  si.SetIntValue("CPU", "RecompilerPromotionThreshold", cpu_recompiler_promotion_threshold);
+  si.SetBoolValue("CPU", "RecompilerSuperblocks", cpu_recompiler_superblocks);
+  si.SetBoolValue("CPU", "RecompilerOptimizeBlocks", cpu_recompiler_optimize_blocks);
+  si.SetBoolValue("CPU", "RecompilerAsyncCompile", cpu_recompiler_async_compile);
+  si.SetBoolValue("CPU", "RecompilerInlineGTE", cpu_recompiler_inline_gte);
+  si.SetBoolValue("CPU", "RecompilerPinnedRegisters", cpu_recompiler_pinned_registers);
+  si.SetBoolValue("CPU", "RecompilerLazyDowncount", cpu_recompiler_lazy_downcount);
+  si.SetBoolValue("CPU", "RecompilerPerfMap", cpu_recompiler_perf_map);
+  si.SetBoolValue("CPU", "IdleLoopSkipping", cpu_idle_loop_skipping);
+  si.SetBoolValue("CPU", "CachedInterpreterPredecode", cpu_cached_interpreter_predecode);
   si.SetStringValue("CPU", "FastmemMode", GetCPUFastmemModeName(cpu_fastmem_mode));
 
   si.SetStringValue("GPU", "Renderer", GetRendererName(gpu_renderer));
@@ -377,6 +401,7 @@ void Settings::Save(SettingsInterface& si) const
   si.SetBoolValue("GPU", "UseDebugDevice", gpu_use_debug_device);
   si.SetBoolValue("GPU", "PerSampleShading", gpu_per_sample_shading);
   si.SetBoolValue("GPU", "UseThread", gpu_use_thread);
+  si.SetIntValue("GPU", "SoftwareRenderThreads", gpu_sw_render_threads);
   si.SetBoolValue("GPU", "ThreadedPresentation", gpu_threaded_presentation);
   si.SetBoolValue("GPU", "UseSoftwareRendererForReadbacks", gpu_use_software_renderer_for_readbacks);
   si.SetBoolValue("GPU", "TrueColor", gpu_true_color);
@@ -80,6 +80,17 @@ struct Settings
   bool cpu_recompiler_memory_exceptions = false;
   bool cpu_recompiler_block_linking = true;
   bool cpu_recompiler_icache = false;
+  bool cpu_recompiler_block_prewarm = false;
+  u32 cpu_recompiler_promotion_threshold = 0;
+  bool cpu_recompiler_superblocks = false;
+  bool cpu_recompiler_optimize_blocks = false;
+  bool cpu_recompiler_async_compile = false;
+  bool cpu_recompiler_inline_gte = false;
+  bool cpu_recompiler_pinned_registers = false;
+  bool cpu_recompiler_lazy_downcount = false;
+  bool cpu_recompiler_perf_map = false;
+  bool cpu_idle_loop_skipping = false;
+  bool cpu_cached_interpreter_predecode = false;
   CPUFastmemMode cpu_fastmem_mode = CPUFastmemMode::Disabled;
 
   float emulation_speed = 1.0f;
@@ -110,6 +121,7 @@ struct Settings
   u32 gpu_resolution_scale = 1;
   u32 gpu_multisamples = 1;
   bool gpu_use_thread = true;
+  u32 gpu_sw_render_threads = 0;
   bool gpu_use_software_renderer_for_readbacks = false;
   bool gpu_threaded_presentation = true;
   bool gpu_use_debug_device = false;
@@ -1612,6 +1612,11 @@ void UpdatePerformanceCounters()
 
   Log_VerbosePrintf("FPS: %.2f VPS: %.2f Average: %.2fms Worst: %.2fms", s_fps, s_vps, s_average_frame_time,
                     s_worst_frame_time);
+  if (g_settings.cpu_idle_loop_skipping)
+  {
+    Log_VerbosePrintf("Idle loops skipped %d CPU ticks in the last frame",
+                      CPU::CodeCache::GetIdleLoopStats().frame_skipped_ticks);
+  }
 
   g_host_interface->OnSystemPerformanceCountersUpdated();
 }
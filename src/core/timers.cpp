@@ -1,6 +1,7 @@
 #include "timers.h"
 #include "common/log.h"
 #include "common/state_wrapper.h"
+#include "cpu_core.h"
 #include "gpu.h"
 #include "interrupt_controller.h"
 #include "system.h"
@@ -191,6 +192,29 @@ void Timers::AddSysClkTicks(TickCount sysclk_ticks)
   UpdateSysClkEvent();
 }
 
+bool Timers::GetLazyCounterValue(u32 timer, u32* value) const
+{
+  const CounterState& cs = m_states[timer];
+  if (!cs.counting_enabled)
+  {
+    *value = cs.counter;
+    return true;
+  }
+
+  TickCount carry = m_syclk_ticks_carry;
+  TickCount ticks = System::UnscaleTicksToOverclock(m_sysclk_event->GetTicksSinceLastExecution(), &carry);
+  if (timer == 2 && cs.external_counting_enabled)
+    ticks = (ticks + static_cast<TickCount>(m_sysclk_div_8_carry)) / 8;
+
+  // reaching the target or overflowing has side effects, so leave those to the event
+  const u32 counter = cs.counter + static_cast<u32>(ticks);
+  if ((counter >= cs.target && (cs.counter < cs.target || cs.target == 0)) || counter >= 0xFFFF)
+    return false;
+
+  *value = counter;
+  return true;
+}
+
 u32 Timers::ReadRegister(u32 offset)
 {
   const u32 timer_index = (offset >> 4) & u32(0x03);
@@ -214,6 +238,15 @@ u32 Timers::ReadRegister(u32 offset)
           g_gpu->SynchronizeCRTC();
       }
 
+      else if (g_settings.cpu_recompiler_lazy_downcount && g_settings.IsUsingRecompiler() && !CPU::g_using_interpreter)
+      {
+        // avoid running the event just to read the counter, unless it is about to fire an interrupt
+        // only done when running recompiled code, so the setting has no effect on the interpreters
+        u32 value;
+        if (GetLazyCounterValue(timer_index, &value))
+          return value;
+      }
+
       m_sysclk_event->InvokeEarly();
 
       return cs.counter;
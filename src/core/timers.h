@@ -90,6 +90,10 @@ private:
 
   void AddSysClkTicks(TickCount sysclk_ticks);
 
+  /// Computes the current counter value without running the sysclk event. Returns false if the counter would reach
+  /// its target or overflow, in which case the event has to run.
+  bool GetLazyCounterValue(u32 timer, u32* value) const;
+
   TickCount GetTicksUntilNextInterrupt() const;
   void UpdateSysClkEvent();
 
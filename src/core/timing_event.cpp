@@ -5,15 +5,19 @@
 #include "cpu_core.h"
 #include "cpu_core_private.h"
 #include "system.h"
+#include <algorithm>
 Log_SetChannel(TimingEvents);
 
 namespace TimingEvents {
 
-static TimingEvent* s_active_events_head;
-static TimingEvent* s_active_events_tail;
+// Active events are kept in a binary min-heap ordered by downcount, so rescheduling is O(log n) instead of walking a
+// list. s_active_events_head always points to the root, since the dispatchers read its downcount directly.
+static std::vector<TimingEvent*> s_active_events;
+static TimingEvent* s_active_events_head = nullptr;
 static TimingEvent* s_current_event = nullptr;
 static u32 s_active_event_count = 0;
 static u32 s_global_tick_counter = 0;
+static u64 s_schedule_order = 0;
 
 u32 GetGlobalTickCounter()
 {
@@ -33,6 +37,8 @@ void Reset()
 void Shutdown()
 {
   Assert(s_active_event_count == 0);
+  s_active_events = {};
+  s_active_events_head = nullptr;
 }
 
 std::unique_ptr<TimingEvent> CreateTimingEvent(std::string name, TickCount period, TickCount interval,
@@ -59,197 +65,135 @@ TimingEvent** GetHeadEventPtr()
   return &s_active_events_head;
 }
 
-static void SortEvent(TimingEvent* event)
+static ALWAYS_INLINE bool CompareEvents(const TimingEvent* lhs, const TimingEvent* rhs)
 {
-  const TickCount event_downcount = event->m_downcount;
+  return (lhs->m_downcount < rhs->m_downcount ||
+          (lhs->m_downcount == rhs->m_downcount && lhs->m_schedule_order < rhs->m_schedule_order));
+}
 
-  if (event->prev && event->prev->m_downcount > event_downcount)
+static ALWAYS_INLINE void SetHeapEvent(u32 index, TimingEvent* event)
+{
+  s_active_events[index] = event;
+  event->m_heap_index = index;
+}
+
+static void SiftUp(u32 index)
+{
+  TimingEvent* event = s_active_events[index];
+  while (index > 0)
   {
-    // move backwards
-    TimingEvent* current = event->prev;
-    while (current && current->m_downcount > event_downcount)
-      current = current->prev;
-
-    // unlink
-    if (event->prev)
-      event->prev->next = event->next;
-    else
-      s_active_events_head = event->next;
-    if (event->next)
-      event->next->prev = event->prev;
-    else
-      s_active_events_tail = event->prev;
+    const u32 parent = (index - 1) / 2;
+    if (!CompareEvents(event, s_active_events[parent]))
+      break;
 
-    // insert after current
-    if (current)
-    {
-      event->next = current->next;
-      if (current->next)
-        current->next->prev = event;
-      else
-        s_active_events_tail = event;
-
-      event->prev = current;
-      current->next = event;
-    }
-    else
-    {
-      // insert at front
-      DebugAssert(s_active_events_head);
-      s_active_events_head->prev = event;
-      event->prev = nullptr;
-      event->next = s_active_events_head;
-      s_active_events_head = event;
-      UpdateCPUDowncount();
-    }
+    SetHeapEvent(index, s_active_events[parent]);
+    index = parent;
   }
-  else if (event->next && event_downcount > event->next->m_downcount)
+
+  SetHeapEvent(index, event);
+}
+
+static void SiftDown(u32 index)
+{
+  TimingEvent* event = s_active_events[index];
+  for (;;)
   {
-    // move forwards
-    TimingEvent* current = event->next;
-    while (current && event_downcount > current->m_downcount)
-      current = current->next;
-
-    // unlink
-    if (event->prev)
-      event->prev->next = event->next;
-    else
-      s_active_events_head = event->next;
-    if (event->next)
-      event->next->prev = event->prev;
-    else
-      s_active_events_tail = event->prev;
+    const u32 left = index * 2 + 1;
+    if (left >= s_active_event_count)
+      break;
+
+    const u32 right = left + 1;
+    const u32 child =
+      (right < s_active_event_count && CompareEvents(s_active_events[right], s_active_events[left])) ? right : left;
+    if (!CompareEvents(s_active_events[child], event))
+      break;
+
+    SetHeapEvent(index, s_active_events[child]);
+    index = child;
+  }
 
-    // insert before current
-    if (current)
-    {
-      event->next = current;
-      event->prev = current->prev;
+  SetHeapEvent(index, event);
+}
 
-      if (current->prev)
-        current->prev->next = event;
-      else
-        s_active_events_head = event;
+static void UpdateHead()
+{
+  s_active_events_head = (s_active_event_count > 0) ? s_active_events[0] : nullptr;
 
-      current->prev = event;
-    }
-    else
-    {
-      // insert at back
-      DebugAssert(s_active_events_tail);
-      s_active_events_tail->next = event;
-      event->next = nullptr;
-      event->prev = s_active_events_tail;
-      s_active_events_tail = event;
-    }
-  }
+  // RunEvents() updates the downcount once it's done
+  if (s_active_events_head && !s_current_event)
+    UpdateCPUDowncount();
+}
+
+static void SortEvent(TimingEvent* event)
+{
+  // downcount changed, so it's a newer schedule
+  event->m_schedule_order = s_schedule_order++;
+
+  const u32 index = event->m_heap_index;
+  DebugAssert(index < s_active_event_count && s_active_events[index] == event);
+  if (index > 0 && CompareEvents(event, s_active_events[(index - 1) / 2]))
+    SiftUp(index);
+  else
+    SiftDown(index);
+
+  if (index == 0 || event->m_heap_index == 0)
+    UpdateHead();
 }
 
 static void AddActiveEvent(TimingEvent* event)
 {
-  DebugAssert(!event->prev && !event->next);
-  s_active_event_count++;
+  event->m_schedule_order = s_schedule_order++;
 
-  TimingEvent* current = nullptr;
-  TimingEvent* next = s_active_events_head;
-  while (next && event->m_downcount > next->m_downcount)
-  {
-    current = next;
-    next = next->next;
-  }
+  const u32 index = s_active_event_count++;
+  if (index == s_active_events.size())
+    s_active_events.push_back(event);
 
-  if (!next)
-  {
-    // new tail
-    event->prev = s_active_events_tail;
-    if (s_active_events_tail)
-    {
-      s_active_events_tail->next = event;
-      s_active_events_tail = event;
-    }
-    else
-    {
-      // first event
-      s_active_events_tail = event;
-      s_active_events_head = event;
-      UpdateCPUDowncount();
-    }
-  }
-  else if (!current)
-  {
-    // new head
-    event->next = s_active_events_head;
-    s_active_events_head->prev = event;
-    s_active_events_head = event;
-    UpdateCPUDowncount();
-  }
-  else
-  {
-    // inbetween current < event > next
-    event->prev = current;
-    event->next = next;
-    current->next = event;
-    next->prev = event;
-  }
+  SetHeapEvent(index, event);
+  SiftUp(index);
+
+  if (event->m_heap_index == 0)
+    UpdateHead();
 }
 
 static void RemoveActiveEvent(TimingEvent* event)
 {
   DebugAssert(s_active_event_count > 0);
 
-  if (event->next)
-  {
-    event->next->prev = event->prev;
-  }
-  else
-  {
-    s_active_events_tail = event->prev;
-  }
+  const u32 index = event->m_heap_index;
+  DebugAssert(index < s_active_event_count && s_active_events[index] == event);
 
-  if (event->prev)
+  // move the last event into the hole and let it find its place
+  const u32 last = --s_active_event_count;
+  if (index != last)
   {
-    event->prev->next = event->next;
-  }
-  else
-  {
-    s_active_events_head = event->next;
-    if (s_active_events_head)
-      UpdateCPUDowncount();
+    TimingEvent* moved = s_active_events[last];
+    SetHeapEvent(index, moved);
+    if (index > 0 && CompareEvents(moved, s_active_events[(index - 1) / 2]))
+      SiftUp(index);
+    else
+      SiftDown(index);
   }
 
-  event->prev = nullptr;
-  event->next = nullptr;
+  s_active_events[last] = nullptr;
+  event->m_heap_index = 0;
 
-  s_active_event_count--;
+  if (index == 0)
+    UpdateHead();
 }
 
 static void SortEvents()
 {
-  std::vector<TimingEvent*> events;
-  events.reserve(s_active_event_count);
+  for (u32 i = 0; i < s_active_event_count; i++)
+    SiftUp(i);
 
-  TimingEvent* next = s_active_events_head;
-  while (next)
-  {
-    TimingEvent* current = next;
-    events.push_back(current);
-    next = current->next;
-    current->prev = nullptr;
-    current->next = nullptr;
-  }
-
-  s_active_events_head = nullptr;
-  s_active_events_tail = nullptr;
-  s_active_event_count = 0;
-
-  for (TimingEvent* event : events)
-    AddActiveEvent(event);
+  UpdateHead();
 }
 
 static TimingEvent* FindActiveEvent(const char* name)
 {
-  for (TimingEvent* event = s_active_events_head; event; event = event->next)
+  for (u32 i = 0; i < s_active_event_count; i++)
   {
+    TimingEvent* event = s_active_events[i];
     if (event->GetName().compare(name) == 0)
       return event;
   }
@@ -271,8 +215,10 @@ void RunEvents()
 
     // Apply downcount to all events.
     // This will result in a negative downcount for those events which are late.
-    for (TimingEvent* event = s_active_events_head; event; event = event->next)
+    // Subtracting the same amount from every event doesn't change the heap order.
+    for (u32 i = 0; i < s_active_event_count; i++)
     {
+      TimingEvent* event = s_active_events[i];
       event->m_downcount -= time;
       event->m_time_since_last_run += time;
     }
@@ -280,7 +226,6 @@ void RunEvents()
     // Now we can actually run the callbacks.
     while (s_active_events_head->m_downcount <= 0)
     {
-      // move it to the end, since that'll likely be its new position
       TimingEvent* event = s_active_events_head;
       s_current_event = event;
 
@@ -290,10 +235,12 @@ void RunEvents()
       event->m_downcount += event->m_interval;
       event->m_time_since_last_run = 0;
 
+      // Move it to its new position before running the callback, so the heap is consistent if the callback
+      // reschedules or deactivates this or any other event.
+      SortEvent(event);
+
       // The cycles_late is only an indicator, it doesn't modify the cycles to execute.
       event->m_callback(event->m_callback_param, ticks_to_execute, ticks_late);
-      if (event->m_active)
-        SortEvent(event);
     }
   }
 
@@ -332,10 +279,12 @@ bool DoState(StateWrapper& sw)
       }
 
       // Using reschedule is safe here since we call sort afterwards.
+      // Events are saved in execution order, so ties are broken the same way after loading.
       event->m_downcount = downcount;
       event->m_time_since_last_run = time_since_last_run;
       event->m_period = period;
       event->m_interval = interval;
+      event->m_schedule_order = s_schedule_order++;
     }
 
     if (sw.GetVersion() < 43)
@@ -349,10 +298,13 @@ bool DoState(StateWrapper& sw)
   }
   else
   {
+    // Write the events in the order they will execute.
+    std::vector<TimingEvent*> events(s_active_events.begin(), s_active_events.begin() + s_active_event_count);
+    std::sort(events.begin(), events.end(), CompareEvents);
 
     sw.Do(&s_active_event_count);
 
-    for (TimingEvent* event = s_active_events_head; event; event = event->next)
+    for (TimingEvent* event : events)
     {
       sw.Do(&event->m_name);
       sw.Do(&event->m_downcount);
@@ -421,9 +373,7 @@ void TimingEvent::Schedule(TickCount ticks)
   else
   {
     // Event is already active, so we leave the time since last run alone, and just modify the downcount.
-    // If this is a call from an IO handler for example, re-sort the event queue.
-    if (TimingEvents::s_current_event != this)
-      TimingEvents::SortEvent(this);
+    TimingEvents::SortEvent(this);
   }
 }
 
@@ -447,8 +397,7 @@ void TimingEvent::Reset()
 
   m_downcount = m_interval;
   m_time_since_last_run = 0;
-  if (TimingEvents::s_current_event != this)
-    TimingEvents::SortEvent(this);
+  TimingEvents::SortEvent(this);
 }
 
 void TimingEvent::InvokeEarly(bool force /* = false */)
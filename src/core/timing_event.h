@@ -60,8 +60,8 @@ public:
   void SetInterval(TickCount interval) { m_interval = interval; }
   void SetPeriod(TickCount period) { m_period = period; }
 
-  TimingEvent* prev = nullptr;
-  TimingEvent* next = nullptr;
+  u32 m_heap_index = 0;      // position in the active event heap
+  u64 m_schedule_order = 0;  // breaks ties between events with the same downcount, earlier schedules run first
 
   TimingEventCallback m_callback;
   void* m_callback_param;
@@ -223,6 +223,28 @@ AdvancedSettingsWidget::AdvancedSettingsWidget(QtHostInterface* host_interface,
                        static_cast<u32>(CPUFastmemMode::Count), Settings::DEFAULT_CPU_FASTMEM_MODE);
   addBooleanTweakOption(m_host_interface, m_ui.tweakOptionTable, tr("Enable Recompiler ICache"), "CPU",
                         "RecompilerICache", false);
+  addBooleanTweakOption(m_host_interface, m_ui.tweakOptionTable, tr("Enable Recompiler Block Prewarming"), "CPU",
+                        "RecompilerBlockPrewarm", false);
+  addIntRangeTweakOption(m_host_interface, m_ui.tweakOptionTable, tr("Recompiler Block Promotion Threshold"), "CPU",
+                         "RecompilerPromotionThreshold", 0, 10000, 0);
+  addBooleanTweakOption(m_host_interface, m_ui.tweakOptionTable, tr("Enable Recompiler Superblocks"), "CPU",
+                        "RecompilerSuperblocks", false);
+  addBooleanTweakOption(m_host_interface, m_ui.tweakOptionTable, tr("Enable Recompiler Block Optimization"), "CPU",
+                        "RecompilerOptimizeBlocks", false);
+  addBooleanTweakOption(m_host_interface, m_ui.tweakOptionTable, tr("Enable Recompiler Background Compilation"), "CPU",
+                        "RecompilerAsyncCompile", false);
+  addBooleanTweakOption(m_host_interface, m_ui.tweakOptionTable, tr("Enable Recompiler Inline GTE Commands"), "CPU",
+                        "RecompilerInlineGTE", false);
+  addBooleanTweakOption(m_host_interface, m_ui.tweakOptionTable, tr("Enable Recompiler Pinned Registers"), "CPU",
+                        "RecompilerPinnedRegisters", false);
+  addBooleanTweakOption(m_host_interface, m_ui.tweakOptionTable, tr("Enable Lazy Downcount Checks"), "CPU",
+                        "RecompilerLazyDowncount", false);
+  addBooleanTweakOption(m_host_interface, m_ui.tweakOptionTable, tr("Write Recompiler Symbols For perf"), "CPU",
+                        "RecompilerPerfMap", false);
+  addBooleanTweakOption(m_host_interface, m_ui.tweakOptionTable, tr("Enable Idle Loop Skipping"), "CPU",
+                        "IdleLoopSkipping", false);
+  addBooleanTweakOption(m_host_interface, m_ui.tweakOptionTable, tr("Enable Cached Interpreter Predecoding"), "CPU",
+                        "CachedInterpreterPredecode", false);
 
   addBooleanTweakOption(m_host_interface, m_ui.tweakOptionTable, tr("Enable VRAM Write Texture Replacement"),
                         "TextureReplacements", "EnableVRAMWriteReplacements", false);
@@ -247,6 +269,8 @@ AdvancedSettingsWidget::AdvancedSettingsWidget(QtHostInterface* host_interface,
                          Settings::DEFAULT_GPU_FIFO_SIZE);
   addIntRangeTweakOption(m_host_interface, m_ui.tweakOptionTable, tr("GPU Max Run-Ahead"), "Hacks", "GPUMaxRunAhead", 0,
                          1000, Settings::DEFAULT_GPU_MAX_RUN_AHEAD);
+  addIntRangeTweakOption(m_host_interface, m_ui.tweakOptionTable, tr("Software Renderer Band Threads"), "GPU",
+                         "SoftwareRenderThreads", 0, 32, 0);
   addBooleanTweakOption(m_host_interface, m_ui.tweakOptionTable, tr("Use Debug Host GPU Device"), "GPU",
                         "UseDebugDevice", false);
 
@@ -293,6 +317,17 @@ void AdvancedSettingsWidget::onResetToDefaultClicked()
   setBooleanTweakOption(m_ui.tweakOptionTable, i++, true);                              // Recompiler block linking
   setChoiceTweakOption(m_ui.tweakOptionTable, i++, Settings::DEFAULT_CPU_FASTMEM_MODE); // Recompiler fastmem mode
   setBooleanTweakOption(m_ui.tweakOptionTable, i++, false);                             // Recompiler Icache
+  setBooleanTweakOption(m_ui.tweakOptionTable, i++, false);                             // Recompiler block cache
+  setIntRangeTweakOption(m_ui.tweakOptionTable, i++, 0);                                // Recompiler promotion threshold
+  setBooleanTweakOption(m_ui.tweakOptionTable, i++, false);                             // Recompiler superblocks
+  setBooleanTweakOption(m_ui.tweakOptionTable, i++, false);                             // Recompiler block optimization
+  setBooleanTweakOption(m_ui.tweakOptionTable, i++, false);                             // Recompiler async compile
+  setBooleanTweakOption(m_ui.tweakOptionTable, i++, false);                             // Recompiler inline GTE
+  setBooleanTweakOption(m_ui.tweakOptionTable, i++, false);                             // Recompiler pinned registers
+  setBooleanTweakOption(m_ui.tweakOptionTable, i++, false);                             // Lazy downcount checks
+  setBooleanTweakOption(m_ui.tweakOptionTable, i++, false);                             // Recompiler perf map
+  setBooleanTweakOption(m_ui.tweakOptionTable, i++, false);                             // Idle loop skipping
+  setBooleanTweakOption(m_ui.tweakOptionTable, i++, false);                             // Cached interpreter predecode
   setBooleanTweakOption(m_ui.tweakOptionTable, i++, false); // VRAM write texture replacement
   setBooleanTweakOption(m_ui.tweakOptionTable, i++, false); // Preload texture replacements
   setBooleanTweakOption(m_ui.tweakOptionTable, i++, false); // Dump replacable VRAM writes
@@ -309,6 +344,7 @@ void AdvancedSettingsWidget::onResetToDefaultClicked()
                          static_cast<int>(Settings::DEFAULT_GPU_FIFO_SIZE)); // GPU FIFO size
   setIntRangeTweakOption(m_ui.tweakOptionTable, i++,
                          static_cast<int>(Settings::DEFAULT_GPU_MAX_RUN_AHEAD)); // GPU max run-ahead
+  setIntRangeTweakOption(m_ui.tweakOptionTable, i++, 0);                         // Software renderer band threads
   setBooleanTweakOption(m_ui.tweakOptionTable, i++, false);                      // Use debug host GPU device
   setBooleanTweakOption(m_ui.tweakOptionTable, i++, true);                       // Increase timer resolution
   setBooleanTweakOption(m_ui.tweakOptionTable, i++, false);                      // Allow booting without SBI file
@@ -1,5 +1,6 @@
 #include "debuggerwindow.h"
 #include "core/cpu_core_private.h"
+#include "core/cpu_profiler.h"
 #include "debuggermodels.h"
 #include "qthostinterface.h"
 #include "qtutils.h"
@@ -137,6 +138,26 @@ void DebuggerWindow::onTraceTriggered()
   }
 }
 
+void DebuggerWindow::onProfileTriggered()
+{
+  QtHostInterface* hi = QtHostInterface::GetInstance();
+  if (!m_ui.actionProfile->isChecked())
+  {
+    QString path;
+    hi->executeOnEmulationThread(
+      [&path]() {
+        CPU::Profiler::Stop();
+        path = QString::fromStdString(CPU::Profiler::GetProfilePath());
+      },
+      true);
+    QMessageBox::information(this, windowTitle(), tr("Profile written to %1.").arg(path));
+  }
+  else
+  {
+    hi->executeOnEmulationThread([]() { CPU::Profiler::Start(); }, true);
+  }
+}
+
 void DebuggerWindow::onFollowAddressTriggered()
 {
   //
@@ -389,6 +410,7 @@ void DebuggerWindow::connectSignals()
   connect(m_ui.actionGoToAddress, &QAction::triggered, this, &DebuggerWindow::onGoToAddressTriggered);
   connect(m_ui.actionDumpAddress, &QAction::triggered, this, &DebuggerWindow::onDumpAddressTriggered);
   connect(m_ui.actionTrace, &QAction::triggered, this, &DebuggerWindow::onTraceTriggered);
+  connect(m_ui.actionProfile, &QAction::triggered, this, &DebuggerWindow::onProfileTriggered);
   connect(m_ui.actionStepInto, &QAction::triggered, this, &DebuggerWindow::onStepIntoActionTriggered);
   connect(m_ui.actionStepOver, &QAction::triggered, this, &DebuggerWindow::onStepOverActionTriggered);
   connect(m_ui.actionStepOut, &QAction::triggered, this, &DebuggerWindow::onStepOutActionTriggered);
@@ -457,6 +479,7 @@ void DebuggerWindow::setUIEnabled(bool enabled)
   m_ui.actionGoToAddress->setEnabled(enabled);
   m_ui.actionGoToPC->setEnabled(enabled);
   m_ui.actionTrace->setEnabled(enabled);
+  m_ui.actionProfile->setEnabled(enabled);
   m_ui.memoryRegionRAM->setEnabled(enabled);
   m_ui.memoryRegionEXP1->setEnabled(enabled);
   m_ui.memoryRegionScratchpad->setEnabled(enabled);
@@ -44,6 +44,7 @@ private Q_SLOTS:
   void onDumpAddressTriggered();
   void onFollowAddressTriggered();
   void onTraceTriggered();  
+  void onProfileTriggered();
   void onAddBreakpointTriggered();
   void onToggleBreakpointTriggered();
   void onClearBreakpointsTriggered();
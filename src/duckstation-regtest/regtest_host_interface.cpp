@@ -5,12 +5,17 @@
 #include "common/file_system.h"
 #include "common/log.h"
 #include "common/string_util.h"
+#include "common/timer.h"
+#include "core/cpu_code_cache.h"
+#include "core/cpu_core.h"
 #include "core/system.h"
+#include "core/timing_event.h"
 #include "frontend-common/game_database.h"
 #include "frontend-common/game_settings.h"
 #include "regtest_host_display.h"
 #include "scmversion/scmversion.h"
 #include <cstdio>
+#include <random>
 Log_SetChannel(RegTestHostInterface);
 
 #ifdef _WIN32
@@ -23,6 +28,8 @@ Log_SetChannel(RegTestHostInterface);
 
 static int s_frames_to_run = 60 * 60;
 static int s_frame_dump_interval = 0;
+static int s_gte_inline_test_iterations = 0;
+static int s_event_benchmark_events = 0;
 static std::shared_ptr<SystemBootParameters> s_boot_parameters;
 static std::string s_dump_base_directory;
 static std::string s_dump_game_directory;
@@ -314,6 +321,9 @@ static void PrintCommandLineHelp(const char* progname)
   std::fprintf(stderr, "  -frames: Sets the number of frames to execute.\n");
   std::fprintf(stderr, "  -log <level>: Sets the log level. Defaults to verbose.\n");
   std::fprintf(stderr, "  -renderer <renderer>: Sets the graphics renderer. Default to software.\n");
+  std::fprintf(stderr, "  -gteinlinetest <iterations>: Compares the recompiler's inline GTE code with the GTE and\n"
+                       "    exits.\n");
+  std::fprintf(stderr, "  -eventbench <events>: Times the event queue with this many active events and exits.\n");
   std::fprintf(stderr, "  --: Signals that no more arguments will follow and the remaining\n"
                        "    parameters make up the filename. Use when the filename contains\n"
                        "    spaces or starts with a dash.\n");
@@ -402,6 +412,28 @@ static bool ParseCommandLineArgs(int argc, char* argv[])
         s_renderer_to_use = renderer.value();
         continue;
       }
+      else if (CHECK_ARG_PARAM("-gteinlinetest"))
+      {
+        s_gte_inline_test_iterations = StringUtil::FromChars<int>(argv[++i]).value_or(0);
+        if (s_gte_inline_test_iterations <= 0)
+        {
+          Log_ErrorPrintf("Invalid GTE test iteration count specified: %d", s_gte_inline_test_iterations);
+          return false;
+        }
+
+        continue;
+      }
+      else if (CHECK_ARG_PARAM("-eventbench"))
+      {
+        s_event_benchmark_events = StringUtil::FromChars<int>(argv[++i]).value_or(0);
+        if (s_event_benchmark_events <= 0)
+        {
+          Log_ErrorPrintf("Invalid event count specified: %d", s_event_benchmark_events);
+          return false;
+        }
+
+        continue;
+      }
       else if (CHECK_ARG("--"))
       {
         no_more_args = true;
@@ -431,6 +463,46 @@ static std::string GetFrameDumpFilename(int frame)
                                          frame);
 }
 
+static void RunEventBenchmark(u32 num_events, u32 iterations, u32 seed)
+{
+  // Random reschedules, running the events whenever the head is due. The schedule is drawn as it goes rather than
+  // stored, so the RNG is part of the timing, but it costs the same for any queue implementation.
+  std::mt19937 rng(seed);
+  std::vector<std::unique_ptr<TimingEvent>> events;
+  events.reserve(num_events);
+  for (u32 i = 0; i < num_events; i++)
+  {
+    const TickCount period = 100 + static_cast<TickCount>(rng() % 5000);
+    events.push_back(TimingEvents::CreateTimingEvent(StringUtil::StdStringFromFormat("Benchmark %u", i), period,
+                                                     period, [](void*, TickCount, TickCount) {}, nullptr, true));
+  }
+
+  TimingEvent* const* head = TimingEvents::GetHeadEventPtr();
+  CPU::ResetPendingTicks();
+  u32 runs = 0;
+  Common::Timer timer;
+  for (u32 i = 0; i < iterations; i++)
+  {
+    CPU::AddPendingTicks(1 + static_cast<TickCount>(rng() & 63));
+
+    const u32 value = rng();
+    if ((value & 7) == 0)
+      events[((value >> 8) & 0xFF) % num_events]->Schedule(1 + static_cast<TickCount>((value >> 16) & 4095));
+
+    if (CPU::GetPendingTicks() >= (*head)->GetDowncount())
+    {
+      TimingEvents::RunEvents();
+      runs++;
+    }
+  }
+
+  Log_InfoPrintf("%u events, %u iterations: %.1f ms, %u event runs", num_events, iterations,
+                 timer.GetTimeMilliseconds(), runs);
+
+  events.clear();
+  CPU::ResetPendingTicks();
+}
+
 int main(int argc, char* argv[])
 {
   Log::SetConsoleOutputParams(true, nullptr, LOGLEVEL_VERBOSE);
@@ -438,6 +510,25 @@ int main(int argc, char* argv[])
   if (!ParseCommandLineArgs(argc, argv))
     return -1;
 
+  if (s_gte_inline_test_iterations > 0)
+  {
+#ifdef WITH_RECOMPILER
+    const u32 iterations = static_cast<u32>(s_gte_inline_test_iterations);
+    return (CPU::CodeCache::CompareInlineGTEInstructions(iterations, 0) == 0) ? 0 : -1;
+#else
+    Log_ErrorPrintf("The recompiler is not available in this build.");
+    return -1;
+#endif
+  }
+
+  if (s_event_benchmark_events > 0)
+  {
+    TimingEvents::Initialize();
+    RunEventBenchmark(static_cast<u32>(s_event_benchmark_events), 20000000, 0);
+    TimingEvents::Shutdown();
+    return 0;
+  }
+
   int result = -1;
 
   Log_InfoPrintf("Initializing...");
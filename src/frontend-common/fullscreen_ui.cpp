@@ -14,6 +14,7 @@
 #include "controller_interface.h"
 #include "core/cheats.h"
 #include "core/cpu_core.h"
+#include "core/cpu_profiler.h"
 #include "core/gpu.h"
 #include "core/host_display.h"
 #include "core/host_interface_progress_callback.h"
@@ -2116,6 +2117,9 @@ void DrawSettingsWindow()
             settings_changed |= ToggleButton("Threaded Rendering",
                                              "Uses a second thread for drawing graphics. Speed boost, and safe to use.",
                                              &s_settings_copy.gpu_use_thread);
+            settings_changed |= RangeButton(
+              "Band Threads", "Splits the drawing area between this many threads. Disabled when set to less than 2.",
+              reinterpret_cast<s32*>(&s_settings_copy.gpu_sw_render_threads), 0, 32, 1, "%d Threads");
           }
           break;
 
@@ -2575,6 +2579,38 @@ void DrawSettingsWindow()
           "Enable Recompiler Block Linking",
           "Performance enhancement - jumps directly between blocks instead of returning to the dispatcher.",
           &s_settings_copy.cpu_recompiler_block_linking);
+        settings_changed |= ToggleButton(
+          "Enable Recompiler Block Prewarming",
+          "Remembers which blocks each game uses, and compiles them ahead of time on the next boot to reduce stutter.",
+          &s_settings_copy.cpu_recompiler_block_prewarm);
+        settings_changed |= ToggleButton(
+          "Enable Recompiler Superblocks",
+          "Follows unconditional jumps when forming blocks, so loop bodies are compiled as a single block.",
+          &s_settings_copy.cpu_recompiler_superblocks);
+        settings_changed |= ToggleButton(
+          "Enable Recompiler Background Compilation",
+          "Compiles new blocks on a worker thread while they run in the interpreter, reducing stutter in new areas.",
+          &s_settings_copy.cpu_recompiler_async_compile);
+        settings_changed |= ToggleButton(
+          "Enable Recompiler Inline GTE Commands",
+          "Generates code for short GTE commands such as NCLIP and AVSZ3 instead of calling the GTE.",
+          &s_settings_copy.cpu_recompiler_inline_gte);
+        settings_changed |= ToggleButton(
+          "Enable Recompiler Pinned Registers",
+          "Keeps frequently used guest registers in host registers across linked blocks instead of writing them back.",
+          &s_settings_copy.cpu_recompiler_pinned_registers);
+        settings_changed |= ToggleButton(
+          "Enable Lazy Downcount Checks",
+          "Only checks for pending events at backward branches and I/O accesses. May reduce timing accuracy.",
+          &s_settings_copy.cpu_recompiler_lazy_downcount);
+        settings_changed |= ToggleButton(
+          "Enable Idle Loop Skipping",
+          "Skips ahead to the next event when the CPU is spinning in a loop which polls memory or hardware.",
+          &s_settings_copy.cpu_idle_loop_skipping);
+        settings_changed |= ToggleButton(
+          "Enable Cached Interpreter Predecoding",
+          "Decodes instructions once per block instead of on every execution, speeding up the cached interpreter.",
+          &s_settings_copy.cpu_cached_interpreter_predecode);
         settings_changed |= EnumChoiceButton("Recompiler Fast Memory Access",
                                              "Avoids calls to C++ code, significantly speeding up the recompiler.",
                                              &s_settings_copy.cpu_fastmem_mode, &Settings::GetCPUFastmemModeDisplayName,
@@ -4034,6 +4070,20 @@ void DrawDebugDebugMenu()
       CPU::StopTrace();
   }
 
+  if (ImGui::MenuItem("CPU Profiler", nullptr, CPU::Profiler::IsActive(), system_valid))
+  {
+    if (!CPU::Profiler::IsActive())
+    {
+      CPU::Profiler::Start();
+    }
+    else
+    {
+      CPU::Profiler::Stop();
+      s_host_interface->AddFormattedOSDMessage(10.0f, "Profile written to '%s'.",
+                                               CPU::Profiler::GetProfilePath().c_str());
+    }
+  }
+
   ImGui::Separator();
 
   settings_changed |= ImGui::MenuItem("Show VRAM", nullptr, &debug_settings.show_vram);